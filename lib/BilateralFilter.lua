@@ -1,6 +1,8 @@
 -- lib/BilateralFilter.lua
 -- バイラテラルフィルタ モジュール
 
+local FastPath = require('lib.FastPath')
+
 local M = {}
 
 -- デフォルトパラメータ
@@ -8,6 +10,13 @@ M.RADIUS = 5              -- フィルタ半径（大きいほど広範囲を平
 M.SIGMA_SPATIAL = 3.0     -- 空間の標準偏差
 M.SIGMA_COLOR = 0.15      -- 色の標準偏差 (0-1正規化、大きいほど異なる色も混合)
 
+-- 特徴量ガイド付きフィルタのデフォルトパラメータ
+-- AOV がエッジを保持するため、色の標準偏差を大きくしてノイズを強く平滑化できる
+M.GUIDED_SIGMA_COLOR = 0.6    -- 色の標準偏差
+M.SIGMA_NORMAL = 0.1          -- 法線の差 (1 - cosθ) の標準偏差
+M.SIGMA_DEPTH = 0.05          -- 相対深度差の標準偏差
+M.SIGMA_ALBEDO = 0.1          -- アルベドの差の標準偏差
+
 -- ガウス関数
 -- @param x 入力値
 -- @param sigma 標準偏差
@@ -32,8 +41,11 @@ function M.filter(data, x, y, params)
     local width = data:width()
     local height = data:height()
     
+    -- 近傍の読み取りが多いため get_pixel は高速パスを使う
+    local get_pixel = FastPath.method(data, "get_pixel")
+
     -- 中心ピクセルの色を取得
-    local cr, cg, cb = data:get_pixel(x, y)
+    local cr, cg, cb = get_pixel(data, x, y)
     cr, cg, cb = cr / 255, cg / 255, cb / 255
     
     local sum_r, sum_g, sum_b = 0, 0, 0
@@ -45,7 +57,7 @@ function M.filter(data, x, y, params)
             
             -- 境界チェック
             if nx >= 0 and nx < width and ny >= 0 and ny < height then
-                local nr, ng, nb = data:get_pixel(nx, ny)
+                local nr, ng, nb = get_pixel(data, nx, ny)
                 nr, ng, nb = nr / 255, ng / 255, nb / 255
                 
                 -- 空間重み（ピクセル間の距離に基づく）
@@ -81,4 +93,88 @@ function M.filter(data, x, y, params)
     end
 end
 
+-- 特徴量ガイド付きバイラテラルフィルタ（1ピクセル処理）
+-- 色の類似度に加え、AOV（法線・深度・アルベド・オブジェクトID）の類似度で重み付けする
+-- 別オブジェクトのピクセルは混合しないため、低サンプル数でもエッジやテクスチャを保ったままノイズを除去できる
+-- AOV が無効な場合は通常の filter にフォールバックする
+-- @param data AppDataインスタンス（フロントバッファとAOVから読み取る）
+-- @param x 処理対象のX座標
+-- @param y 処理対象のY座標
+-- @param params オプションパラメータ {radius, sigma_spatial, sigma_color, sigma_normal, sigma_depth, sigma_albedo}
+-- @return r, g, b フィルタ後のピクセル値 (0-255)
+function M.filter_guided(data, x, y, params)
+    if not data:has_aovs() then
+        return M.filter(data, x, y, params)
+    end
+
+    params = params or {}
+    local radius = params.radius or M.RADIUS
+    local sigma_spatial = params.sigma_spatial or M.SIGMA_SPATIAL
+    local sigma_color = params.sigma_color or M.GUIDED_SIGMA_COLOR
+    local sigma_normal = params.sigma_normal or M.SIGMA_NORMAL
+    local sigma_depth = params.sigma_depth or M.SIGMA_DEPTH
+    local sigma_albedo = params.sigma_albedo or M.SIGMA_ALBEDO
+
+    local width = data:width()
+    local height = data:height()
+    local gaussian = M.gaussian
+
+    local get_pixel = FastPath.method(data, "get_pixel")
+
+    -- 中心ピクセルの色と特徴量
+    local cr, cg, cb = get_pixel(data, x, y)
+    cr, cg, cb = cr / 255, cg / 255, cb / 255
+    local c_id = data:get_object_id(x, y)
+    local has_geometry = c_id >= 0
+    local cnx, cny, cnz = data:get_normal(x, y)
+    local c_depth = data:get_depth(x, y)
+    local car, cag, cab = data:get_albedo(x, y)
+    local depth_scale = c_depth > 0 and 1 / c_depth or 0
+
+    local sum_r, sum_g, sum_b = 0, 0, 0
+    local weight_sum = 0
+
+    for dy = -radius, radius do
+        for dx = -radius, radius do
+            local nx, ny = x + dx, y + dy
+
+            -- 境界チェック、異なるオブジェクトは混合しない
+            if nx >= 0 and nx < width and ny >= 0 and ny < height and data:get_object_id(nx, ny) == c_id then
+                local nr, ng, nb = get_pixel(data, nx, ny)
+                nr, ng, nb = nr / 255, ng / 255, nb / 255
+
+                local spatial_weight = gaussian(math.sqrt(dx * dx + dy * dy), sigma_spatial)
+                local color_weight = gaussian(math.sqrt((nr - cr)^2 + (ng - cg)^2 + (nb - cb)^2), sigma_color)
+                local weight = spatial_weight * color_weight
+
+                -- 背景（ヒットなし）は特徴量を持たないため色と距離のみで重み付けする
+                if has_geometry then
+                    -- 法線の向きの差
+                    local nnx, nny, nnz = data:get_normal(nx, ny)
+                    local normal_diff = 1 - (cnx * nnx + cny * nny + cnz * nnz)
+                    weight = weight * gaussian(math.max(normal_diff, 0), sigma_normal)
+
+                    -- 中心の深度に対する相対的な深度差
+                    weight = weight * gaussian((data:get_depth(nx, ny) - c_depth) * depth_scale, sigma_depth)
+
+                    -- アルベドの差（テクスチャや色の境界を保持）
+                    local nar, nag, nab = data:get_albedo(nx, ny)
+                    weight = weight * gaussian(math.sqrt((nar - car)^2 + (nag - cag)^2 + (nab - cab)^2), sigma_albedo)
+                end
+
+                sum_r = sum_r + nr * weight
+                sum_g = sum_g + ng * weight
+                sum_b = sum_b + nb * weight
+                weight_sum = weight_sum + weight
+            end
+        end
+    end
+
+    -- 中心ピクセル自身の重みは常に正なので weight_sum > 0
+    return
+        math.floor((sum_r / weight_sum) * 255 + 0.5),
+        math.floor((sum_g / weight_sum) * 255 + 0.5),
+        math.floor((sum_b / weight_sum) * 255 + 0.5)
+end
+
 return M
@@ -1,8 +1,6 @@
 -- BlockUtils.lua
 -- ブロック分割と移動平均計算のユーティリティモジュール
 
-local json = require("lib.json")
-
 local BlockUtils = {}
 
 -- ========================================
@@ -139,46 +137,117 @@ function BlockUtils.shuffle_blocks(blocks, seed)
 end
 
 -- ========================================
--- 共有キュー（排他的pull方式）
+-- 共有キュー（ネイティブのワークスティーリング方式）
 -- ========================================
 
+-- 共有キューの1ブロックあたりの要素数 [x, y, w, h]
+BlockUtils.QUEUE_STRIDE = 4
+
 --- 共有ブロックキューをセットアップする
---- ブロック配列をJSONでAppDataに保存し、インデックスを0に初期化
+--- ブロック配列をネイティブのタイルスケジューラに渡し、num_queues 個のワーカー別キューに分配する
 --- @param app_data userdata AppDataインスタンス
 --- @param blocks table ブロックの配列
---- @param queue_key string キュー（ブロック配列）のキー
---- @param index_key string|nil インデックスのキー（省略時はqueue_key.."_idx"）
-function BlockUtils.setup_shared_queue(app_data, blocks, queue_key, index_key)
-    index_key = index_key or (queue_key .. "_idx")
-    
-    -- ブロック配列をJSONで保存
-    app_data:set_string(queue_key, json.encode(blocks))
-    -- インデックスを0にリセット
-    app_data:set_string(index_key, "0")
+--- @param queue_key string キューの名前
+--- @param num_queues number|nil ワーカー別キューの数（省略時は1）
+function BlockUtils.setup_shared_queue(app_data, blocks, queue_key, num_queues)
+    app_data:setup_tiles(queue_key, BlockUtils.pack_blocks(blocks), num_queues or 1)
 end
 
---- 共有キューから次のブロックを排他的に取得する
+--- ブロック配列を [x, y, w, h, x, y, w, h, ...] の形のフラットな配列にする
+--- @param blocks table ブロックの配列
+--- @return table
+function BlockUtils.pack_blocks(blocks)
+    local packed = {}
+    for i, block in ipairs(blocks) do
+        local base = (i - 1) * BlockUtils.QUEUE_STRIDE
+        packed[base + 1] = block.x
+        packed[base + 2] = block.y
+        packed[base + 3] = block.w
+        packed[base + 4] = block.h
+    end
+    return packed
+end
+
+-- ========================================
+-- プログレッシブプレビュー（多段解像度パス）
+-- ========================================
+
+--- 解像度レベルごとのキュー名
+--- @param queue_key string 元のキューの名前
+--- @param step number レベルのピクセル間隔
+--- @return string
+function BlockUtils.level_queue_key(queue_key, step)
+    return queue_key .. "@" .. step
+end
+
+--- レベル一覧を共有ストアに公開するキー
+--- @param queue_key string キューの名前
+--- @return string
+function BlockUtils.levels_key(queue_key)
+    return queue_key .. "_levels"
+end
+
+--- 多段解像度パス用のキューをセットアップする
+--- levels は粗い順のピクセル間隔（例 {8, 4, 2, 1}）で、各要素は前の要素を割り切る必要がある
+--- レベルごとに同じブロック配列のタイルスケジューラと、ブロック数で初期化したラッチ（レベル名）を用意する
+--- ワーカーはブロックを終えるたびにラッチを減らし、全ワーカーがレベルを終えるまでラッチで待ち合わせる
+--- levels が nil または1段だけの場合は通常の共有キューになる
 --- @param app_data userdata AppDataインスタンス
---- @param queue_key string キュー（ブロック配列）のキー
---- @param index_key string|nil インデックスのキー（省略時はqueue_key.."_idx"）
+--- @param blocks table ブロックの配列
+--- @param queue_key string キューの名前
+--- @param num_queues number|nil ワーカー別キューの数（省略時は1）
+--- @param levels table|nil 粗い順のピクセル間隔の配列
+function BlockUtils.setup_progressive_queue(app_data, blocks, queue_key, num_queues, levels)
+    if not levels or #levels <= 1 then
+        app_data:store_remove(BlockUtils.levels_key(queue_key))
+        BlockUtils.setup_shared_queue(app_data, blocks, queue_key, num_queues)
+        return
+    end
+
+    for _, step in ipairs(levels) do
+        local level_key = BlockUtils.level_queue_key(queue_key, step)
+        BlockUtils.setup_shared_queue(app_data, blocks, level_key, num_queues)
+        -- ラッチは名前で使い回すため、前回のレンダーで残ったカウントを必ず戻す
+        app_data:latch_reset(app_data:latch_slot(level_key, #blocks), #blocks)
+    end
+    app_data:store_ints(BlockUtils.levels_key(queue_key), levels)
+end
+
+--- 共有キューから次のブロックを取得する
+--- 自分のキューが空になると他のワーカーのキューから盗む
+--- @param app_data userdata AppDataインスタンス
+--- @param queue_key string キューの名前
+--- @param queue_index number|nil 呼び出し元ワーカーのキュー番号（省略時は0）
+--- @param tiles userdata|nil app_data:tile_queue(queue_key) で取得済みのスケジューラ（省略時は毎回取得）
 --- @return table|nil ブロック情報、無ければnil
-function BlockUtils.pull_next_block(app_data, queue_key, index_key)
-    index_key = index_key or (queue_key .. "_idx")
-    
-    -- インデックスを排他的に取得してインクリメント
-    local index = app_data:pop_next_index(index_key)
-    
-    -- ブロック配列を取得（キャッシュを考慮するなら改善の余地あり）
-    local queue_json = app_data:get_string(queue_key)
-    if not queue_json or queue_json == "" then
+function BlockUtils.pull_next_block(app_data, queue_key, queue_index, tiles)
+    tiles = tiles or app_data:tile_queue(queue_key)
+    if not tiles then
         return nil
     end
     
-    local blocks = json.decode(queue_json)
-    
-    -- Luaは1-indexedなので+1
-    local block = blocks[index + 1]
-    return block
+    local x, y, w, h = tiles:next_tile(queue_index or 0)
+    if not x then
+        return nil
+    end
+    return {x = x, y = y, w = w, h = h}
+end
+
+-- ========================================
+-- レンダリングとPostEffectのパイプライン
+-- ========================================
+
+--- PostEffectタイルの依存関係付きキューをセットアップする
+--- 各PostEffectタイルは、radius 分広げた範囲に重なるレンダリングタイルが全て完了すると取得可能になる
+--- @param app_data userdata AppDataインスタンス
+--- @param render_blocks table レンダリングブロックの配列（シェーディング座標）
+--- @param post_blocks table PostEffectブロックの配列（バッファ座標）
+--- @param queue_key string キューの名前
+--- @param radius number PostEffectが読み取る近傍の半径（ピクセル）
+--- @param flip_height number|nil シーンが y を反転して書き込む場合の画面の高さ
+function BlockUtils.setup_dependent_queue(app_data, render_blocks, post_blocks, queue_key, radius, flip_height)
+    app_data:setup_dependent_tiles(queue_key, BlockUtils.pack_blocks(render_blocks),
+        BlockUtils.pack_blocks(post_blocks), radius, flip_height or 0)
 end
 
 return BlockUtils
@@ -1,29 +1,72 @@
+local FastPath = require("lib.FastPath")
+
 local M = {}
 
+-- 共有ストアの "camera_state" に格納されるfloat配列のレイアウト（1-indexed）
+-- RayTracer:publish_camera_state が書き込み、ワーカーがここで読み取る
+M.CAMERA_STATE_LAYOUT = {
+    position = 1,      -- 1..3
+    look_at = 4,       -- 4..6
+    up = 7,            -- 7..9
+    aspect_ratio = 10,
+    fov = 11,
+}
+
+local function vec3_at(state, index)
+    return {state[index], state[index + 1], state[index + 2]}
+end
+
+-- 共有ストアのスナップショットからカメラ状態を適用する
+-- @return 適用できた場合は true
+local function apply_typed_state(camera, app_data)
+    if not app_data.store_get then
+        return false
+    end
+    local state = app_data:store_get(FastPath.store_slot(app_data, "camera_state"))
+    local layout = M.CAMERA_STATE_LAYOUT
+    if not state or #state < layout.fov then
+        return false
+    end
+    camera.position = vec3_at(state, layout.position)
+    camera.look_at = vec3_at(state, layout.look_at)
+    camera.up = vec3_at(state, layout.up)
+    camera.aspect_ratio = state[layout.aspect_ratio]
+    camera.fov = state[layout.fov]
+    return true
+end
+
+-- 旧形式: JSON文字列でシリアライズされたカメラ状態を適用する
+local function apply_json_state(camera, app_data)
+    local camera_state_json = app_data:get_string("camera_state")
+    if not camera_state_json or camera_state_json == "" then
+        return false
+    end
+    local json = require("lib.json")
+    local success, state = pcall(json.decode, camera_state_json)
+    if not success or not state then
+        return false
+    end
+    -- カメラのプロパティを上書き
+    if state.position then camera.position = state.position end
+    if state.look_at then camera.look_at = state.look_at end
+    if state.up then camera.camera_up = state.up end
+    if state.aspect_ratio then camera.aspect_ratio = state.aspect_ratio end
+    if state.fov then camera.fov = state.fov end
+    if state.type then camera.type = state.type end
+    return true
+end
+
 function M.setup_or_sync_camera(camera, app_data, default_params)
     if not camera then
         local Camera = require("lib.Camera")
         camera = Camera.new("perspective", default_params)
     end
     
-    -- ワーカー用にシリアライズされたカメラ状態が渡されていれば適用する
+    -- ワーカー用にカメラ状態が渡されていれば適用する
     if _thread_id ~= nil and app_data then
-        local camera_state_json = app_data:get_string("camera_state")
-        if camera_state_json and camera_state_json ~= "" then
-            local json = require("lib.json")
-            local success, state = pcall(json.decode, camera_state_json)
-            if success and state then
-                -- カメラのプロパティを上書き
-                if state.position then camera.position = state.position end
-                if state.look_at then camera.look_at = state.look_at end
-                if state.up then camera.camera_up = state.up end
-                if state.aspect_ratio then camera.aspect_ratio = state.aspect_ratio end
-                if state.fov then camera.fov = state.fov end
-                if state.type then camera.type = state.type end
-                
-                -- 基底ベクトルを再計算
-                camera:compute_camera_basis()
-            end
+        if apply_typed_state(camera, app_data) or apply_json_state(camera, app_data) then
+            -- 基底ベクトルを再計算
+            camera:compute_camera_basis()
         end
     end
     
@@ -0,0 +1,67 @@
+-- lib/FastPath.lua
+-- ホットパス用の高速な呼び出し（C++ の raw_set_pixel / raw_get_pixel / raw_intersect）を取得する
+-- 取得した関数は元のメソッドと同じく fn(obj, ...) で呼ぶ（第1引数は無視され、obj はクロージャに束縛済み）
+-- raw_* を持たないオブジェクト（テスト用のモックなど）では元のメソッドをそのまま返す
+
+local FastPath = {}
+
+-- メソッド名 -> (オブジェクト -> 関数)。オブジェクトが回収されたらエントリも消える
+local caches = {}
+
+--- obj の name メソッドの高速パスを返す（オブジェクトごとに1度だけ作成してキャッシュする）
+--- @param obj userdata|table AppData / EmbreeScene など
+--- @param name string "set_pixel" / "get_pixel" / "intersect"
+--- @return function fn(obj, ...)
+function FastPath.method(obj, name)
+    local cache = caches[name]
+    if not cache then
+        cache = setmetatable({}, { __mode = "k" })
+        caches[name] = cache
+    end
+    local fn = cache[obj]
+    if fn then
+        return fn
+    end
+    local raw = obj["raw_" .. name]
+    if raw then
+        fn = raw(obj)
+    else
+        fn = obj[name]
+    end
+    cache[obj] = fn
+    return fn
+end
+
+--- intersect だけを高速パスにしたシーンのプロキシを返す
+--- scene:intersect(...) と書かれた呼び出し側（PathTracer など）はそのまま使える
+--- @param scene userdata EmbreeScene
+--- @return table { intersect = fn }
+function FastPath.scene(scene)
+    return { intersect = FastPath.method(scene, "intersect") }
+end
+
+-- AppData -> (名前 -> 共有ストアのスロット番号)
+local store_slots = setmetatable({}, { __mode = "k" })
+
+--- 共有ストアの name のスロット番号を返す（AppData ごとに1度だけ解決してキャッシュする）
+--- スロット番号での store_get は名前の解決（ミューテックス）を通らず、ロックフリーに読み取る
+--- store_slot を持たないオブジェクト（テスト用のモックなど）では name をそのまま返す
+--- @param app_data userdata|table AppData
+--- @param name string 共有ストアのキー
+--- @return number|string app_data:store_get に渡すキー
+function FastPath.store_slot(app_data, name)
+    local slots = store_slots[app_data]
+    if not slots then
+        slots = {}
+        store_slots[app_data] = slots
+    end
+    local slot = slots[name]
+    if slot then
+        return slot
+    end
+    slot = app_data.store_slot and app_data:store_slot(name) or name
+    slots[name] = slot
+    return slot
+end
+
+return FastPath
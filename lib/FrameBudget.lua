@@ -0,0 +1,55 @@
+-- FrameBudget モジュール
+-- シングルスレッドのコルーチン描画を1フレームあたりの時間予算で区切る
+
+local FrameBudget = {}
+FrameBudget.__index = FrameBudget
+
+-- 1フレームでコルーチンに与える既定の時間（ms）。残りはUIと画面更新に使う（60fps = 16.6ms）
+FrameBudget.DEFAULT_BUDGET_MS = 12
+FrameBudget.MIN_BUDGET_MS = 1
+FrameBudget.MAX_BUDGET_MS = 100
+
+local NS_PER_MS = 1000000
+
+--- 新しいFrameBudgetインスタンスを作成
+--- @param budget_ms number|nil 1フレームの予算（ms）
+--- @param clock function|nil 経過時間をナノ秒の整数で返す関数（省略時は app.get_ticks_ns）
+--- @return table FrameBudgetインスタンス
+function FrameBudget.new(budget_ms, clock)
+    local self = setmetatable({}, FrameBudget)
+    self.clock = clock
+    self.deadline = nil
+    self:set_budget_ms(budget_ms or FrameBudget.DEFAULT_BUDGET_MS)
+    return self
+end
+
+--- 予算を変更する（MIN_BUDGET_MS〜MAX_BUDGET_MS に丸める）
+--- @param budget_ms number
+function FrameBudget:set_budget_ms(budget_ms)
+    budget_ms = math.max(FrameBudget.MIN_BUDGET_MS, math.min(FrameBudget.MAX_BUDGET_MS, budget_ms))
+    self.budget_ms = budget_ms
+    self.budget_ns = math.floor(budget_ms * NS_PER_MS)
+end
+
+function FrameBudget:now()
+    return (self.clock or app.get_ticks_ns)()
+end
+
+--- コルーチンを再開する直前に呼び、今フレームの締め切りを設定する
+function FrameBudget:begin_frame()
+    self.deadline = self:now() + self.budget_ns
+end
+
+--- コルーチンから戻った後に呼ぶ
+function FrameBudget:end_frame()
+    self.deadline = nil
+end
+
+--- 締め切りを過ぎたか（begin_frame の外では常に true で、すぐに制御を返す）
+--- @return boolean
+function FrameBudget:expired()
+    local deadline = self.deadline
+    return deadline == nil or self:now() >= deadline
+end
+
+return FrameBudget
@@ -3,12 +3,40 @@
 
 local Vec3 = require('lib.Vec3')
 local Ray = require('lib.Ray')
+local V3 = require('lib.V3')
 
 local Material = {}
 
 -- 自己交差防止用オフセット
 local kEPS = 1e-4
 
+-- 各マテリアルは2つの形の散乱関数を持つ
+--   scatter_xyz(dx, dy, dz, px, py, pz, nx, ny, nz, front_face)
+--     -> ox, oy, oz, sx, sy, sz, ar, ag, ab（散乱レイの原点・方向と減衰率）または nil
+--     ベクトルを数値のまま受け渡し、テーブルを作らない（パストレーシングのホットパス用）
+--     n はレイと向かい合う向きにした法線
+--   scatter(ray_in, rec) -> Ray, Vec3 または nil, nil
+--     scatter_xyz を Ray / Vec3 で包んだもの
+-- 発光も同様に emitted_xyz() -> r, g, b と emitted() -> Vec3 を持つ
+
+local function scatter_from_record(self, ray_in, rec)
+    local d, p, n = ray_in.direction, rec.p, rec.normal
+    local ox, oy, oz, sx, sy, sz, ar, ag, ab =
+        self:scatter_xyz(d.x, d.y, d.z, p.x, p.y, p.z, n.x, n.y, n.z, rec.front_face)
+    if not ox then
+        return nil, nil
+    end
+    return Ray.new(Vec3.new(ox, oy, oz), Vec3.new(sx, sy, sz)), Vec3.new(ar, ag, ab)
+end
+
+local function emitted_vec3(self)
+    return Vec3.new(self:emitted_xyz())
+end
+
+local function no_emission()
+    return 0, 0, 0
+end
+
 -- ===========================================
 -- Lambertian (拡散反射マテリアル)
 -- ===========================================
@@ -19,24 +47,25 @@ function Material.Lambertian(albedo)
         albedo = albedo
     }
     
-    function mat:scatter(ray_in, rec)
-        local scatter_direction = rec.normal + Vec3.random_unit_vector()
+    function mat:scatter_xyz(dx, dy, dz, px, py, pz, nx, ny, nz, front_face)
+        local rx, ry, rz = Vec3.random_unit_vector_xyz()
+        local sx, sy, sz = nx + rx, ny + ry, nz + rz
         
         -- 散乱方向がゼロに近い場合は法線方向を使用
-        if scatter_direction:near_zero() then
-            scatter_direction = rec.normal
+        if V3.near_zero(sx, sy, sz) then
+            sx, sy, sz = nx, ny, nz
         end
         
         -- レイの原点にオフセットを加えて自己交差を防止
-        local origin = rec.p + rec.normal * kEPS
-        local scattered = Ray.new(origin, scatter_direction)
-        local attenuation = self.albedo
-        return scattered, attenuation
+        local albedo = self.albedo
+        return px + nx * kEPS, py + ny * kEPS, pz + nz * kEPS,
+               sx, sy, sz,
+               albedo.x, albedo.y, albedo.z
     end
     
-    function mat:emitted()
-        return Vec3.new(0, 0, 0)
-    end
+    mat.scatter = scatter_from_record
+    mat.emitted_xyz = no_emission
+    mat.emitted = emitted_vec3
     
     return mat
 end
@@ -52,27 +81,29 @@ function Material.Metal(albedo, fuzz)
         fuzz = fuzz < 1 and fuzz or 1
     }
     
-    function mat:scatter(ray_in, rec)
-        local reflected = Vec3.reflect(ray_in.direction:normalize(), rec.normal)
+    function mat:scatter_xyz(dx, dy, dz, px, py, pz, nx, ny, nz, front_face)
+        local ux, uy, uz = V3.normalize(dx, dy, dz)
+        local rx, ry, rz = V3.reflect(ux, uy, uz, nx, ny, nz)
         
         -- fuzz (ぼかし) を適用
-        local scattered_direction = reflected + Vec3.random_in_unit_sphere() * self.fuzz
-        -- レイの原点にオフセットを加えて自己交差を防止
-        local origin = rec.p + rec.normal * kEPS
-        local scattered = Ray.new(origin, scattered_direction)
-        local attenuation = self.albedo
+        local qx, qy, qz = Vec3.random_in_unit_sphere_xyz()
+        local sx, sy, sz = V3.madd(rx, ry, rz, qx, qy, qz, self.fuzz)
         
         -- 反射レイが表面の下に入る場合は吸収（散乱なし）
-        if Vec3.dot(scattered.direction, rec.normal) > 0 then
-            return scattered, attenuation
-        else
-            return nil, nil
+        if V3.dot(sx, sy, sz, nx, ny, nz) <= 0 then
+            return nil
         end
+        
+        -- レイの原点にオフセットを加えて自己交差を防止
+        local albedo = self.albedo
+        return px + nx * kEPS, py + ny * kEPS, pz + nz * kEPS,
+               sx, sy, sz,
+               albedo.x, albedo.y, albedo.z
     end
     
-    function mat:emitted()
-        return Vec3.new(0, 0, 0)
-    end
+    mat.scatter = scatter_from_record
+    mat.emitted_xyz = no_emission
+    mat.emitted = emitted_vec3
     
     return mat
 end
@@ -94,39 +125,36 @@ function Material.Dielectric(index_of_refraction)
         ir = index_of_refraction
     }
     
-    function mat:scatter(ray_in, rec)
-        local attenuation = Vec3.new(1.0, 1.0, 1.0)
-        local refraction_ratio = rec.front_face and (1.0 / self.ir) or self.ir
+    function mat:scatter_xyz(dx, dy, dz, px, py, pz, nx, ny, nz, front_face)
+        local refraction_ratio = front_face and (1.0 / self.ir) or self.ir
         
-        local unit_direction = ray_in.direction:normalize()
-        local cos_theta = math.min(Vec3.dot(-unit_direction, rec.normal), 1.0)
+        local ux, uy, uz = V3.normalize(dx, dy, dz)
+        local cos_theta = math.min(-V3.dot(ux, uy, uz, nx, ny, nz), 1.0)
         local sin_theta = math.sqrt(1.0 - cos_theta * cos_theta)
         
         local cannot_refract = refraction_ratio * sin_theta > 1.0
-        local direction
-        local is_reflection
+        local sx, sy, sz
+        -- レイの原点にオフセットを加えて自己交差を防止
+        -- 反射は表側、屈折は裏側にオフセット
+        local offset = kEPS
         
         if cannot_refract or reflectance(cos_theta, refraction_ratio) > math.random() then
             -- 全反射またはシュリック近似による反射
-            direction = Vec3.reflect(unit_direction, rec.normal)
-            is_reflection = true
+            sx, sy, sz = V3.reflect(ux, uy, uz, nx, ny, nz)
         else
             -- 屈折
-            direction = Vec3.refract(unit_direction, rec.normal, refraction_ratio)
-            is_reflection = false
+            sx, sy, sz = V3.refract(ux, uy, uz, nx, ny, nz, refraction_ratio)
+            offset = -kEPS
         end
         
-        -- レイの原点にオフセットを加えて自己交差を防止
-        -- 反射は表側、屈折は裏側にオフセット
-        local offset_normal = is_reflection and rec.normal or (-rec.normal)
-        local origin = rec.p + offset_normal * kEPS
-        local scattered = Ray.new(origin, direction)
-        return scattered, attenuation
+        return px + nx * offset, py + ny * offset, pz + nz * offset,
+               sx, sy, sz,
+               1.0, 1.0, 1.0
     end
     
-    function mat:emitted()
-        return Vec3.new(0, 0, 0)
-    end
+    mat.scatter = scatter_from_record
+    mat.emitted_xyz = no_emission
+    mat.emitted = emitted_vec3
     
     return mat
 end
@@ -141,10 +169,17 @@ function Material.DiffuseLight(emit_color)
         emit = emit_color
     }
     
-    function mat:scatter(ray_in, rec)
-        return nil, nil  -- 光源はレイを散乱させない
+    function mat:scatter_xyz()
+        return nil  -- 光源はレイを散乱させない
     end
     
+    function mat:emitted_xyz()
+        local emit = self.emit
+        return emit.x, emit.y, emit.z
+    end
+    
+    mat.scatter = scatter_from_record
+    
     function mat:emitted()
         return self.emit
     end
@@ -152,4 +187,76 @@ function Material.DiffuseLight(emit_color)
     return mat
 end
 
+-- ===========================================
+-- AOV（特徴量バッファ）用のアルベド
+-- ===========================================
+
+--- AOV に書き込むアルベドを返す（発光体は放射色を 1.0 でクランプ、屈折体は白）
+--- @param material table|nil Material
+--- @return number, number, number r, g, b (0.0-1.0)
+function Material.aov_albedo(material)
+    if not material then
+        return 0, 0, 0
+    end
+    local color = material.albedo or material.emit
+    if not color then
+        return 1, 1, 1
+    end
+    return math.min(color.x, 1), math.min(color.y, 1), math.min(color.z, 1)
+end
+
+-- ===========================================
+-- 共有ストア用のシリアライズ
+-- ===========================================
+
+-- フラット配列レイアウト: 1マテリアルあたり [geomID, 種別コード, p1, p2, p3, p4]
+Material.PACK_STRIDE = 6
+
+local TYPE_CODES = { lambertian = 0, metal = 1, dielectric = 2, diffuse_light = 3 }
+
+--- マテリアル定義を app_data:store_floats 用のフラット配列に変換する
+--- @param material_data table tostring(geomID) -> {type, albedo, fuzz, ir, emit}
+--- @return table フラットな数値配列
+function Material.pack(material_data)
+    local packed = {}
+    for key, data in pairs(material_data) do
+        local code = TYPE_CODES[data.type]
+        if code then
+            local color = data.albedo or data.emit or {0, 0, 0}
+            local extra = data.fuzz or data.ir or 0
+            local n = #packed
+            packed[n + 1] = tonumber(key)
+            packed[n + 2] = code
+            packed[n + 3] = color[1]
+            packed[n + 4] = color[2]
+            packed[n + 5] = color[3]
+            packed[n + 6] = extra
+        end
+    end
+    return packed
+end
+
+--- Material.pack の結果（共有ストアのビューまたはテーブル）から Material を再構築する
+--- @param packed userdata|table インデックスアクセスと # に対応したフラット配列
+--- @return table geomID -> Material
+function Material.unpack(packed)
+    local materials = {}
+    for base = 0, #packed - Material.PACK_STRIDE, Material.PACK_STRIDE do
+        local geomID = math.floor(packed[base + 1] + 0.5)
+        local code = math.floor(packed[base + 2] + 0.5)
+        local color = Vec3.new(packed[base + 3], packed[base + 4], packed[base + 5])
+        local extra = packed[base + 6]
+        if code == TYPE_CODES.lambertian then
+            materials[geomID] = Material.Lambertian(color)
+        elseif code == TYPE_CODES.metal then
+            materials[geomID] = Material.Metal(color, extra)
+        elseif code == TYPE_CODES.dielectric then
+            materials[geomID] = Material.Dielectric(extra)
+        elseif code == TYPE_CODES.diffuse_light then
+            materials[geomID] = Material.DiffuseLight(color)
+        end
+    end
+    return materials
+end
+
 return Material
@@ -0,0 +1,78 @@
+-- MaterialGraph モジュール
+-- ネイティブのマテリアルグラフ（src/material_graph.h）を記述するビルダー
+-- setup（メインスレッド）でノードを組み立てて app_data に登録し、ワーカーは start で
+-- app_data:get_material(name) を取得して、ヒットごとに material:eval(...) で C++ 側で評価する
+--
+--   local graph = MaterialGraph.new()
+--   local albedo = graph:texture("box_textured_tex0")
+--   local color = graph:mul(albedo, graph:lambert(graph:constant(1.0)))
+--   graph:compile(app_data, "box", color)
+--
+--   -- start / shade（ワーカー）
+--   local material = app_data:get_material("box")
+--   local r, g, b = material:eval(nx, ny, nz, vx, vy, vz, lx, ly, lz, u, v)
+
+local MaterialGraph = {}
+MaterialGraph.__index = MaterialGraph
+
+--- 空のグラフを作成
+--- @return table MaterialGraphインスタンス
+function MaterialGraph.new()
+    return setmetatable({ nodes = {} }, MaterialGraph)
+end
+
+-- ノードを追加してノード番号（1 始まり）を返す
+local function push(self, node)
+    local nodes = self.nodes
+    nodes[#nodes + 1] = node
+    return #nodes
+end
+
+--- 定数（g, b を省略するとスカラー r を3成分に使う）
+function MaterialGraph:constant(r, g, b)
+    return push(self, { op = "constant", value = { r, g or r, b or r } })
+end
+
+--- テクスチャ（app_data:load_texture_image 済みの名前、ヒットの u, v で最近傍サンプリング。0-1 の RGB）
+function MaterialGraph:texture(name)
+    return push(self, { op = "texture", texture = name })
+end
+
+--- a + b（成分ごと）
+function MaterialGraph:add(a, b)
+    return push(self, { op = "add", inputs = { a, b } })
+end
+
+--- a * b（成分ごと）
+function MaterialGraph:mul(a, b)
+    return push(self, { op = "mul", inputs = { a, b } })
+end
+
+--- a と b を t（R 成分）で線形補間
+function MaterialGraph:mix(a, b, t)
+    return push(self, { op = "mix", inputs = { a, b, t } })
+end
+
+--- Schlick の Fresnel 項（法線と視線のなす角、f0 は正面の反射率）
+function MaterialGraph:fresnel(f0)
+    return push(self, { op = "fresnel", inputs = { f0 } })
+end
+
+--- Lambert 拡散反射（albedo × n·l）
+function MaterialGraph:lambert(albedo)
+    return push(self, { op = "lambert", inputs = { albedo } })
+end
+
+--- GGX 鏡面反射（f0 は正面の反射率、roughness は R 成分）
+function MaterialGraph:ggx(f0, roughness)
+    return push(self, { op = "ggx", inputs = { f0, roughness } })
+end
+
+--- 命令列にコンパイルして app_data に name で登録する
+--- @param output number 出力ノード番号
+--- @return boolean, string|nil 成功したか、失敗時のエラーメッセージ
+function MaterialGraph:compile(app_data, name, output)
+    return app_data:compile_material(name, self.nodes, output)
+end
+
+return MaterialGraph
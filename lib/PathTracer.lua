@@ -2,7 +2,7 @@
 -- パストレーシング用モジュール (edupt 移植)
 
 local Vec3 = require('lib.Vec3')
-local Ray = require('lib.Ray')
+local V3 = require('lib.V3')
 
 local PathTracer = {}
 
@@ -18,134 +18,133 @@ PathTracer.kPI = math.pi
 -- ===========================================
 -- 法線wに対して直交するu, vを生成
 function PathTracer.create_orthonormal_basis(normal)
-    local w = normal:normalize()
-    
-    local up
-    if math.abs(w.x) > PathTracer.kEPS then
-        up = Vec3.new(0, 1, 0)
-    else
-        up = Vec3.new(1, 0, 0)
-    end
-    
-    local u = Vec3.cross(up, w):normalize()
-    local v = Vec3.cross(w, u)
-    
-    return w, u, v
+    local wx, wy, wz, ux, uy, uz, vx, vy, vz = V3.onb(normal.x, normal.y, normal.z)
+    return Vec3.new(wx, wy, wz), Vec3.new(ux, uy, uz), Vec3.new(vx, vy, vz)
 end
 
 -- ===========================================
 -- コサイン重点サンプリング
 -- ===========================================
--- 法線方向を基準とした半球上のランダム方向を生成
-function PathTracer.cosine_weighted_sample(normal)
-    local w, u, v = PathTracer.create_orthonormal_basis(normal)
+-- 法線方向を基準とした半球上のランダム方向を生成（x, y, z の多値）
+function PathTracer.cosine_weighted_sample_xyz(nx, ny, nz)
+    local wx, wy, wz, ux, uy, uz, vx, vy, vz = V3.onb(nx, ny, nz)
     
     local r1 = 2 * PathTracer.kPI * math.random()
     local r2 = math.random()
     local r2s = math.sqrt(r2)
     
-    local dir = u * math.cos(r1) * r2s +
-                v * math.sin(r1) * r2s +
-                w * math.sqrt(1.0 - r2)
-    
-    return dir:normalize()
+    local a = math.cos(r1) * r2s
+    local b = math.sin(r1) * r2s
+    local c = math.sqrt(1.0 - r2)
+    return V3.normalize(ux * a + vx * b + wx * c,
+                        uy * a + vy * b + wy * c,
+                        uz * a + vz * b + wz * c)
+end
+
+function PathTracer.cosine_weighted_sample(normal)
+    return Vec3.new(PathTracer.cosine_weighted_sample_xyz(normal.x, normal.y, normal.z))
 end
 
 -- ===========================================
 -- radiance関数 (放射輝度を計算)
 -- ===========================================
 -- edupt の radiance 関数を移植
--- @param ray Ray レイ
+-- 再帰の代わりに経路のスループットを掛け合わせながらループで追跡し、ベクトルは数値のまま扱う（テーブルを作らない）
+-- @param ox, oy, oz number レイの原点
+-- @param dx, dy, dz number レイの方向
 -- @param scene EmbreeScene シーン
 -- @param materials table マテリアルテーブル (geomID -> Material)
--- @param depth int 現在の再帰深度
--- @return Vec3 放射輝度
-function PathTracer.radiance(ray, scene, materials, depth, max_depth)
+-- @param depth int 残りの深度
+-- @param max_depth int|nil 最大深度（省略時は depth）
+-- @return number, number, number 放射輝度
+-- @return number|nil, number, number, number, int 最初の交差の距離・レイの反対側を向いた法線・geomID
+--         （AOV の記録用。最初のレイが何にも当たらなかった場合は nil）
+function PathTracer.radiance_xyz(ox, oy, oz, dx, dy, dz, scene, materials, depth, max_depth)
     -- max_depth が渡されない場合は depth を使用（初回呼び出し）
     max_depth = max_depth or depth
     
-    -- 深度が0以下の場合は黒を返す
-    if depth <= 0 then
-        return Vec3.new(0, 0, 0)
-    end
-    
-    -- シーンとの交差判定
-    local ox, oy, oz = ray.origin.x, ray.origin.y, ray.origin.z
-    local dx, dy, dz = ray.direction.x, ray.direction.y, ray.direction.z
-    local hit, t, nx, ny, nz, geomID, primID = scene:intersect(ox, oy, oz, dx, dy, dz)
-    
-    if not hit then
-        return PathTracer.kBackgroundColor
-    end
-    
-    -- ヒット情報
-    local hitpoint = ray:at(t)
-    local normal = Vec3.new(nx, ny, nz)
-    
-    -- 表面の向き（内外判定）
-    local front_face = Vec3.dot(ray.direction, normal) < 0
-    local orienting_normal = front_face and normal or (-normal)
-    
-    -- マテリアル取得
-    local material = materials[geomID]
-    if not material then
-        return Vec3.new(1, 0, 1)  -- マゼンタ（デバッグ用）
-    end
-    
-    -- 発光を取得
-    local emission = Vec3.new(0, 0, 0)
-    if material.emitted then
-        emission = material:emitted()
-    end
-    
-    -- HitRecordを構築
-    local rec = {
-        p = hitpoint,
-        normal = orienting_normal,
-        t = t,
-        front_face = front_face
-    }
-    
-    -- 散乱
-    local scattered, attenuation = material:scatter(ray, rec)
-    
-    if not scattered then
-        -- 散乱しない（光源など）
-        return emission
-    end
-    
-    -- 反射率の最大値（ロシアンルーレット用）
-    local russian_roulette_probability = math.max(attenuation.x, math.max(attenuation.y, attenuation.z))
-    
-    -- 深度が制限を超えた場合は確率を急激に下げる
-    if depth > PathTracer.kDepthLimit then
-        russian_roulette_probability = russian_roulette_probability * (0.5 ^ (depth - PathTracer.kDepthLimit))
-    end
-    
-    -- ロシアンルーレット
-    -- 経過した深度 = max_depth - depth
-    local elapsed_depth = max_depth - depth
-    
-    if elapsed_depth > PathTracer.kDepth then
-        if math.random() >= russian_roulette_probability then
-            return emission
+    local r, g, b = 0, 0, 0        -- 蓄積した放射輝度
+    local tr, tg, tb = 1, 1, 1     -- 経路のスループット（減衰率 / ロシアンルーレット確率の積）
+    local background = PathTracer.kBackgroundColor
+    local first_t, first_nx, first_ny, first_nz, first_id  -- 最初の交差
+    
+    -- 深度が0以下になったら打ち切り（黒）
+    while depth > 0 do
+        -- シーンとの交差判定
+        local hit, t, nx, ny, nz, geomID = scene:intersect(ox, oy, oz, dx, dy, dz)
+        
+        if not hit then
+            r, g, b = r + tr * background.x, g + tg * background.y, b + tb * background.z
+            break
+        end
+        
+        -- ヒット情報と表面の向き（内外判定）
+        local front_face = dx * nx + dy * ny + dz * nz < 0
+        if not front_face then
+            nx, ny, nz = -nx, -ny, -nz
+        end
+        if not first_t then
+            first_t, first_nx, first_ny, first_nz, first_id = t, nx, ny, nz, geomID
         end
-    else
-        russian_roulette_probability = 1.0
+        
+        -- マテリアル取得
+        local material = materials[geomID]
+        if not material then
+            -- マゼンタ（デバッグ用）
+            r, b = r + tr, b + tb
+            break
+        end
+        
+        local px, py, pz = ox + dx * t, oy + dy * t, oz + dz * t
+        
+        -- 発光を加算
+        local er, eg, eb = material:emitted_xyz()
+        r, g, b = r + tr * er, g + tg * eg, b + tb * eb
+        
+        -- 散乱
+        local sox, soy, soz, sdx, sdy, sdz, ar, ag, ab =
+            material:scatter_xyz(dx, dy, dz, px, py, pz, nx, ny, nz, front_face)
+        if not sox then
+            -- 散乱しない（光源など）
+            break
+        end
+        
+        -- 反射率の最大値（ロシアンルーレット用）
+        local russian_roulette_probability = math.max(ar, ag, ab)
+        
+        -- 深度が制限を超えた場合は確率を急激に下げる
+        if depth > PathTracer.kDepthLimit then
+            russian_roulette_probability = russian_roulette_probability * (0.5 ^ (depth - PathTracer.kDepthLimit))
+        end
+        
+        -- ロシアンルーレット
+        -- 経過した深度 = max_depth - depth
+        if max_depth - depth > PathTracer.kDepth then
+            if math.random() >= russian_roulette_probability then
+                break
+            end
+        else
+            russian_roulette_probability = 1.0
+        end
+        
+        -- weight = attenuation / russian_roulette_probability
+        local inv = 1.0 / russian_roulette_probability
+        tr, tg, tb = tr * ar * inv, tg * ag * inv, tb * ab * inv
+        
+        ox, oy, oz, dx, dy, dz = sox, soy, soz, sdx, sdy, sdz
+        depth = depth - 1
     end
     
-    -- 再帰的にレイを追跡
-    local incoming_radiance = PathTracer.radiance(scattered, scene, materials, depth - 1, max_depth)
-    
-    -- weight = attenuation / russian_roulette_probability
-    local weight = attenuation / russian_roulette_probability
-    
-    -- emission + weight * incoming_radiance
-    return emission + Vec3.new(
-        weight.x * incoming_radiance.x,
-        weight.y * incoming_radiance.y,
-        weight.z * incoming_radiance.z
-    )
+    return r, g, b, first_t, first_nx, first_ny, first_nz, first_id
+end
+
+--- radiance_xyz の Ray / Vec3 版
+-- @param ray Ray レイ
+-- @return Vec3 放射輝度
+function PathTracer.radiance(ray, scene, materials, depth, max_depth)
+    local o, d = ray.origin, ray.direction
+    local r, g, b = PathTracer.radiance_xyz(o.x, o.y, o.z, d.x, d.y, d.z, scene, materials, depth, max_depth)
+    return Vec3.new(r, g, b)
 end
 
 return PathTracer
@@ -0,0 +1,127 @@
+-- Profiler モジュール
+-- サンプリングプロファイラ（app.take_profile / worker:take_profile）の集計を結合し、
+-- フレームグラフ用の折りたたみスタック（flamegraph.pl / speedscope で読める形式）とテキストのレポートにする
+
+local Profiler = {}
+
+-- 集計は { [折りたたみスタック] = {samples = n, ns = t} }（スタックは根から順に ';' 区切り）
+
+--- profile のサンプルを merged に加算する
+--- @param merged table 結合先の集計
+--- @param profile table take_profile() の戻り値
+--- @param root string|nil 各スタックの根に付けるフレーム名（"main" / "worker" など）
+--- @return table merged
+function Profiler.merge(merged, profile, root)
+    for stack, entry in pairs(profile) do
+        local key = root and (root .. ";" .. stack) or stack
+        local total = merged[key]
+        if total then
+            total.samples = total.samples + entry.samples
+            total.ns = total.ns + entry.ns
+        else
+            merged[key] = { samples = entry.samples, ns = entry.ns }
+        end
+    end
+    return merged
+end
+
+--- 集計が空かどうか
+function Profiler.is_empty(merged)
+    return next(merged) == nil
+end
+
+--- 折りたたみスタック形式のテキスト（1行に "スタック 重み"、重みはマイクロ秒の整数）
+--- @param merged table
+--- @return string
+function Profiler.folded(merged)
+    local stacks = {}
+    for stack in pairs(merged) do
+        stacks[#stacks + 1] = stack
+    end
+    table.sort(stacks)
+    local lines = {}
+    for i, stack in ipairs(stacks) do
+        lines[i] = stack .. " " .. math.max(1, merged[stack].ns // 1000)
+    end
+    return table.concat(lines, "\n") .. "\n"
+end
+
+-- フレーム名 -> {samples, ns} の表を時間の降順に並べる
+local function sorted_frames(frames)
+    local list = {}
+    for name, entry in pairs(frames) do
+        list[#list + 1] = { name = name, samples = entry.samples, ns = entry.ns }
+    end
+    table.sort(list, function(a, b)
+        if a.ns ~= b.ns then
+            return a.ns > b.ns
+        end
+        return a.name < b.name
+    end)
+    return list
+end
+
+local function add(frames, name, entry)
+    local total = frames[name]
+    if not total then
+        total = { samples = 0, ns = 0 }
+        frames[name] = total
+    end
+    total.samples = total.samples + entry.samples
+    total.ns = total.ns + entry.ns
+end
+
+--- 関数ごとの自己時間（スタックの葉）と包括時間（再帰は1回と数える）のレポート
+--- @param merged table
+--- @param limit number|nil 表示する関数の数（既定 15）
+--- @return string
+function Profiler.report(merged, limit)
+    limit = limit or 15
+    local self_frames, total_frames = {}, {}
+    local samples, ns = 0, 0
+    for stack, entry in pairs(merged) do
+        samples = samples + entry.samples
+        ns = ns + entry.ns
+        local seen = {}
+        local leaf = nil
+        for frame in string.gmatch(stack, "[^;]+") do
+            if not seen[frame] then
+                seen[frame] = true
+                add(total_frames, frame, entry)
+            end
+            leaf = frame
+        end
+        if leaf then
+            add(self_frames, leaf, entry)
+        end
+    end
+
+    local lines = { string.format("Lua profile: %d samples, %.2f ms", samples, ns / 1e6) }
+    local function section(title, frames)
+        lines[#lines + 1] = title
+        for i, frame in ipairs(sorted_frames(frames)) do
+            if i > limit then
+                break
+            end
+            local percent = ns > 0 and frame.ns / ns * 100 or 0
+            lines[#lines + 1] = string.format("  %5.1f%% %10.2f ms %8d  %s", percent, frame.ns / 1e6, frame.samples, frame.name)
+        end
+    end
+    section("  self:", self_frames)
+    section("  total:", total_frames)
+    return table.concat(lines, "\n")
+end
+
+--- 折りたたみスタックをファイルに書き出す
+--- @return boolean, string|nil 成功したか、失敗時のエラーメッセージ
+function Profiler.write_folded(path, merged)
+    local file, err = io.open(path, "w")
+    if not file then
+        return false, err
+    end
+    file:write(Profiler.folded(merged))
+    file:close()
+    return true
+end
+
+return Profiler
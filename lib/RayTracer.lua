@@ -2,6 +2,10 @@
 local BlockUtils = require("lib.BlockUtils")
 local ResolutionPresets = require("lib.ResolutionPresets")
 local ThreadPresets = require("lib.ThreadPresets")
+local FrameBudget = require("lib.FrameBudget")
+local Profiler = require("lib.Profiler")
+
+local MB = 1024 * 1024
 
 RayTracer = {}
 RayTracer.__index = RayTracer
@@ -19,15 +23,29 @@ function RayTracer.new(width, height)
     self.current_scene_module = nil -- モジュールはreset_sceneで読み込まれる
     self.workers = {} -- Array of ThreadWorker
     self.posteffect_workers = {} -- Array of ThreadWorker for PostEffect
+    self.worker_pool = {} -- 永続ワーカー（スレッドとLua Stateをレンダリング間で再利用）
     self.render_coroutine = nil -- Coroutine for single-threaded rendering
     self.posteffect_coroutine = nil -- Coroutine for single-threaded PostEffect
     self.use_multithreading = false -- マルチスレッド使用フラグ
+    self.frame_budget = FrameBudget.new() -- シングルスレッド時にコルーチンへ与える1フレームあたりの時間
     self.NUM_THREADS = 8 -- スレッド数
     self.BLOCK_SIZE = 64 -- ブロックサイズ
+    self.use_progressive = true -- 粗い解像度から順に描画するプログレッシブプレビュー
+    self.PROGRESSIVE_LEVELS = {8, 4, 2, 1} -- プレビューのピクセル間隔（粗い順、最後は1）
+    self.use_pipelined_post = true -- レンダリングタイルの完了に合わせてPostEffectタイルを同じワーカーで処理する
+    self.post_pipelined = false -- 実行中のレンダリングがパイプラインPostEffectを含むか
+    self.pin_threads = true -- ワーカーを物理コア優先・NUMAノード交互の順でCPUに固定する
+    self.cpu_topology = nil -- ホストのCPUトポロジ（初回参照時に取得）
     self.render_start_time = 0 -- Rendering start time
+    self.render_stats = nil -- 直近のレンダリングの進捗・スループット統計（RenderStats）
     self.current_preset_index = ResolutionPresets.get_default_index() -- 解像度プリセットインデックス
     self.thread_preset_index = ThreadPresets.get_default_thread_index() -- スレッド数プリセットインデックス
     self.block_preset_index = ThreadPresets.get_default_block_index() -- ブロックサイズプリセットインデックス
+    self.gc_preset_index = ThreadPresets.get_default_gc_index() -- Lua GCプリセットインデックス
+    self.main_gc_collections = 0 -- レンダリング開始時点のメインステートのGCサイクル数
+    self.profile_lua = false -- Lua のサンプリングプロファイラ（レンダリング完了時に折りたたみスタックを書き出す）
+    self.PROFILE_PERIOD = 10000 -- プロファイラのサンプリング間隔（VM命令数）
+    self.last_profile_path = nil -- 直近に書き出したプロファイルのパス
     return self
 end
 
@@ -124,6 +142,9 @@ function RayTracer:reset_scene(scene_type, force_reload)
     -- 実行中のワーカーを安全に停止
     self:terminate_workers()
     
+    -- シーン（とワーカーが参照するEmbreeScene）が変わるため、ワーカーのLua Stateも作り直す
+    self:release_worker_pool()
+    
     -- Stop any existing coroutine
     self.render_coroutine = nil
     self.posteffect_coroutine = nil
@@ -155,6 +176,8 @@ function RayTracer:reset_scene(scene_type, force_reload)
     if force_reload then
         print("Force reloading module: " .. scene_module_path)
         package.loaded[scene_module_path] = nil
+        -- ワーカーが新しいステートで読み込むモジュールもソースからコンパイルし直す
+        app.invalidate_module_cache()
     end
     
     local success, scene_module = pcall(require, scene_module_path)
@@ -172,6 +195,8 @@ function RayTracer:reset_scene(scene_type, force_reload)
     
     -- シーンのセットアップとカメラの初期化
     -- setup: Geometry creation (Main thread only, once)
+    -- AOVは必要なシーンが setup で有効化するため、前のシーンのバッファは破棄しておく
+    self.data:disable_aovs()
     if self.current_scene_module.setup then
         self.current_scene_module.setup(self.scene, self.data)
     end
@@ -194,8 +219,8 @@ end
 function RayTracer:reset_workers(clear_texture)
     print("Resetting workers...")
 
-    -- 実行中のワーカーを安全に停止（マルチスレッド時はワーカー内でstopが呼ばれる）
-    self:terminate_workers()
+    -- 実行中のワーカーを待たずに打ち切る（マルチスレッド時はワーカー内でstopが呼ばれる）
+    self:cancel_workers()
     
     -- シングルスレッドのコルーチンを停止
     if self.render_coroutine or self.posteffect_coroutine then
@@ -246,7 +271,28 @@ function RayTracer:update_texture_from_back()
     app.update_texture_from_back(self.texture, self.data)
 end
 
--- すべてのワーカーを安全に停止
+-- 実行中のワーカーを待たずにキャンセルする
+-- レンダー世代を進めると古いジョブはタイル単位で自ら終了し、それまでの書き込みは破棄されるため、
+-- カメラ操作などで次のレンダリングをすぐに登録してもメインループが停止しない
+function RayTracer:cancel_workers()
+    if #self.workers == 0 and #self.posteffect_workers == 0 then
+        return
+    end
+    self.data:advance_render_generation()
+    
+    for _, worker in ipairs(self.workers) do
+        worker:cancel()
+    end
+    self.workers = {}
+    
+    for _, worker in ipairs(self.posteffect_workers) do
+        worker:cancel()
+    end
+    self.posteffect_workers = {}
+end
+
+-- すべてのワーカーを安全に停止（完了を待つ）
+-- シーンやAppDataを破棄する前に呼ぶ。cancel_workers で打ち切った古いジョブの終了も待つ
 function RayTracer:terminate_workers()
     -- レンダリングワーカーをterminate
     for _, worker in ipairs(self.workers) do
@@ -259,14 +305,125 @@ function RayTracer:terminate_workers()
         worker:terminate()
     end
     self.posteffect_workers = {}
+    
+    -- キャンセル済みでまだ実行中の古いジョブ
+    for _, worker in ipairs(self.worker_pool) do
+        worker:terminate()
+    end
+end
+
+-- ホストのCPUトポロジを取得する（取得できない環境では nil）
+function RayTracer:get_cpu_topology()
+    if not self.cpu_topology and app.cpu_topology then
+        self.cpu_topology = app.cpu_topology()
+    end
+    return self.cpu_topology
+end
+
+-- スレッド数プリセット値を実際のスレッド数に変換する（Auto はホストの論理CPU数）
+function RayTracer:resolve_thread_count(value)
+    local topology = self:get_cpu_topology()
+    return ThreadPresets.resolve_thread_count(value, topology and topology.logical)
+end
+
+-- 永続ワーカープールから count 個のワーカーを取得する
+-- 不足分のみ新規に生成し、スレッド数を減らした場合は余剰分のスレッドを停止する
+function RayTracer:acquire_pool_workers(count)
+    local topology = self.pin_threads and self:get_cpu_topology() or nil
+    local pin_order = topology and topology.pin_order or {}
+    for i = #self.worker_pool + 1, count do
+        -- Boundsは使用しないが、一応画面全体を渡しておく
+        local worker = ThreadWorker.create(self.data, self.scene, 0, 0, self.width, self.height, i - 1)
+        -- ワーカー i はピン留め順の i 番目のCPUへ（CPU数を超えた分は先頭から繰り返す）
+        if #pin_order > 0 then
+            worker:set_cpu_affinity(pin_order[(i - 1) % #pin_order + 1])
+        end
+        worker:set_gc_settings(self:gc_settings())
+        worker:set_profiling(self.profile_lua and self.PROFILE_PERIOD or 0)
+        self.worker_pool[i] = worker
+    end
+    for i = #self.worker_pool, count + 1, -1 do
+        self.worker_pool[i]:shutdown()
+        self.worker_pool[i] = nil
+    end
+    
+    local workers = {}
+    for i = 1, count do
+        workers[i] = self.worker_pool[i]
+    end
+    return workers
+end
+
+-- 選択中のLua GCプリセットの設定テーブル
+function RayTracer:gc_settings()
+    local preset = ThreadPresets.get_gc_presets()[self.gc_preset_index]
+    return preset and preset.value or { mode = "incremental" }
+end
+
+-- Lua GCプリセットを変更し、メインステートと永続ワーカーに反映する（ワーカーは次のジョブから）
+function RayTracer:set_gc_preset(index)
+    self.gc_preset_index = index
+    local settings = self:gc_settings()
+    app.set_gc_settings(settings)
+    for _, worker in ipairs(self.worker_pool) do
+        worker:set_gc_settings(settings)
+    end
+end
+
+-- Lua のサンプリングプロファイラを切り替える（メインステートは即時、ワーカーは次のジョブから）
+function RayTracer:set_profiling(enabled)
+    self.profile_lua = enabled
+    local period = enabled and self.PROFILE_PERIOD or 0
+    app.set_profiling(period)
+    for _, worker in ipairs(self.worker_pool) do
+        worker:set_profiling(period)
+    end
+end
+
+-- メインステートと永続ワーカーのプロファイルを取り出して結合する（取り出した集計は空になる）
+-- @return table Profiler の集計（根のフレームは "main" / "worker"）
+function RayTracer:take_profile()
+    local merged = Profiler.merge({}, app.take_profile(), "main")
+    for _, worker in ipairs(self.worker_pool) do
+        Profiler.merge(merged, worker:take_profile(), "worker")
+    end
+    return merged
+end
+
+-- レンダリング完了時にプロファイルを折りたたみスタックとして書き出し、レポートを出力する
+function RayTracer:finish_profile()
+    if not self.profile_lua then
+        return
+    end
+    local merged = self:take_profile()
+    if Profiler.is_empty(merged) then
+        return
+    end
+    local path = string.format("profile_%s.folded", os.date("%Y%m%d_%H%M%S"))
+    local ok, err = Profiler.write_folded(path, merged)
+    if ok then
+        print("Saved Lua profile: " .. path)
+        self.last_profile_path = path
+    else
+        print("Failed to save Lua profile: " .. tostring(err))
+    end
+    print(Profiler.report(merged))
+end
+
+-- 永続ワーカーのスレッドとLua Stateを破棄する（シーン切り替え・解像度変更・終了時）
+function RayTracer:release_worker_pool()
+    for _, worker in ipairs(self.worker_pool) do
+        worker:shutdown()
+    end
+    self.worker_pool = {}
 end
 
 -- レンダリングをキャンセル
 function RayTracer:cancel()
     print("Cancelling rendering...")
     
-    -- ワーカーを停止
-    self:terminate_workers()
+    -- ワーカーを待たずに打ち切る
+    self:cancel_workers()
     
     -- コルーチンを破棄
     if self.render_coroutine or self.posteffect_coroutine then
@@ -290,7 +447,9 @@ function RayTracer:cancel_if_rendering()
 end
 
 -- ブロック分割と共有キューの共通セットアップ
-function RayTracer:setup_blocks(queue_name)
+-- @param queue_name string キューの名前
+-- @param levels table|nil 多段解像度パスのピクセル間隔（nilの場合は通常の1パス）
+function RayTracer:setup_blocks(queue_name, levels)
     -- ブロック単位で画面を分割
     local blocks = BlockUtils.generate_blocks(
         self.width, self.height, self.BLOCK_SIZE, 1
@@ -299,51 +458,125 @@ function RayTracer:setup_blocks(queue_name)
     -- ブロックをシャッフルしてランダム順序にする
     blocks = BlockUtils.shuffle_blocks(blocks)
     
-    -- 共有キューをセットアップ
-    BlockUtils.setup_shared_queue(self.data, blocks, queue_name)
+    -- 共有キューをセットアップ（ワーカーごとのキューに分配、シングルスレッド時は1つ）
+    local num_queues = self.use_multithreading and self.NUM_THREADS or 1
+    BlockUtils.setup_progressive_queue(self.data, blocks, queue_name, num_queues, levels)
+    return blocks
+end
+
+-- パイプラインPostEffectの依存関係付きキューをセットアップする
+-- シーンが post_effect と post_effect_radius を持つ場合のみ有効（それ以外は従来通りレンダリング完了後に実行）
+-- @param render_blocks table レンダリングキューのブロック配列
+function RayTracer:setup_post_pipeline(render_blocks)
+    local scene_module = self.current_scene_module
+    self.post_pipelined = self.use_pipelined_post and scene_module.post_effect ~= nil
+        and scene_module.post_effect_radius ~= nil
+    if not self.post_pipelined then
+        self.data:remove_dependent_tiles("post_pipeline")
+        return
+    end
+    -- PostEffectタイルはレンダリングと同じ分割を使い、シーンの y 反転に合わせて依存関係を求める
+    BlockUtils.setup_dependent_queue(self.data, render_blocks, render_blocks, "post_pipeline",
+        scene_module.post_effect_radius, self.height)
+end
+
+-- レンダリングに使うプログレッシブプレビューのレベル（無効時はnil）
+function RayTracer:render_levels()
+    if self.use_progressive then
+        return self.PROGRESSIVE_LEVELS
+    end
+    return nil
+end
+
+-- レンダリングの進捗・スループット統計を作り直す（ワーカーはタイルごとに報告する）
+-- @param num_workers number 報告するワーカー数（ワーカーは _thread_id のスロットに書き込む）
+function RayTracer:setup_render_stats(num_workers)
+    local spp = self.current_scene_module and self.current_scene_module.samples_per_pixel or 1
+    self.render_stats = self.data:setup_render_stats("render_queue", num_workers, self.width * self.height, spp)
+    self.main_gc_collections = app.gc_stats().collections
+end
+
+-- レンダリング完了時に統計を確定し、ログに出力する
+function RayTracer:finish_render_stats()
+    local stats = self.render_stats
+    if not stats then
+        return
+    end
+    stats:finish()
+    local snapshot = stats:snapshot()
+    print(string.format("Render stats: %.2f s, %.2f Mpix/s, %.2f Msamples/s, %.2f Mrays/s",
+        snapshot.elapsed, snapshot.pixels_per_sec / 1e6, snapshot.samples_per_sec / 1e6, snapshot.rays_per_sec / 1e6))
+    if #snapshot.workers > 1 then
+        for i, worker in ipairs(snapshot.workers) do
+            print(string.format("  worker %d: %d tiles, %.2f Mpix/s, %.2f Mrays/s",
+                i - 1, worker.tiles, worker.pixels_per_sec / 1e6, worker.rays_per_sec / 1e6))
+        end
+    end
+    -- GCの統計（ワーカーはジョブごと、メインステートはレンダリング開始からの差分）
+    if #self.workers > 0 then
+        for i, worker in ipairs(self.workers) do
+            local gc = worker:gc_stats()
+            print(string.format("  worker %d GC: %d collections, %d tile steps (%.2f ms)",
+                i - 1, gc.collections, gc.steps, gc.step_ms))
+        end
+    else
+        print(string.format("  main GC: %d collections", app.gc_stats().collections - self.main_gc_collections))
+    end
+    for i, memory in ipairs(self:worker_memory_stats()) do
+        print(string.format("  worker %d Lua heap: %d allocs (%d pooled), %d frees, %.2f MB in use, %.2f MB peak, %.2f MB arena",
+            i - 1, memory.allocations, memory.pooled, memory.frees,
+            memory.bytes_in_use / MB, memory.peak_bytes / MB, memory.arena_bytes / MB))
+    end
+end
+
+-- 永続ワーカーごとのLua Stateのメモリ割り当て統計（ThreadWorker:memory_stats）
+-- @return table 統計テーブルの配列（ワーカー順）
+function RayTracer:worker_memory_stats()
+    local result = {}
+    for i, worker in ipairs(self.worker_pool) do
+        result[i] = worker:memory_stats()
+    end
+    return result
+end
+
+-- ワーカー用にカメラ状態をfloat配列として共有ストアに公開する
+-- レイアウトは CameraUtils.CAMERA_STATE_LAYOUT を参照
+function RayTracer:publish_camera_state()
+    local camera = nil
+    if self.current_scene_module and self.current_scene_module.get_camera then
+        camera = self.current_scene_module:get_camera()
+    end
+    if not camera then
+        self.data:store_remove("camera_state")
+        return
+    end
+    
+    local p, l, u = camera.position, camera.look_at, camera.up
+    self.data:store_floats("camera_state", {
+        p[1], p[2], p[3],
+        l[1], l[2], l[3],
+        u[1], u[2], u[3],
+        camera.aspect_ratio, camera.fov
+    })
 end
 
 -- スレッドレンダリングを開始（ブロック単位分割、9スレッド制限）
 function RayTracer:start_render_threads()
-    local json = require("lib.json")
-    
     -- Stop any existing coroutine
     self.render_coroutine = nil
     
     -- 既存のワーカーをクリア
     self.workers = {}
     
-    self:setup_blocks("render_queue")
+    local blocks = self:setup_blocks("render_queue", self:render_levels())
+    self:setup_post_pipeline(blocks)
+    self:setup_render_stats(self.NUM_THREADS)
 
-    -- ワーカーを作成して開始
+    -- カメラ情報を共有ストアに公開（もし存在すれば）
+    self:publish_camera_state()
     
-    -- カメラ情報をシリアライズ（もし存在すれば）
-    if self.current_scene_module and self.current_scene_module.get_camera then
-        local camera = self.current_scene_module:get_camera()
-        if camera then
-            -- get_state()が実装されている前提、無い場合は手動でテーブルを組み立てる
-            local state = camera.get_state and camera:get_state() or {
-                position = camera.position,
-                look_at = camera.look_at,
-                up = camera.camera_up, -- 内部変数と引数の名前差異に注意
-                aspect_ratio = camera.aspect_ratio,
-                fov = camera.fov,
-                type = camera.type
-            }
-            local camera_state_json = json.encode(state)
-            self.data:set_string("camera_state", camera_state_json)
-        else
-            self.data:set_string("camera_state", "")
-        end
-    else
-        self.data:set_string("camera_state", "")
-    end
-    
-    for i = 0, self.NUM_THREADS - 1 do
-        -- Boundsは使用しないが、一応画面全体を渡しておく
-        local worker = ThreadWorker.create(self.data, self.scene, 0, 0, self.width, self.height, i)
-        
-        -- ワーカー開始 (ブロック情報は共有キューから取得するため個別設定不要)
+    for _, worker in ipairs(self:acquire_pool_workers(self.NUM_THREADS)) do
+        -- ジョブ投入 (ブロック情報は共有キューから取得するため個別設定不要)
         worker:start("workers/ray_worker.lua", self.current_scene_type)
         table.insert(self.workers, worker)
     end
@@ -355,23 +588,26 @@ function RayTracer:create_render_coroutine()
     return coroutine.create(function()
         print("Starting single-threaded render (Coroutine)...")
         
-        self:setup_blocks("render_queue")
+        -- 中断された前回のコルーチンのスプラット設定を引き継がない
+        self.data:set_splat_size(1)
+        self:setup_blocks("render_queue", self:render_levels())
+        self:setup_render_stats(1)
         
+        -- ピクセルごとに高分解能クロックで締め切りを確認し、フレーム予算を使い切った時点でyieldする
+        local budget = self.frame_budget
         local function process_callback(app_data, x, y)
             self.current_scene_module.shade(app_data, x, y)
+            if budget:expired() then
+                coroutine.yield()
+            end
         end
         
+        -- キャンセルはコルーチンの破棄で行う
         local function check_cancel()
-            coroutine.yield()
             return false
         end
         
-        -- 1ブロック完了ごとにyield（既存の12msチェックも維持）
-        local function on_block_complete()
-            coroutine.yield()
-        end
-        
-        WorkerUtils.process_blocks(self.data, "render_queue", "render_queue_idx", process_callback, check_cancel, nil, on_block_complete)
+        WorkerUtils.process_blocks(self.data, "render_queue", 0, process_callback, check_cancel)
         
         print(string.format("Single-threaded render finished internally."))
     end)
@@ -380,6 +616,9 @@ end
 
 -- 毎フレーム呼ばれる更新処理
 function RayTracer:update()
+    -- 非同期の画像書き出しが完了していればコールバックを呼び出す
+    app.poll_saves()
+    
     -- Multi-threaded update
     if #self.workers > 0 then
         local all_done = true
@@ -396,24 +635,34 @@ function RayTracer:update()
         if all_done then
             local end_time = app.get_ticks()
             print(string.format("Lua render finished (Multi-threaded). Time: %d ms", end_time - self.render_start_time))
+            self:finish_render_stats()
             self.workers = {} -- 完了
             
+            if self.post_pipelined then
+                -- PostEffectはレンダリングと並行して完了済み: BACK(レンダリング結果) → FRONT、SPARE(PostEffect結果) → FRONT の順に回転
+                self.data:present()
+                self.data:present()
+                self:update_texture()
             -- PostEffectが存在する場合は開始
-            if self.current_scene_module.post_effect then
+            elseif self.current_scene_module.post_effect then
                 self:start_posteffect()
             else
-                -- PostEffect無しの場合はswapしてフロントに反映
-                self.data:swap()
-                self.data:clear_back_buffer()
+                -- PostEffect無しの場合はバッファを回転してフロントに反映
+                self.data:present()
                 self:update_texture()
             end
+            if not self.current_scene_module.post_effect or self.post_pipelined then
+                self:finish_profile()
+            end
         end
     
     -- Single-threaded coroutine update
     elseif self.render_coroutine then
         local status = coroutine.status(self.render_coroutine)
         if status == "suspended" then
+            self.frame_budget:begin_frame()
             local success, err = coroutine.resume(self.render_coroutine)
+            self.frame_budget:end_frame()
             if not success then
                 print("Coroutine error: " .. tostring(err))
                 self.render_coroutine = nil
@@ -422,16 +671,17 @@ function RayTracer:update()
         elseif status == "dead" then
             local end_time = app.get_ticks()
             print(string.format("Single-threaded render finished. Time: %d ms", end_time - self.render_start_time))
+            self:finish_render_stats()
             self.render_coroutine = nil
             
             -- PostEffectが存在する場合は開始
             if self.current_scene_module.post_effect then
                 self:start_posteffect()
             else
-                -- PostEffect無しの場合はswapしてフロントに反映
-                self.data:swap()
-                self.data:clear_back_buffer()
+                -- PostEffect無しの場合はバッファを回転してフロントに反映
+                self.data:present()
                 self:update_texture()
+                self:finish_profile()
                 
                 -- シーン終了
                 if self.current_scene_module and self.current_scene_module.stop then
@@ -457,17 +707,19 @@ function RayTracer:update()
             local end_time = app.get_ticks()
             print(string.format("PostEffect finished (Multi-threaded). Time: %d ms", end_time - self.render_start_time))
             self.posteffect_workers = {}
-            -- PostEffect完了後にswap
-            self.data:swap()
-            self.data:clear_back_buffer()
+            -- PostEffect完了後にバッファを回転してフロントに反映
+            self.data:present()
             self:update_texture()
+            self:finish_profile()
         end
     
     -- PostEffect Single-threaded coroutine update
     elseif self.posteffect_coroutine then
         local status = coroutine.status(self.posteffect_coroutine)
         if status == "suspended" then
+            self.frame_budget:begin_frame()
             local success, err = coroutine.resume(self.posteffect_coroutine)
+            self.frame_budget:end_frame()
             if not success then
                 print("PostEffect Coroutine error: " .. tostring(err))
                 self.posteffect_coroutine = nil
@@ -478,6 +730,7 @@ function RayTracer:update()
             print(string.format("PostEffect finished. Time: %d ms", end_time - self.render_start_time))
             self.posteffect_coroutine = nil
             self:update_texture()
+            self:finish_profile()
             
             -- シーン終了
             if self.current_scene_module and self.current_scene_module.stop then
@@ -495,6 +748,11 @@ function RayTracer:render()
     self.data:clear()
     self:update_texture()
 
+    -- 中断された前回のレンダリングのサンプルを混ぜない
+    if self.profile_lua then
+        self:take_profile()
+    end
+
     if self.use_multithreading then
         self:start_render_threads()
     else
@@ -506,10 +764,9 @@ end
 function RayTracer:start_posteffect()
     print("Starting PostEffect...")
     
-    -- swap: フロントバッファ(完成画像) → バックバッファ(読み取り元)
-    -- バックバッファ → フロントバッファへ書き込んで次回swap
-    self.data:swap()
-    self.data:clear_back_buffer()
+    -- バッファを回転: 完成したレンダリング結果がフロント(読み取り元)になり、
+    -- 待機中のバッファがバックバッファ(書き込み先)になる。完了時に再度回転して表示する
+    self.data:present()
     
     if self.use_multithreading then
         self:start_posteffect_threads()
@@ -520,18 +777,12 @@ end
 
 -- PostEffectスレッドを開始（ブロック単位分割、スレッド制限）
 function RayTracer:start_posteffect_threads()
-    local json = require("lib.json")
-    
     self.posteffect_workers = {}
     
     self:setup_blocks("posteffect_queue")
     
-    -- 各スレッドに対してワーカーを起動
-    for i = 0, self.NUM_THREADS - 1 do
-        -- Boundsは使用しないが画面全体を渡す
-        local worker = ThreadWorker.create(
-            self.data, self.scene, 0, 0, self.width, self.height, i
-        )
+    -- レンダリングと同じ永続ワーカーにPostEffectジョブを投入
+    for _, worker in ipairs(self:acquire_pool_workers(self.NUM_THREADS)) do
         worker:start("workers/posteffect_worker.lua", self.current_scene_type)
         table.insert(self.posteffect_workers, worker)
     end
@@ -543,27 +794,25 @@ function RayTracer:create_posteffect_coroutine()
     return coroutine.create(function()
         print("Starting PostEffect (Coroutine)...")
         
+        self.data:set_splat_size(1)
         self:setup_blocks("posteffect_queue")
         
+        local budget = self.frame_budget
         local function process_callback(app_data, x, y)
             self.current_scene_module.post_effect(app_data, x, y)
+            if budget:expired() then
+                coroutine.yield()
+            end
         end
         
         local function check_cancel()
-            coroutine.yield()
             return false
         end
         
-        -- 1ブロック完了ごとにyield（既存の12msチェックも維持）
-        local function on_block_complete()
-            coroutine.yield()
-        end
+        WorkerUtils.process_blocks(self.data, "posteffect_queue", 0, process_callback, check_cancel)
         
-        WorkerUtils.process_blocks(self.data, "posteffect_queue", "posteffect_queue_idx", process_callback, check_cancel, nil, on_block_complete)
-        
-        -- PostEffect完了後にswap
-        self.data:swap()
-        self.data:clear_back_buffer()
+        -- PostEffect完了後にバッファを回転してフロントに反映
+        self.data:present()
     end)
 end
 
@@ -605,7 +854,7 @@ function RayTracer:on_ui()
                     if i ~= self.thread_preset_index then
                         self:cancel_if_rendering()
                         self.thread_preset_index = i
-                        self.NUM_THREADS = preset.value
+                        self.NUM_THREADS = self:resolve_thread_count(preset.value)
                         self:reset_workers()
                     end
                 end
@@ -632,6 +881,54 @@ function RayTracer:on_ui()
             ImGui.EndCombo()
         end
 
+        -- Lua GCのモードとペース配分（ワーカーは次のレンダリングから反映）
+        local gc_presets = ThreadPresets.get_gc_presets()
+        local gc_preview = gc_presets[self.gc_preset_index] and gc_presets[self.gc_preset_index].name or "Unknown"
+        if ImGui.BeginCombo("Lua GC", gc_preview) then
+            for i, preset in ipairs(gc_presets) do
+                local is_selected = (i == self.gc_preset_index)
+                if ImGui.Selectable(preset.name, is_selected) then
+                    if i ~= self.gc_preset_index then
+                        self:set_gc_preset(i)
+                    end
+                end
+            end
+            ImGui.EndCombo()
+        end
+
+        -- プログレッシブプレビュー（8x8 → 4x4 → 2x2 → 1x1）
+        local progressive_changed, progressive = ImGui.Checkbox("Progressive Preview", self.use_progressive)
+        if progressive_changed then
+            self:cancel_if_rendering()
+            self.use_progressive = progressive
+            self:render()
+        end
+
+        -- シングルスレッド時に1フレームで描画に使う時間（残りはUIの更新に使う）
+        local budget_changed, budget_ms = ImGui.InputInt("Frame Budget (ms)", self.frame_budget.budget_ms)
+        if budget_changed then
+            self.frame_budget:set_budget_ms(budget_ms)
+        end
+
+        -- パイプラインPostEffect（レンダリング済みタイルの周辺から順にPostEffectを適用）
+        local pipelined_changed, pipelined = ImGui.Checkbox("Pipelined PostEffect", self.use_pipelined_post)
+        if pipelined_changed then
+            self:cancel_if_rendering()
+            self.use_pipelined_post = pipelined
+            self:render()
+        end
+
+        -- Lua のサンプリングプロファイラ（レンダリング完了時に profile_*.folded とレポートを出力）
+        local profile_changed, profile = ImGui.Checkbox("Profile Lua (flame graph)", self.profile_lua)
+        if profile_changed then
+            self:cancel_if_rendering()
+            self:set_profiling(profile)
+            self:render()
+        end
+        if self.profile_lua and self.last_profile_path then
+            ImGui.Text("Last profile: " .. self.last_profile_path)
+        end
+
         ImGui.Separator()
         
         -- Resolution Presets Selection
@@ -719,6 +1016,17 @@ function RayTracer:on_ui()
         end
         ImGui.EndDisabled()
 
+        -- 表示中の画像を保存（レンダリング中は無効）
+        ImGui.BeginDisabled(is_rendering)
+        if ImGui.Button("Save PNG") then
+            self:save_image("png")
+        end
+        ImGui.SameLine()
+        if ImGui.Button("Save EXR") then
+            self:save_image("exr")
+        end
+        ImGui.EndDisabled()
+
         
         ImGui.Separator()
         
@@ -733,10 +1041,72 @@ function RayTracer:on_ui()
         else
             ImGui.Text("Status: Idle")
         end
+
+        self:draw_render_stats()
     end
     ImGui.End()
 end
 
+-- レンダリングの進捗・ETA・ワーカーごとのスループットを表示する
+function RayTracer:draw_render_stats()
+    if not self.render_stats then
+        return
+    end
+    local snapshot = self.render_stats:snapshot()
+    local overlay
+    if snapshot.finished then
+        overlay = string.format("Done in %.2f s", snapshot.elapsed)
+    elseif snapshot.eta < 0 then
+        overlay = string.format("%.0f%%", snapshot.progress * 100)
+    else
+        overlay = string.format("%.0f%% (ETA %.1f s)", snapshot.progress * 100, snapshot.eta)
+    end
+    ImGui.ProgressBar(snapshot.progress, overlay)
+    ImGui.Text(string.format("%.2f Mpix/s  %.2f Msamples/s  %.2f Mrays/s",
+        snapshot.pixels_per_sec / 1e6, snapshot.samples_per_sec / 1e6, snapshot.rays_per_sec / 1e6))
+    if #snapshot.workers > 1 then
+        for i, worker in ipairs(snapshot.workers) do
+            ImGui.Text(string.format("  #%d: %d tiles  %.2f Mpix/s  %.2f Mrays/s",
+                i - 1, worker.tiles, worker.pixels_per_sec / 1e6, worker.rays_per_sec / 1e6))
+        end
+    end
+    local memory = self:worker_memory_stats()
+    if #memory > 0 then
+        local allocations, in_use, peak = 0, 0, 0
+        for _, worker in ipairs(memory) do
+            allocations = allocations + worker.allocations
+            in_use = in_use + worker.bytes_in_use
+            peak = peak + worker.peak_bytes
+        end
+        ImGui.Text(string.format("Lua heap: %.2f MB (peak %.2f MB)  %d allocs",
+            in_use / MB, peak / MB, allocations))
+        local collections, step_ms = 0, 0
+        for _, worker in ipairs(self.worker_pool) do
+            local gc = worker:gc_stats()
+            collections = collections + gc.collections
+            step_ms = step_ms + gc.step_ms
+        end
+        ImGui.Text(string.format("Lua GC: %d collections  %.2f ms in tile steps", collections, step_ms))
+    end
+end
+
+-- 表示中の画像をバックグラウンドで保存する
+-- @param format string "png" / "pfm" / "exr"
+function RayTracer:save_image(format)
+    local path = string.format("render_%s.%s", os.date("%Y%m%d_%H%M%S"), format)
+    local id, err = self.data:save_async(path, format, function(success, saved_path, error_message)
+        if success then
+            print("Saved image: " .. saved_path)
+        else
+            print("Failed to save image: " .. tostring(error_message))
+        end
+    end)
+    if not id then
+        print("Failed to save image: " .. tostring(err))
+    end
+    return id
+end
+
 -- マウス入力を処理してカメラを回転させる
 function RayTracer:handle_mouse()
     if not app.get_mouse_state then return end
@@ -3,6 +3,9 @@
 
 local ThreadPresets = {}
 
+-- ホストの論理CPU数に合わせる「Auto」プリセットの値
+ThreadPresets.AUTO = 0
+
 -- スレッド数プリセット
 local thread_presets = {
     { value = 1, name = "1" },
@@ -11,6 +14,7 @@ local thread_presets = {
     { value = 8, name = "8" },
     { value = 16, name = "16" },
     { value = 32, name = "32" },
+    { value = ThreadPresets.AUTO, name = "Auto" },
 }
 
 -- ブロックサイズプリセット
@@ -21,12 +25,24 @@ local block_presets = {
     { value = 512, name = "512" },
 }
 
+-- Lua GCプリセット（value は worker:set_gc_settings / app.set_gc_settings に渡す設定テーブル）
+-- tile_step_kb を指定すると、ワーカーはシェーディング中の自動GCを止めてタイルの境界でGCを進める
+local gc_presets = {
+    { value = { mode = "incremental" }, name = "Incremental" },
+    { value = { mode = "generational" }, name = "Generational" },
+    { value = { mode = "incremental", tile_step_kb = 256 }, name = "Incremental (Tile Steps)" },
+    { value = { mode = "generational", tile_step_kb = 256 }, name = "Generational (Tile Steps)" },
+}
+
 -- デフォルトインデックス (8スレッド)
 local default_thread_index = 4
 
 -- デフォルトインデックス (64ブロック)
 local default_block_index = 1
 
+-- デフォルトインデックス (Lua 5.4 の既定のインクリメンタルGC)
+local default_gc_index = 1
+
 -- スレッド数プリセット一覧を取得
 function ThreadPresets.get_thread_presets()
     return thread_presets
@@ -37,6 +53,16 @@ function ThreadPresets.get_block_presets()
     return block_presets
 end
 
+-- Lua GCプリセット一覧を取得
+function ThreadPresets.get_gc_presets()
+    return gc_presets
+end
+
+-- Lua GCデフォルトインデックスを取得
+function ThreadPresets.get_default_gc_index()
+    return default_gc_index
+end
+
 -- スレッド数デフォルトインデックスを取得
 function ThreadPresets.get_default_thread_index()
     return default_thread_index
@@ -57,6 +83,20 @@ function ThreadPresets.find_thread_index(value)
     return nil
 end
 
+-- プリセット値を実際のスレッド数に変換する
+-- @param value number プリセット値（ThreadPresets.AUTO の場合はホストの論理CPU数）
+-- @param hardware_threads number|nil ホストの論理CPU数（不明な場合は nil）
+-- @return number 1以上のスレッド数
+function ThreadPresets.resolve_thread_count(value, hardware_threads)
+    if value == ThreadPresets.AUTO then
+        if hardware_threads and hardware_threads > 0 then
+            return hardware_threads
+        end
+        return thread_presets[default_thread_index].value
+    end
+    return value
+end
+
 -- 値からブロックサイズプリセットのインデックスを逆引き
 function ThreadPresets.find_block_index(value)
     for i, preset in ipairs(block_presets) do
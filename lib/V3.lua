@@ -0,0 +1,94 @@
+-- lib/V3.lua
+-- 割り当てなしのベクトル演算（ベクトルを x, y, z の3つの数値として扱う）
+-- ネイティブモジュール（グローバル v3）があればそれを返し、無ければ同じAPIのLua実装を返す
+-- シェーディングのホットパスで Vec3 テーブルを作らないために使う
+
+local native = rawget(_G, "v3")
+if native then
+    return native
+end
+
+local sqrt, abs = math.sqrt, math.abs
+
+local V3 = {}
+
+function V3.add(ax, ay, az, bx, by, bz)
+    return ax + bx, ay + by, az + bz
+end
+
+function V3.sub(ax, ay, az, bx, by, bz)
+    return ax - bx, ay - by, az - bz
+end
+
+-- 要素ごとの積
+function V3.mul(ax, ay, az, bx, by, bz)
+    return ax * bx, ay * by, az * bz
+end
+
+function V3.scale(ax, ay, az, s)
+    return ax * s, ay * s, az * s
+end
+
+-- a + b * s
+function V3.madd(ax, ay, az, bx, by, bz, s)
+    return ax + bx * s, ay + by * s, az + bz * s
+end
+
+function V3.dot(ax, ay, az, bx, by, bz)
+    return ax * bx + ay * by + az * bz
+end
+
+function V3.cross(ax, ay, az, bx, by, bz)
+    return ay * bz - az * by, az * bx - ax * bz, ax * by - ay * bx
+end
+
+function V3.length_squared(x, y, z)
+    return x * x + y * y + z * z
+end
+
+function V3.length(x, y, z)
+    return sqrt(x * x + y * y + z * z)
+end
+
+-- 長さ0の場合は 0, 0, 0
+function V3.normalize(x, y, z)
+    local len = sqrt(x * x + y * y + z * z)
+    if len > 0 then
+        return x / len, y / len, z / len
+    end
+    return 0, 0, 0
+end
+
+function V3.near_zero(x, y, z)
+    local s = 1e-8
+    return abs(x) < s and abs(y) < s and abs(z) < s
+end
+
+function V3.reflect(vx, vy, vz, nx, ny, nz)
+    local d = 2 * (vx * nx + vy * ny + vz * nz)
+    return vx - nx * d, vy - ny * d, vz - nz * d
+end
+
+-- 屈折ベクトル（スネルの法則、u は単位ベクトル）
+function V3.refract(ux, uy, uz, nx, ny, nz, etai_over_etat)
+    local cos_theta = math.min(-(ux * nx + uy * ny + uz * nz), 1.0)
+    local px = (ux + nx * cos_theta) * etai_over_etat
+    local py = (uy + ny * cos_theta) * etai_over_etat
+    local pz = (uz + nz * cos_theta) * etai_over_etat
+    local k = -sqrt(abs(1.0 - (px * px + py * py + pz * pz)))
+    return px + nx * k, py + ny * k, pz + nz * k
+end
+
+-- 法線 w に直交する正規直交基底 -> wx, wy, wz, ux, uy, uz, vx, vy, vz
+function V3.onb(nx, ny, nz)
+    local wx, wy, wz = V3.normalize(nx, ny, nz)
+    local ax, ay = 0, 1
+    if not (abs(wx) > 1e-6) then
+        ax, ay = 1, 0
+    end
+    local ux, uy, uz = V3.normalize(ay * wz, -ax * wz, ax * wy - ay * wx)
+    local vx, vy, vz = wy * uz - wz * uy, wz * ux - wx * uz, wx * uy - wy * ux
+    return wx, wy, wz, ux, uy, uz, vx, vy, vz
+end
+
+return V3
@@ -89,23 +89,36 @@ function Vec3:near_zero()
     return math.abs(self.x) < s and math.abs(self.y) < s and math.abs(self.z) < s
 end
 
--- 単位球内のランダムベクトル
-function Vec3.random_in_unit_sphere()
+-- 単位球内のランダムな点（x, y, z の多値で返し、テーブルを作らない）
+function Vec3.random_in_unit_sphere_xyz()
     while true do
-        local p = Vec3.new(
-            math.random() * 2 - 1,
-            math.random() * 2 - 1,
-            math.random() * 2 - 1
-        )
-        if p:length_squared() < 1 then
-            return p
+        local x = math.random() * 2 - 1
+        local y = math.random() * 2 - 1
+        local z = math.random() * 2 - 1
+        if x * x + y * y + z * z < 1 then
+            return x, y, z
         end
     end
 end
 
+-- 単位球面上のランダムな点（x, y, z の多値）
+function Vec3.random_unit_vector_xyz()
+    local x, y, z = Vec3.random_in_unit_sphere_xyz()
+    local len = math.sqrt(x * x + y * y + z * z)
+    if len > 0 then
+        return x / len, y / len, z / len
+    end
+    return 0, 0, 0
+end
+
+-- 単位球内のランダムベクトル
+function Vec3.random_in_unit_sphere()
+    return Vec3.new(Vec3.random_in_unit_sphere_xyz())
+end
+
 -- 単位ベクトル（単位球面上のランダム点）
 function Vec3.random_unit_vector()
-    return Vec3.random_in_unit_sphere():normalize()
+    return Vec3.new(Vec3.random_unit_vector_xyz())
 end
 
 -- 半球内のランダムベクトル
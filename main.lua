@@ -30,4 +30,5 @@ end
 function app.on_quit()
     print("Terminating workers before quit...")
     raytracer:terminate_workers()
+    raytracer:release_worker_pool()
 end
@@ -5,12 +5,11 @@
 local M = {}
 
 -- モジュール
-local Vec3 = require('lib.Vec3')
-local Ray = require('lib.Ray')
 local Material = require('lib.Material')
 local Camera = require('lib.Camera')
 local PathTracer = require('lib.PathTracer')
 local BilateralFilter = require('lib.BilateralFilter')
+local FastPath = require('lib.FastPath')
 
 -- モジュール内変数
 local scene = nil
@@ -24,6 +23,10 @@ local materials = {}
 -- 設定
 local SAMPLES_PER_PIXEL = 32  -- サンプル数（品質重視）
 local MAX_DEPTH = 10          -- レイの最大再帰深度
+-- AOV（法線・深度・アルベド・ID）ガイド付きのノイズ除去（既定は無効）
+-- 有効にするとサンプル数を 8 程度まで下げても見られる画質になり速く描けるが、
+-- 細かい陰影やコースティクスがぼけるため 32 サンプルの結果と同じ品質にはならない
+local GUIDED_DENOISE = false
 
 -- ===========================================
 -- シーンインターフェース
@@ -81,44 +84,32 @@ function M.setup(embree_scene, app_data)
     geomID = embree_scene:add_sphere(50.0, 90.0, 81.6, 15.0)
     material_data[tostring(geomID)] = {type = "diffuse_light", emit = {50, 50, 50}}
     
-    -- JSONにシリアライズしてapp_dataに保存
-    local json = require("lib.json")
-    local json_str = json.encode(material_data)
-    app_data:set_string("materials", json_str)
+    -- ポストエフェクトのガイドに使うAOVバッファを確保（ワーカー起動前に行う）
+    if GUIDED_DENOISE then
+        app_data:enable_aovs()
+    end
+    
+    -- フラットなfloat配列として共有ストアに保存
+    app_data:store_floats("materials", Material.pack(material_data))
     
-    print("Cornell Box setup complete. Material data saved to app_data")
+    print("Cornell Box setup complete. Material data saved to app_data store")
 end
 
 -- シーンの開始: カメラとローカル変数の初期化
 function M.start(embree_scene, app_data)
     print("Start Cornell Box Scene...")
-    scene = embree_scene
+    -- intersect はホットパスのため sol2 を経由しない高速パスを使う
+    scene = FastPath.scene(embree_scene)
     width = app_data:width()
     height = app_data:height()
     local aspect_ratio = width / height
     
-    -- app_dataからマテリアルデータを取得してMaterialオブジェクトを再構築
+    -- 共有ストアのスナップショットからMaterialオブジェクトを再構築（コピー・デコード不要）
     materials = {}
-    local json = require("lib.json")
-    local json_str = app_data:get_string("materials")
-    
-    if json_str and json_str ~= "" then
-        local material_data = json.decode(json_str)
-        for key, data in pairs(material_data) do
-            local geomID = tonumber(key)
-            if data.type == "lambertian" then
-                local albedo = Vec3.new(data.albedo[1], data.albedo[2], data.albedo[3])
-                materials[geomID] = Material.Lambertian(albedo)
-            elseif data.type == "metal" then
-                local albedo = Vec3.new(data.albedo[1], data.albedo[2], data.albedo[3])
-                materials[geomID] = Material.Metal(albedo, data.fuzz)
-            elseif data.type == "dielectric" then
-                materials[geomID] = Material.Dielectric(data.ir)
-            elseif data.type == "diffuse_light" then
-                local emit = Vec3.new(data.emit[1], data.emit[2], data.emit[3])
-                materials[geomID] = Material.DiffuseLight(emit)
-            end
-        end
+    local packed = app_data:store_get(FastPath.store_slot(app_data, "materials"))
+    
+    if packed then
+        materials = Material.unpack(packed)
         print("Materials deserialized successfully")
     else
         print("Warning: No materials found in app_data!")
@@ -140,9 +131,28 @@ function M.start(embree_scene, app_data)
     print("Camera initialized")
 end
 
+-- 1サンプル目の経路の最初の交差をAOVとして書き込む（AOVのためにレイを追加で飛ばさない）
+-- @param dx, dy, dz number 一次レイの方向
+-- @param t number|nil 最初の交差までの距離（当たらなかった場合は nil）
+-- @param nx, ny, nz number レイの反対側を向いた法線
+local function write_aovs(data, x, flip_y, dx, dy, dz, t, nx, ny, nz, geomID)
+    if not t then
+        data:set_aov(x, flip_y, 0, 0, 0, 0, 0, 0, 0, -1)
+        return
+    end
+    
+    -- 深度はカメラの前方向に沿った距離とする
+    local forward = camera.forward
+    local depth = t * (dx * forward[1] + dy * forward[2] + dz * forward[3])
+    local ar, ag, ab = Material.aov_albedo(materials[geomID])
+    data:set_aov(x, flip_y, ar, ag, ab, nx, ny, nz, depth, geomID)
+end
+
 -- ピクセルの色を計算（パストレーシング）
-function M.shade(data, x, y)
-    local color = Vec3.new(0, 0, 0)
+-- 行の定数（反転した y、set_pixel の高速パス）は呼び出し側で求めて渡す
+local function shade_pixel(data, set_pixel, x, y, flip_y)
+    -- ベクトルは数値のまま累積し、サンプルごとにテーブルを作らない
+    local cr, cg, cb = 0, 0, 0
     
     -- アンチエイリアシング: 複数サンプルの平均
     for s = 1, SAMPLES_PER_PIXEL do
@@ -152,34 +162,58 @@ function M.shade(data, x, y)
         
         -- カメラからレイを生成
         local ox, oy, oz, dx, dy, dz = camera:generate_ray(u, v)
-        local origin = Vec3.new(ox, oy, oz)
-        local direction = Vec3.new(dx, dy, dz)
-        local ray = Ray.new(origin, direction)
         
-        -- パストレーシングで放射輝度を計算
-        color = color + PathTracer.radiance(ray, scene, materials, MAX_DEPTH)
+        -- パストレーシングで放射輝度を計算（最初の交差も受け取る）
+        local lr, lg, lb, t, nx, ny, nz, geomID = PathTracer.radiance_xyz(ox, oy, oz, dx, dy, dz, scene, materials, MAX_DEPTH)
+        cr, cg, cb = cr + lr, cg + lg, cb + lb
+        if GUIDED_DENOISE and s == 1 then
+            write_aovs(data, x, flip_y, dx, dy, dz, t, nx, ny, nz, geomID)
+        end
     end
     
     -- サンプル平均
     local scale = 1.0 / SAMPLES_PER_PIXEL
-    local r = math.sqrt(color.x * scale)  -- ガンマ補正 (gamma = 2)
-    local g = math.sqrt(color.y * scale)
-    local b = math.sqrt(color.z * scale)
+    local r = math.sqrt(cr * scale)  -- ガンマ補正 (gamma = 2)
+    local g = math.sqrt(cg * scale)
+    local b = math.sqrt(cb * scale)
     
     -- クランプ
     r = math.min(1.0, math.max(0.0, r))
     g = math.min(1.0, math.max(0.0, g))
     b = math.min(1.0, math.max(0.0, b))
     
+    set_pixel(data, x, flip_y, math.floor(255 * r), math.floor(255 * g), math.floor(255 * b))
+end
+
+function M.shade(data, x, y)
     -- Y座標を上下反転
+    shade_pixel(data, FastPath.method(data, "set_pixel"), x, y, height - 1 - y)
+end
+
+-- 1行分のスパン（x0, x0 + step, ... <= x1）をまとめて処理する（ワーカーは shade より優先して呼ぶ）
+function M.shade_span(data, x0, x1, y, step)
+    local set_pixel = FastPath.method(data, "set_pixel")
     local flip_y = height - 1 - y
-    
-    data:set_pixel(x, flip_y, math.floor(255 * r), math.floor(255 * g), math.floor(255 * b))
+    for x = x0, x1, step do
+        shade_pixel(data, set_pixel, x, y, flip_y)
+    end
 end
 
+-- 進捗表示用: 1ピクセルあたりのサンプル数
+M.samples_per_pixel = SAMPLES_PER_PIXEL
+
+-- パイプラインPostEffect用: post_effect が読み取る近傍の半径（ピクセル）
+M.post_effect_radius = BilateralFilter.RADIUS
+
 -- ポストエフェクト: バイラテラルフィルタによるノイズ低減
+-- GUIDED_DENOISE が有効な場合は AOV ガイド付きのフィルタを使う
 function M.post_effect(data, x, y)
-    local r, g, b = BilateralFilter.filter(data, x, y)
+    local r, g, b
+    if GUIDED_DENOISE then
+        r, g, b = BilateralFilter.filter_guided(data, x, y)
+    else
+        r, g, b = BilateralFilter.filter(data, x, y)
+    end
     data:set_pixel(x, y, r, g, b)
 end
 
@@ -28,14 +28,9 @@ function M.setup(embree_scene, app_data)
 
     print("glTF loaded: " .. gltf:get_mesh_count() .. " mesh(es)")
 
-    -- 各メッシュのプリミティブをシーンに追加
-    for i = 0, gltf:get_mesh_count() - 1 do
-        local vertices = gltf:get_vertices(i, 0)
-        local indices = gltf:get_indices(i, 0)
-        if #vertices > 0 and #indices > 0 then
-            local geomID = embree_scene:add_mesh(vertices, indices)
-            print("  Mesh " .. i .. ": " .. (#vertices / 3) .. " vertices, " .. (#indices / 3) .. " triangles -> geomID=" .. geomID)
-        end
+    -- ノード階層を辿り、すべてのプリミティブをノードの変換付きでシーンに追加
+    for _, geometry in ipairs(gltf:instantiate(embree_scene)) do
+        print("  Node " .. geometry.node .. " mesh " .. geometry.mesh .. " primitive " .. geometry.primitive .. " -> geomID=" .. geometry.geom_id)
     end
 
     print("glTF Box Scene setup complete!")
@@ -4,6 +4,7 @@
 -- app_data のキャッシュ機構を使用してデータを共有する
 
 local Texture = require("lib.Texture")
+local MaterialGraph = require("lib.MaterialGraph")
 
 local M = {}
 
@@ -13,14 +14,19 @@ local camera = nil
 local width = 0
 local height = 0
 
--- テクスチャ関連データ（各スレッドの start で初期化）
-local textures = {}    -- テクスチャオブジェクト配列（テクスチャインデックス → Texture）
-local texcoords = nil  -- UV座標（フラット配列）
-local indices = nil    -- インデックス配列
+-- ジオメトリごとのシェーディングデータ（各スレッドの start で初期化）
+-- geomID -> { material = テクスチャ × ディフューズのマテリアルグラフ（C++ で評価）, texcoords = UV座標, indices = インデックス配列 }
+local geometries = {}
 
 -- glTF キャッシュ名
 local GLTF_NAME = "box_textured"
 local GLTF_PATH = "assets/BoxTextured.glb"
+local MATERIAL_NAME = "box_textured"
+
+-- baseColor テクスチャ番号ごとのマテリアル名（テクスチャなしは "none"）
+local function material_name(texture)
+    return MATERIAL_NAME .. "." .. (texture or "none")
+end
 
 -- ライト方向（XYZ = 1, 2, 3 を正規化）
 local lx, ly, lz = 1.0, 2.0, 3.0
@@ -32,40 +38,50 @@ function M.setup(embree_scene, app_data)
     print("Setup glTF Box Textured Scene...")
 
     -- glTF をロードして app_data にキャッシュ
-    local ok = app_data:load_gltf(GLTF_NAME, GLTF_PATH)
+    -- テクスチャはバックグラウンドで並列にデコードされ "<GLTF_NAME>_tex<番号>" でキャッシュされる（下の load_texture_image はキャッシュを使う）
+    local loading = app_data:load_gltf_async(GLTF_NAME, GLTF_PATH)
+    local ok, err = loading:wait()
     if not ok then
-        print("Error: " .. GLTF_PATH .. " の読み込みに失敗しました")
+        print("Error: " .. GLTF_PATH .. " の読み込みに失敗しました: " .. tostring(err))
         return
     end
 
     local mesh_count = app_data:get_gltf_mesh_count(GLTF_NAME)
     print("glTF loaded: " .. mesh_count .. " mesh(es)")
 
-    -- テクスチャ画像をデコードしてキャッシュ（複数テクスチャ対応）
-    -- BoxTextured.glb にはテクスチャが1つだが、汎用的にループ
-    local tex_idx = 0
-    while true do
-        local tex_name = GLTF_NAME .. "_tex" .. tex_idx
-        local loaded = app_data:load_texture_image(tex_name, GLTF_NAME, tex_idx)
-        if not loaded then break end
-        print("  Texture " .. tex_idx .. " cached as '" .. tex_name .. "'")
-        tex_idx = tex_idx + 1
-    end
-
-    -- 各メッシュのプリミティブをシーンに追加
-    for i = 0, mesh_count - 1 do
-        local vertices = app_data:get_gltf_vertices(GLTF_NAME, i, 0)
-        local mesh_indices = app_data:get_gltf_indices(GLTF_NAME, i, 0)
-        if vertices and mesh_indices and #vertices > 0 and #mesh_indices > 0 then
-            local geomID = embree_scene:add_mesh(vertices, mesh_indices)
-            print("  Mesh " .. i .. ": " .. (#vertices / 3) .. " vertices, " .. (#mesh_indices / 3) .. " triangles -> geomID=" .. geomID)
+    -- ノード階層を辿り、すべてのプリミティブをノードの変換付きでシーンに追加
+    -- （複数ノードが共有するメッシュは Embree インスタンスになる。一覧は app_data に記録され start で参照する）
+    local added = app_data:instantiate_gltf(embree_scene, GLTF_NAME)
+
+    -- マテリアル: テクスチャ色 × (アンビエント 0.15 + ディフューズ 0.85 × n·l)
+    -- プリミティブの baseColor テクスチャごとに1つ。テクスチャがない・読み込めない場合はグレー
+    local compiled = {}
+    for _, geometry in ipairs(added) do
+        local name = material_name(geometry.texture)
+        if not compiled[name] then
+            compiled[name] = true
+            local graph = MaterialGraph.new()
+            local albedo = graph:constant(200 / 255)
+            if geometry.texture then
+                local tex_name = GLTF_NAME .. "_tex" .. geometry.texture
+                if app_data:load_texture_image(tex_name, GLTF_NAME, geometry.texture) then
+                    print("  Texture " .. geometry.texture .. " cached as '" .. tex_name .. "'")
+                    albedo = graph:texture(tex_name)
+                end
+            end
+            local shading = graph:add(graph:constant(0.15), graph:mul(graph:lambert(graph:constant(1.0)), graph:constant(0.85)))
+            local ok, err = graph:compile(app_data, name, graph:mul(albedo, shading))
+            if not ok then
+                print("Error: material " .. name .. ": " .. tostring(err))
+            end
         end
+        print("  Node " .. geometry.node .. " mesh " .. geometry.mesh .. " primitive " .. geometry.primitive .. " -> geomID=" .. geometry.geom_id)
     end
 
     print("glTF Box Textured Scene setup complete!")
 end
 
--- シーンの開始: テクスチャ・UV データを app_data から取得（各スレッドで実行）
+-- シーンの開始: マテリアル・UV データを app_data から取得（各スレッドで実行）
 function M.start(embree_scene, app_data)
     print("Start glTF Box Textured Scene...")
     scene = embree_scene
@@ -73,26 +89,25 @@ function M.start(embree_scene, app_data)
     height = app_data:height()
     local aspect_ratio = width / height
 
-    -- app_data からテクスチャ画像を取得して Texture オブジェクトを生成
-    textures = {}
-    local tex_idx = 0
-    while true do
-        local tex_name = GLTF_NAME .. "_tex" .. tex_idx
-        local image = app_data:get_texture_image(tex_name)
-        if not image then break end
-        textures[tex_idx] = Texture.new(image.width, image.height, image.channels, image.pixels)
-        print("  Texture " .. tex_idx .. ": " .. image.width .. "x" .. image.height .. " loaded from cache")
-        tex_idx = tex_idx + 1
-    end
-
-    -- app_data から UV 座標とインデックスを取得
-    texcoords = app_data:get_gltf_tex_coords(GLTF_NAME, 0, 0)
-    indices = app_data:get_gltf_indices(GLTF_NAME, 0, 0)
-
-    if texcoords then
-        print("  UV coords: " .. #texcoords .. " floats (" .. (#texcoords / 2) .. " vertices)")
-    else
-        print("  Warning: UV座標が見つかりませんでした")
+    -- setup で追加したジオメトリごとに、マテリアル（テクスチャ画像はC++側で共有され、Luaテーブルへのコピーは不要）と
+    -- UV 座標・インデックスを取得（インスタンスは同じメッシュのデータを共有する）
+    geometries = {}
+    local primitives = {}
+    for _, geometry in ipairs(app_data:get_gltf_geometries(GLTF_NAME)) do
+        local key = geometry.mesh .. "/" .. geometry.primitive
+        local primitive = primitives[key]
+        if not primitive then
+            primitive = {
+                texcoords = app_data:get_gltf_tex_coords(GLTF_NAME, geometry.mesh, geometry.primitive),
+                indices = app_data:get_gltf_indices(GLTF_NAME, geometry.mesh, geometry.primitive),
+            }
+            primitives[key] = primitive
+        end
+        geometries[geometry.geom_id] = {
+            material = app_data:get_material(material_name(geometry.texture)),
+            texcoords = primitive.texcoords,
+            indices = primitive.indices,
+        }
     end
 
     local CameraUtils = require("lib.CameraUtils")
@@ -124,28 +139,20 @@ function M.shade(data, x, y)
     if hit then
         local r, g, b = 200, 200, 200  -- デフォルト色（グレー）
 
-        -- テクスチャサンプリング（テクスチャ0を使用、複数テクスチャの場合は拡張可能）
-        local tex = textures[0]
-        if tex and texcoords and indices then
+        local geometry = geometries[geomID]
+        if geometry and geometry.material then
             -- バリセントリック座標からUV座標を補間
-            local tex_u, tex_v = Texture.interpolate_uv(texcoords, indices, primID, baryU, baryV)
-            -- テクスチャからピクセル色を取得
-            r, g, b = tex:sample(tex_u, tex_v)
+            local tex_u, tex_v = 0, 0
+            if geometry.texcoords and geometry.indices then
+                tex_u, tex_v = Texture.interpolate_uv(geometry.texcoords, geometry.indices, primID, baryU, baryV)
+            end
+            -- テクスチャサンプリングとシェーディングは C++ で評価（0-1 の RGB）
+            local mr, mg, mb = geometry.material:eval(nx, ny, nz, -dx, -dy, -dz, lightDirX, lightDirY, lightDirZ, tex_u, tex_v)
+            r = math.floor(255 * mr)
+            g = math.floor(255 * mg)
+            b = math.floor(255 * mb)
         end
 
-        -- ディフューズシェーディング計算
-        local diffuse = nx * lightDirX + ny * lightDirY + nz * lightDirZ
-        if diffuse < 0 then diffuse = 0 end
-
-        -- アンビエント光を追加
-        diffuse = 0.15 + 0.85 * diffuse
-        if diffuse > 1.0 then diffuse = 1.0 end
-
-        -- テクスチャ色にシェーディングを適用
-        r = math.floor(r * diffuse)
-        g = math.floor(g * diffuse)
-        b = math.floor(b * diffuse)
-
         -- クランプ
         if r > 255 then r = 255 end
         if g > 255 then g = 255 end
@@ -170,9 +177,7 @@ end
 -- クリーンアップ処理
 function M.cleanup()
     camera = nil
-    textures = {}
-    texcoords = nil
-    indices = nil
+    geometries = {}
 end
 
 return M
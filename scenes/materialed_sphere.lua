@@ -1,6 +1,8 @@
 -- scenes/materialed_sphere.lua
 -- マテリアル付き球体シーンを定義するモジュール
 
+local MaterialGraph = require('lib.MaterialGraph')
+
 local M = {}
 
 -- モジュール内でシーン、カメラ、サイズを保持
@@ -9,9 +11,21 @@ local camera = nil
 local width = 0
 local height = 0
 
--- マテリアルテーブル (geomID -> Material)
+-- マテリアルテーブル (geomID -> コンパイル済みのマテリアルグラフ)
 local materials = {}
 
+-- 球体の色（setupでの追加順序 = geomID）
+local COLORS = {
+    [0] = {1.0, 0.2, 0.2}, -- 赤
+    [1] = {0.2, 1.0, 0.2}, -- 緑
+    [2] = {0.2, 0.2, 1.0}, -- 青
+    [3] = {1.0, 1.0, 0.0}, -- 黄
+}
+
+local function material_name(geomID)
+    return "materialed_sphere." .. geomID
+end
+
 -- ライト方向（正規化済み）
 local lightDirX, lightDirY, lightDirZ = 0.577, 0.577, 0.577 -- 斜め上くから
 local len = math.sqrt(lightDirX*lightDirX + lightDirY*lightDirY + lightDirZ*lightDirZ)
@@ -34,6 +48,18 @@ function M.setup(embree_scene, app_data)
     local id4 = embree_scene:add_sphere(0.0, -0.5, 1.5, 0.3)
     
     print("Spheres added. IDs:", id1, id2, id3, id4)
+
+    -- マテリアル: アンビエント光 + ディフューズ（color × (0.2 + 0.8 × n·l)）をネイティブのグラフとして登録
+    for geomID, color in pairs(COLORS) do
+        local graph = MaterialGraph.new()
+        local albedo = graph:constant(color[1], color[2], color[3])
+        local ambient = graph:mul(albedo, graph:constant(0.2))
+        local diffuse = graph:mul(graph:lambert(albedo), graph:constant(0.8))
+        local ok, err = graph:compile(app_data, material_name(geomID), graph:add(ambient, diffuse))
+        if not ok then
+            print("Error: material " .. geomID .. ": " .. tostring(err))
+        end
+    end
 end
 
 -- シーンの開始: カメラとローカル変数の初期化、マテリアルの初期化
@@ -44,12 +70,11 @@ function M.start(embree_scene, app_data)
     height = app_data:height()
     local aspect_ratio = width / height
     
-    -- マテリアルテーブルを初期化 (setupでの追加順序に依存)
+    -- setup で登録したマテリアルグラフを取得（コンパイル済みの命令列を共有するだけでコピーしない）
     materials = {}
-    materials[0] = {r = 1.0, g = 0.2, b = 0.2} -- 赤
-    materials[1] = {r = 0.2, g = 1.0, b = 0.2} -- 緑
-    materials[2] = {r = 0.2, g = 0.2, b = 1.0} -- 青
-    materials[3] = {r = 1.0, g = 1.0, b = 0.0} -- 黄
+    for geomID in pairs(COLORS) do
+        materials[geomID] = app_data:get_material(material_name(geomID))
+    end
     
     -- カメラの作成: 透視投影
     local CameraUtils = require("lib.CameraUtils")
@@ -81,27 +106,16 @@ function M.shade(data, x, y)
     if hit then
         -- マテリアル取得
         local material = materials[geomID]
-        local r, g, b = 1.0, 1.0, 1.0
+        local r, g, b
         
         if material then
-            r, g, b = material.r, material.g, material.b
+            -- シェーディングは C++ で評価（視線はヒット点からカメラへの向き）
+            r, g, b = material:eval(nx, ny, nz, -dx, -dy, -dz, lightDirX, lightDirY, lightDirZ, 0, 0)
         else
             -- マテリアルが見つからない場合はマゼンタ (デバッグ用)
             r, g, b = 1.0, 0.0, 1.0
         end
         
-        -- ディフューズシェーディング計算
-        local diffuse = nx * lightDirX + ny * lightDirY + nz * lightDirZ
-        if diffuse < 0 then diffuse = 0 end
-        
-        -- アンビエント光 + ディフューズ
-        local intensity = 0.2 + 0.8 * diffuse
-        
-        -- 色を適用
-        r = r * intensity
-        g = g * intensity
-        b = b * intensity
-        
         -- クランプ
         if r > 1.0 then r = 1.0 end
         if g > 1.0 then g = 1.0 end
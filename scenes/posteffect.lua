@@ -112,6 +112,9 @@ end
 
 -- ポストエフェクト: グレースケール変換
 -- フロントバッファから読み取り、バックバッファに書き込む
+-- パイプラインPostEffect用: post_effect は自ピクセルのみを読み取る
+M.post_effect_radius = 0
+
 function M.post_effect(data, x, y)
     local r, g, b = data:get_pixel(x, y)
     
@@ -5,11 +5,11 @@
 local M = {}
 
 -- モジュール
-local Vec3 = require('lib.Vec3')
-local Ray = require('lib.Ray')
+local V3 = require('lib.V3')
 local Material = require('lib.Material')
 local Camera = require('lib.Camera')
 local BilateralFilter = require('lib.BilateralFilter')
+local FastPath = require('lib.FastPath')
 
 -- モジュール内変数
 local scene = nil
@@ -35,63 +35,50 @@ local function random_double(min, max)
     return min + (max - min) * math.random()
 end
 
--- レイの色を計算（再帰的Path Tracing）
-local function ray_color(r, embree_scene, depth)
-    -- 再帰の深さを超えた場合は黒を返す
-    if depth <= 0 then
-        return Vec3.new(0, 0, 0)
-    end
+-- レイの色を計算（Path Tracing）
+-- 再帰の代わりに減衰率を掛け合わせながらループで追跡し、ベクトルは数値のまま扱う（テーブルを作らない）
+local function ray_color(ox, oy, oz, dx, dy, dz, embree_scene, depth)
+    local tr, tg, tb = 1, 1, 1  -- 経路の減衰率の積
     
-    -- シーンとのインターセクト判定
-    local ox, oy, oz = r.origin.x, r.origin.y, r.origin.z
-    local dx, dy, dz = r.direction.x, r.direction.y, r.direction.z
-    local hit, t, nx, ny, nz, geomID, primID = embree_scene:intersect(ox, oy, oz, dx, dy, dz)
-    
-    if hit then
-        -- ヒットポイント
-        local p = r:at(t)
-        local normal = Vec3.new(nx, ny, nz)
+    -- 再帰の深さを超えた場合は黒を返す
+    while depth > 0 do
+        -- シーンとのインターセクト判定
+        local hit, t, nx, ny, nz, geomID = embree_scene:intersect(ox, oy, oz, dx, dy, dz)
         
-        -- 表面の向き判定
-        local front_face = Vec3.dot(r.direction, normal) < 0
-        if not front_face then
-            normal = -normal
+        if not hit then
+            -- 背景（空のグラデーション）
+            local _, uy = V3.normalize(dx, dy, dz)
+            local t_bg = 0.5 * (uy + 1.0)
+            local s = 1.0 - t_bg
+            return tr * (s + 0.5 * t_bg), tg * (s + 0.7 * t_bg), tb * (s + t_bg)
         end
         
-        -- HitRecordを構築
-        local rec = {
-            p = p,
-            normal = normal,
-            t = t,
-            front_face = front_face
-        }
-        
         -- マテリアル取得
         local material = materials[geomID]
-        if material then
-            local scattered, attenuation = material:scatter(r, rec)
-            if scattered then
-                -- 再帰的にレイを追跡
-                local color = ray_color(scattered, embree_scene, depth - 1)
-                return Vec3.new(
-                    attenuation.x * color.x,
-                    attenuation.y * color.y,
-                    attenuation.z * color.z
-                )
-            end
-            return Vec3.new(0, 0, 0)
-        else
+        if not material then
             -- マテリアルがない場合はマゼンタ
-            return Vec3.new(1, 0, 1)
+            return tr, 0, tb
         end
+        
+        -- ヒットポイントと表面の向き判定
+        local px, py, pz = ox + dx * t, oy + dy * t, oz + dz * t
+        local front_face = dx * nx + dy * ny + dz * nz < 0
+        if not front_face then
+            nx, ny, nz = -nx, -ny, -nz
+        end
+        
+        local sox, soy, soz, sdx, sdy, sdz, ar, ag, ab =
+            material:scatter_xyz(dx, dy, dz, px, py, pz, nx, ny, nz, front_face)
+        if not sox then
+            return 0, 0, 0
+        end
+        
+        tr, tg, tb = tr * ar, tg * ag, tb * ab
+        ox, oy, oz, dx, dy, dz = sox, soy, soz, sdx, sdy, sdz
+        depth = depth - 1
     end
     
-    -- 背景（空のグラデーション）
-    local unit_direction = r.direction:normalize()
-    local t_bg = 0.5 * (unit_direction.y + 1.0)
-    local white = Vec3.new(1.0, 1.0, 1.0)
-    local blue = Vec3.new(0.5, 0.7, 1.0)
-    return white * (1.0 - t_bg) + blue * t_bg
+    return 0, 0, 0
 end
 
 -- ===========================================
@@ -161,41 +148,27 @@ function M.setup(embree_scene, app_data)
         end
     end
     
-    -- JSONにシリアライズしてapp_dataに保存
-    local json = require("lib.json")
-    local json_str = json.encode(material_data)
-    app_data:set_string("materials", json_str)
+    -- フラットなfloat配列として共有ストアに保存
+    app_data:store_floats("materials", Material.pack(material_data))
     
-    print("Scene setup complete. Material data saved to app_data")
+    print("Scene setup complete. Material data saved to app_data store")
 end
 
 -- シーンの開始: カメラとローカル変数の初期化
 function M.start(embree_scene, app_data)
     print("Start Ray Tracing Weekend Scene...")
-    scene = embree_scene
+    -- intersect はホットパスのため sol2 を経由しない高速パスを使う
+    scene = FastPath.scene(embree_scene)
     width = app_data:width()
     height = app_data:height()
     local aspect_ratio = width / height
     
-    -- app_dataからマテリアルデータを取得してMaterialオブジェクトを再構築
+    -- 共有ストアのスナップショットからMaterialオブジェクトを再構築（コピー・デコード不要）
     materials = {}
-    local json = require("lib.json")
-    local json_str = app_data:get_string("materials")
+    local packed = app_data:store_get(FastPath.store_slot(app_data, "materials"))
     
-    if json_str and json_str ~= "" then
-        local material_data = json.decode(json_str)
-        for key, data in pairs(material_data) do
-            local geomID = tonumber(key)
-            if data.type == "lambertian" then
-                local albedo = Vec3.new(data.albedo[1], data.albedo[2], data.albedo[3])
-                materials[geomID] = Material.Lambertian(albedo)
-            elseif data.type == "metal" then
-                local albedo = Vec3.new(data.albedo[1], data.albedo[2], data.albedo[3])
-                materials[geomID] = Material.Metal(albedo, data.fuzz)
-            elseif data.type == "dielectric" then
-                materials[geomID] = Material.Dielectric(data.ir)
-            end
-        end
+    if packed then
+        materials = Material.unpack(packed)
         print("Materials deserialized successfully")
     else
         print("Warning: No materials found in app_data!")
@@ -215,8 +188,10 @@ function M.start(embree_scene, app_data)
 end
 
 -- ピクセルの色を計算（パストレーシング）
-function M.shade(data, x, y)
-    local color = Vec3.new(0, 0, 0)
+-- 行の定数（反転した y と set_pixel の高速パス）は呼び出し側で求めて渡す
+local function shade_pixel(data, set_pixel, x, y, flip_y)
+    -- ベクトルは数値のまま累積し、サンプルごとにテーブルを作らない
+    local cr, cg, cb = 0, 0, 0
     
     -- アンチエイリアシング: 複数サンプルの平均
     for s = 1, SAMPLES_PER_PIXEL do
@@ -226,33 +201,48 @@ function M.shade(data, x, y)
         
         -- カメラからレイを生成
         local ox, oy, oz, dx, dy, dz = camera:generate_ray(u, v)
-        local origin = Vec3.new(ox, oy, oz)
-        local direction = Vec3.new(dx, dy, dz)
-        local ray = Ray.new(origin, direction)
         
         -- レイの色を計算
-        color = color + ray_color(ray, scene, MAX_DEPTH)
+        local lr, lg, lb = ray_color(ox, oy, oz, dx, dy, dz, scene, MAX_DEPTH)
+        cr, cg, cb = cr + lr, cg + lg, cb + lb
     end
     
     -- サンプル平均
     local scale = 1.0 / SAMPLES_PER_PIXEL
-    local r = math.sqrt(color.x * scale)  -- ガンマ補正 (gamma = 2)
-    local g = math.sqrt(color.y * scale)
-    local b = math.sqrt(color.z * scale)
+    local r = math.sqrt(cr * scale)  -- ガンマ補正 (gamma = 2)
+    local g = math.sqrt(cg * scale)
+    local b = math.sqrt(cb * scale)
     
     -- クランプ
     r = math.min(1.0, math.max(0.0, r))
     g = math.min(1.0, math.max(0.0, g))
     b = math.min(1.0, math.max(0.0, b))
     
+    set_pixel(data, x, flip_y, math.floor(255 * r), math.floor(255 * g), math.floor(255 * b))
+end
+
+function M.shade(data, x, y)
     -- Y座標を上下反転
+    shade_pixel(data, FastPath.method(data, "set_pixel"), x, y, height - 1 - y)
+end
+
+-- 1行分のスパン（x0, x0 + step, ... <= x1）をまとめて処理する（ワーカーは shade より優先して呼ぶ）
+function M.shade_span(data, x0, x1, y, step)
+    local set_pixel = FastPath.method(data, "set_pixel")
     local flip_y = height - 1 - y
-    
-    data:set_pixel(x, flip_y, math.floor(255 * r), math.floor(255 * g), math.floor(255 * b))
+    for x = x0, x1, step do
+        shade_pixel(data, set_pixel, x, y, flip_y)
+    end
 end
 
 -- ポストエフェクト: バイラテラルフィルタによるノイズ低減
 -- フロントバッファから読み取り、バックバッファに書き込む
+-- 進捗表示用: 1ピクセルあたりのサンプル数
+M.samples_per_pixel = SAMPLES_PER_PIXEL
+
+-- パイプラインPostEffect用: post_effect が読み取る近傍の半径（ピクセル）
+M.post_effect_radius = BilateralFilter.RADIUS
+
 function M.post_effect(data, x, y)
     local r, g, b = BilateralFilter.filter(data, x, y)
     data:set_pixel(x, y, r, g, b)
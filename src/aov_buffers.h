@@ -0,0 +1,91 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <tuple>
+
+// 任意出力変数（AOV: Arbitrary Output Variables）
+// 最初のヒット点のアルベド・シェーディング法線・線形深度・オブジェクトIDをピクセルごとに保持する
+// レンダリング時に書き込み、ポストエフェクト（特徴量ガイド付きデノイズ等）から読み取る
+// 各ワーカーは排他的なタイルにのみ書き込むため、ピクセル単位の書き込みに排他制御は不要
+class AovBuffers {
+public:
+    // 何もヒットしなかったピクセルのオブジェクトID
+    static constexpr int32_t NO_OBJECT = -1;
+
+    AovBuffers(int width, int height)
+        : m_width(width), m_height(height),
+          m_albedo(static_cast<size_t>(width) * height * 3),
+          m_normal(static_cast<size_t>(width) * height * 3),
+          m_depth(static_cast<size_t>(width) * height),
+          m_object_id(static_cast<size_t>(width) * height) {
+        clear();
+    }
+
+    // 1ピクセル分の全AOVを書き込む
+    void set(int x, int y, float ar, float ag, float ab, float nx, float ny, float nz, float depth, int32_t object_id) {
+        if (!contains(x, y)) return;
+        size_t i = index(x, y);
+        m_albedo[i * 3 + 0] = ar;
+        m_albedo[i * 3 + 1] = ag;
+        m_albedo[i * 3 + 2] = ab;
+        m_normal[i * 3 + 0] = nx;
+        m_normal[i * 3 + 1] = ny;
+        m_normal[i * 3 + 2] = nz;
+        m_depth[i] = depth;
+        m_object_id[i] = object_id;
+    }
+
+    std::tuple<float, float, float> get_albedo(int x, int y) const {
+        if (!contains(x, y)) return std::make_tuple(0.0f, 0.0f, 0.0f);
+        size_t i = index(x, y) * 3;
+        return std::make_tuple(m_albedo[i], m_albedo[i + 1], m_albedo[i + 2]);
+    }
+
+    std::tuple<float, float, float> get_normal(int x, int y) const {
+        if (!contains(x, y)) return std::make_tuple(0.0f, 0.0f, 0.0f);
+        size_t i = index(x, y) * 3;
+        return std::make_tuple(m_normal[i], m_normal[i + 1], m_normal[i + 2]);
+    }
+
+    // カメラからの線形深度（ヒットなしは 0）
+    float get_depth(int x, int y) const {
+        if (!contains(x, y)) return 0.0f;
+        return m_depth[index(x, y)];
+    }
+
+    int32_t get_object_id(int x, int y) const {
+        if (!contains(x, y)) return NO_OBJECT;
+        return m_object_id[index(x, y)];
+    }
+
+    // 全ピクセルを「ヒットなし」にリセット
+    void clear() {
+        std::fill(m_albedo.begin(), m_albedo.end(), 0.0f);
+        std::fill(m_normal.begin(), m_normal.end(), 0.0f);
+        std::fill(m_depth.begin(), m_depth.end(), 0.0f);
+        std::fill(m_object_id.begin(), m_object_id.end(), NO_OBJECT);
+    }
+
+    // 各チャンネルの生データ（ネイティブのフィルタ・書き出し用）
+    const std::vector<float>& albedo() const { return m_albedo; }
+    const std::vector<float>& normal() const { return m_normal; }
+    const std::vector<float>& depth() const { return m_depth; }
+    const std::vector<int32_t>& object_id() const { return m_object_id; }
+
+private:
+    bool contains(int x, int y) const {
+        return x >= 0 && x < m_width && y >= 0 && y < m_height;
+    }
+
+    size_t index(int x, int y) const {
+        return static_cast<size_t>(y) * m_width + x;
+    }
+
+    int m_width;
+    int m_height;
+    std::vector<float> m_albedo;     // RGB (0.0-1.0)
+    std::vector<float> m_normal;     // XYZ（ワールド空間、正規化済み）
+    std::vector<float> m_depth;
+    std::vector<int32_t> m_object_id;
+};
@@ -7,30 +7,90 @@
 #include <string>
 #include <mutex>
 #include <memory>
+#include <atomic>
+#include <thread>
 #include "gltf_loader.h"
+#include "gltf_async_loader.h"
+#include "sync_registry.h"
+#include "shared_store.h"
+#include "aov_buffers.h"
+#include "tile_scheduler.h"
+#include "tile_dependency_queue.h"
+#include "render_stats.h"
+#include "material_graph.h"
 
 class AppData {
 public:
+    // ダーティタイルの一辺のピクセル数（2の累乗）
+    static constexpr int DIRTY_TILE_SHIFT = 5;
+    static constexpr int DIRTY_TILE_SIZE = 1 << DIRTY_TILE_SHIFT;
+
+    // 三重バッファ内の役割
+    // BACK: レンダリング/PostEffectの書き込み先, FRONT: 表示・読み取り元, SPARE: 次の書き込み先として待機
+    enum BufferRole { FRONT = 0, BACK = 1, SPARE = 2 };
+
     AppData(int width, int height) : m_width(width), m_height(height) {
-        m_front_buffer.resize(width * height);
-        m_back_buffer.resize(width * height);
-        std::fill(m_front_buffer.begin(), m_front_buffer.end(), 0xFF000000);
-        std::fill(m_back_buffer.begin(), m_back_buffer.end(), 0xFF000000);
+        for (auto& buffer : m_buffers) {
+            buffer.assign(static_cast<size_t>(width) * height, 0xFF000000);
+        }
+
+        m_dirty_cols = (width + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE;
+        m_dirty_rows = (height + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE;
+        m_dirty_tiles.reset(new std::atomic<uint8_t>[m_dirty_cols * m_dirty_rows]);
+        reset_dirty_tiles();
+
+        m_sync = std::make_unique<SyncRegistry>();
+        m_store = std::make_unique<SharedStore>();
     }
 
-    // バックバッファに書き込み
+    // 実行中の非同期読み込みは完了時にこのキャッシュへ登録するので、破棄する前に終了を待つ
+    ~AppData() {
+        std::vector<std::shared_ptr<GltfLoadJob>> jobs;
+        {
+            std::lock_guard<std::mutex> lock(m_resource_mutex);
+            jobs.swap(m_load_jobs);
+        }
+        for (auto& job : jobs) {
+            job->join();
+        }
+    }
+
+    // バックバッファに書き込み（書き込んだタイルをダーティとして記録）
+    // スプラットサイズが2以上の場合は (x, y) を左上とする size×size のブロック全体を塗りつぶす
+    // 古いレンダー世代のワーカーからの書き込みは破棄する
+    // パイプラインPostEffect中のスレッドはSPAREに書くため、バックバッファのダーティタイルには記録しない
     void set_pixel(int x, int y, int r, int g, int b) {
         if (x < 0 || x >= m_width || y < 0 || y >= m_height) return;
+        WriteScope scope(*this);
+        if (!scope) return;
         uint32_t color = (r) | (g << 8) | (b << 16) | (255 << 24);
-        m_back_buffer[y * m_width + x] = color;
+        if (t_splat_size > 1) {
+            splat(x, y, t_splat_size, color);
+            return;
+        }
+        target()[y * m_width + x] = color;
+        if (!t_post_pass) {
+            m_dirty_tiles[(y >> DIRTY_TILE_SHIFT) * m_dirty_cols + (x >> DIRTY_TILE_SHIFT)].store(1, std::memory_order_relaxed);
+        }
     }
 
-    // フロントバッファから読み取り
+    // 呼び出し元スレッドの set_pixel のスプラットサイズを設定する（プログレッシブプレビュー用）
+    // スレッドローカルなので、各ワーカーは他のスレッドに影響を与えずに解像度レベルを切り替えられる
+    static void set_splat_size(int size) { t_splat_size = size < 1 ? 1 : size; }
+    static int splat_size() { return t_splat_size; }
+
+    // 呼び出し元スレッドをパイプラインPostEffectモードにする
+    // レンダリング中のバックバッファから読み取り、待機中のSPAREバッファに書き込む
+    // 完了後に present() を2回呼ぶと、PostEffectの結果がフロントになる
+    static void set_post_pass(bool enabled) { t_post_pass = enabled; }
+    static bool post_pass() { return t_post_pass; }
+
+    // フロントバッファから読み取り（パイプラインPostEffect中のスレッドはバックバッファから）
     std::tuple<int, int, int> get_pixel(int x, int y) const {
         if (x < 0 || x >= m_width || y < 0 || y >= m_height) {
             return std::make_tuple(0, 0, 0);
         }
-        uint32_t color = m_front_buffer[y * m_width + x];
+        uint32_t color = (t_post_pass ? back() : front())[y * m_width + x];
         int r = color & 0xFF;
         int g = (color >> 8) & 0xFF;
         int b = (color >> 16) & 0xFF;
@@ -39,41 +99,157 @@ public:
 
     // フロントとバックを交換
     void swap() {
-        std::swap(m_front_buffer, m_back_buffer);
+        std::swap(m_role[FRONT], m_role[BACK]);
+        std::swap(m_generation[FRONT], m_generation[BACK]);
+    }
+
+    // 書き終えたバックバッファを表示用に回転させる（ピクセルのコピー・クリアを伴わない O(1) 操作）
+    // BACK → FRONT, SPARE → BACK, FRONT → SPARE
+    // 新しいバックバッファには古い内容が残るため、次のパスは全ピクセルを書き込む前提
+    // （PostEffect では回転後の FRONT が読み取り元、BACK が書き込み先になる）
+    // @return 新しいフロントバッファの世代番号
+    uint64_t present() {
+        int old_front = m_role[FRONT];
+        uint64_t old_front_generation = m_generation[FRONT];
+        m_role[FRONT] = m_role[BACK];
+        m_role[BACK] = m_role[SPARE];
+        m_role[SPARE] = old_front;
+
+        m_generation[FRONT] = ++m_present_count;
+        m_generation[BACK] = m_generation[SPARE];
+        m_generation[SPARE] = old_front_generation;
+
+        // ダーティ状態は新しいバックバッファの内容とは無関係なので破棄する
+        reset_dirty_tiles();
+        return m_generation[FRONT];
+    }
+
+    // 指定した役割のバッファが保持する画像の世代番号（present のたびに増加、0 は未提示）
+    uint64_t get_generation(BufferRole role) const {
+        return m_generation[role];
     }
 
     // フロントバッファをバックバッファにコピー
     void copy_front_to_back() {
-        std::copy(m_front_buffer.begin(), m_front_buffer.end(), m_back_buffer.begin());
+        std::copy(front().begin(), front().end(), back().begin());
+        m_generation[BACK] = m_generation[FRONT];
     }
 
     // バックバッファをフロントバッファにコピー
     void copy_back_to_front() {
-        std::copy(m_back_buffer.begin(), m_back_buffer.end(), m_front_buffer.begin());
+        std::copy(back().begin(), back().end(), front().begin());
+        m_generation[FRONT] = m_generation[BACK];
     }
 
     // フロントバッファのデータ取得（テクスチャ更新用）
     const void* get_data() const {
-        return m_front_buffer.data();
+        return front().data();
+    }
+
+    // フロントバッファの複製（非同期の画像書き出し用スナップショット）
+    std::vector<uint32_t> copy_front_pixels() const {
+        return front();
     }
 
     // バックバッファのデータ取得（レンダリング途中表示用）
     const void* get_back_data() const {
-        return m_back_buffer.data();
+        return back().data();
     }
 
     int get_width() const { return m_width; }
     int get_height() const { return m_height; }
 
-    // 両バッファをクリア
+    // 全バッファをクリア（AOVが有効な場合はAOVもリセット）
     void clear() {
-        std::fill(m_front_buffer.begin(), m_front_buffer.end(), 0xFF000000);
-        std::fill(m_back_buffer.begin(), m_back_buffer.end(), 0xFF000000);
+        for (auto& buffer : m_buffers) {
+            std::fill(buffer.begin(), buffer.end(), 0xFF000000);
+        }
+        if (m_aovs) {
+            m_aovs->clear();
+        }
+        m_generation[FRONT] = m_generation[BACK] = m_generation[SPARE] = 0;
+        reset_dirty_tiles();
     }
 
     // バックバッファのみをクリア
     void clear_back_buffer() {
-        std::fill(m_back_buffer.begin(), m_back_buffer.end(), 0xFF000000);
+        std::fill(back().begin(), back().end(), 0xFF000000);
+        m_generation[BACK] = 0;
+        reset_dirty_tiles();
+    }
+
+    // ================================================================
+    // ダーティタイル（テクスチャ差分アップロード用）
+    // ================================================================
+
+    // 前回の呼び出し以降に set_pixel で書き込まれた領域を矩形単位で列挙し、ダーティ状態を解除する
+    // 同じタイル行で隣接するダーティタイルは1つの矩形に結合される
+    // @param fn (int x, int y, int w, int h) を受け取るコールバック
+    template <typename Fn>
+    void consume_dirty_rects(Fn&& fn) {
+        for (int row = 0; row < m_dirty_rows; ++row) {
+            int y = row * DIRTY_TILE_SIZE;
+            int h = std::min(DIRTY_TILE_SIZE, m_height - y);
+            int run_start = -1;
+            for (int col = 0; col <= m_dirty_cols; ++col) {
+                bool dirty = col < m_dirty_cols &&
+                    m_dirty_tiles[row * m_dirty_cols + col].exchange(0, std::memory_order_relaxed) != 0;
+                if (dirty && run_start < 0) {
+                    run_start = col;
+                } else if (!dirty && run_start >= 0) {
+                    int x = run_start * DIRTY_TILE_SIZE;
+                    int w = std::min(col * DIRTY_TILE_SIZE, m_width) - x;
+                    fn(x, y, w, h);
+                    run_start = -1;
+                }
+            }
+        }
+    }
+
+    // ================================================================
+    // AOV（アルベド・法線・深度・オブジェクトID）
+    // ================================================================
+
+    // AOVバッファを確保する（ワーカー起動前にメインスレッドから呼ぶこと。確保済みなら何もしない）
+    void enable_aovs() {
+        if (!m_aovs) {
+            m_aovs = std::make_unique<AovBuffers>(m_width, m_height);
+        }
+    }
+
+    // AOVバッファを解放する（AOVを書かないシーンに切り替える際に古い値を残さないため）
+    void disable_aovs() {
+        m_aovs.reset();
+    }
+
+    bool has_aovs() const { return m_aovs != nullptr; }
+
+    // AOVが無効な場合は nullptr
+    const AovBuffers* aovs() const { return m_aovs.get(); }
+
+    // 1ピクセル分のAOVを書き込む（AOVが無効な場合は何もしない）
+    void set_aov(int x, int y, float ar, float ag, float ab, float nx, float ny, float nz, float depth, int object_id) {
+        if (!m_aovs) return;
+        WriteScope scope(*this);
+        if (scope) {
+            m_aovs->set(x, y, ar, ag, ab, nx, ny, nz, depth, object_id);
+        }
+    }
+
+    std::tuple<float, float, float> get_albedo(int x, int y) const {
+        return m_aovs ? m_aovs->get_albedo(x, y) : std::make_tuple(0.0f, 0.0f, 0.0f);
+    }
+
+    std::tuple<float, float, float> get_normal(int x, int y) const {
+        return m_aovs ? m_aovs->get_normal(x, y) : std::make_tuple(0.0f, 0.0f, 0.0f);
+    }
+
+    float get_depth(int x, int y) const {
+        return m_aovs ? m_aovs->get_depth(x, y) : 0.0f;
+    }
+
+    int get_object_id(int x, int y) const {
+        return m_aovs ? m_aovs->get_object_id(x, y) : AovBuffers::NO_OBJECT;
     }
 
     // 文字列ストレージ（排他制御付き）
@@ -109,26 +285,199 @@ public:
         return current;
     }
 
+    // 名前付きアトミックカウンタ・バリア・ラッチ（ロックフリーなワーカー間同期用）
+    SyncRegistry& sync() { return *m_sync; }
+
+    // ラッチをカウントダウンする（多段パスのレベル間の待ち合わせ用）
+    // 古い世代のワーカーからの呼び出しは、新しいレンダーのためにリセットされたラッチを減らさないよう無視する
+    void count_down_latch(int slot, int64_t n) {
+        WriteScope scope(*this);
+        if (scope) {
+            m_sync->latch_count_down(slot, n);
+        }
+    }
+
+    // 型付き共有ストア（不変スナップショットでマテリアルやカメラ状態を受け渡す）
+    SharedStore& store() { return *m_store; }
+
+    // ================================================================
+    // タイルスケジューラ（名前付き、ワークスティーリング）
+    // ================================================================
+
+    // 名前付きタイルキューを作成（既存なら打ち切って新しいキューに置き換える）
+    // 古いキューを保持しているワーカーがいても、そのワーカーが手放すまで解放されない
+    void setup_tiles(const std::string& name, std::vector<TileScheduler::Tile> tiles, int num_queues) {
+        auto scheduler = std::make_shared<TileScheduler>();
+        scheduler->reset(std::move(tiles), num_queues);
+        std::lock_guard<std::mutex> lock(m_tile_mutex);
+        auto& slot = m_tile_schedulers[name];
+        if (slot) {
+            slot->retire();
+        }
+        slot = std::move(scheduler);
+    }
+
+    // 名前付きタイルキューを取得（ループの前に一度だけ取得すれば以降の取得はロックフリー）
+    // @return 見つからない場合は nullptr
+    std::shared_ptr<TileScheduler> tile_queue(const std::string& name) {
+        std::lock_guard<std::mutex> lock(m_tile_mutex);
+        auto it = m_tile_schedulers.find(name);
+        return it != m_tile_schedulers.end() ? it->second : nullptr;
+    }
+
+    // 実行中のタイルキュー（依存関係付きを含む）を全て打ち切る（レンダー世代は進めない）
+    // ワーカーがエラーで中断した場合に呼び、そのワーカーが完了を報告しないタイルを待つ他のワーカーを終了させる
+    // それまでの書き込みは残り、ワーカーが全員終了した時点でレンダリングは途中の結果のまま終わる
+    // 古い世代のワーカーからの呼び出しは、新しい世代のキューを打ち切らないよう無視する
+    void abort_tiles() {
+        WriteScope scope(*this);
+        if (!scope) return;
+        std::lock_guard<std::mutex> lock(m_tile_mutex);
+        for (auto& entry : m_tile_schedulers) {
+            entry.second->retire();
+        }
+        // 中断したワーカーのレンダリングタイルに依存するPostEffectタイルは取得可能にならないため、こちらも打ち切る
+        for (auto& entry : m_dependent_queues) {
+            entry.second->retire();
+        }
+        // レベル間のラッチで待っているワーカーにも打ち切りを確認させる
+        m_sync->interrupt_waiters();
+    }
+
+    // 名前付きの依存関係付きタイルキューを作成する（既存なら打ち切って置き換える）
+    void setup_dependent_tiles(const std::string& name, const std::vector<TileScheduler::Tile>& render_tiles,
+                               std::vector<TileScheduler::Tile> post_tiles, int radius, int flip_height) {
+        auto queue = std::make_shared<TileDependencyQueue>();
+        queue->reset(render_tiles, std::move(post_tiles), radius, flip_height);
+        std::lock_guard<std::mutex> lock(m_tile_mutex);
+        auto& slot = m_dependent_queues[name];
+        if (slot) {
+            slot->retire();
+        }
+        slot = std::move(queue);
+    }
+
+    // 名前付きの依存関係付きタイルキューを打ち切って削除する
+    void remove_dependent_tiles(const std::string& name) {
+        std::lock_guard<std::mutex> lock(m_tile_mutex);
+        auto it = m_dependent_queues.find(name);
+        if (it != m_dependent_queues.end()) {
+            it->second->retire();
+            m_dependent_queues.erase(it);
+        }
+    }
+
+    // @return 見つからない場合は nullptr
+    std::shared_ptr<TileDependencyQueue> dependent_tiles(const std::string& name) {
+        std::lock_guard<std::mutex> lock(m_tile_mutex);
+        auto it = m_dependent_queues.find(name);
+        return it != m_dependent_queues.end() ? it->second : nullptr;
+    }
+
+    // 名前付きのレンダリング統計を作り直す（古い統計を保持しているワーカーはそちらに書き込み続ける）
+    std::shared_ptr<RenderStats> setup_render_stats(const std::string& name, int num_workers,
+                                                    uint64_t total_pixels, int samples_per_pixel) {
+        auto stats = std::make_shared<RenderStats>(num_workers, total_pixels, samples_per_pixel);
+        std::lock_guard<std::mutex> lock(m_tile_mutex);
+        m_render_stats[name] = stats;
+        return stats;
+    }
+
+    // @return 見つからない場合は nullptr
+    std::shared_ptr<RenderStats> render_stats(const std::string& name) {
+        std::lock_guard<std::mutex> lock(m_tile_mutex);
+        auto it = m_render_stats.find(name);
+        return it != m_render_stats.end() ? it->second : nullptr;
+    }
+
+    // ================================================================
+    // レンダー世代（ノンブロッキングなキャンセルと再開）
+    // ================================================================
+
+    // 現在のレンダー世代
+    uint64_t render_generation() const { return m_render_generation.load(std::memory_order_acquire); }
+
+    // 世代を進め、実行中のタイルキューを全て打ち切る
+    // 古い世代のワーカーは次のタイル取得で終了し、以降の書き込みは set_pixel で破棄される
+    // 世代の確認を通過して書き込み中の古いワーカーは、その1回の書き込みが終わるまで待つ
+    // （戻った後はバッファを clear / present しても古い世代の書き込みが混ざらない）
+    // ワーカーの終了自体は待たずに新しい世代のジョブを登録できる
+    uint64_t advance_render_generation() {
+        uint64_t generation = m_render_generation.fetch_add(1, std::memory_order_seq_cst) + 1;
+        for (const auto& writers : m_writers) {
+            while (writers.count.load(std::memory_order_seq_cst) != 0) {
+                std::this_thread::yield();
+            }
+        }
+        std::lock_guard<std::mutex> lock(m_tile_mutex);
+        for (auto& entry : m_tile_schedulers) {
+            entry.second->retire();
+        }
+        for (auto& entry : m_dependent_queues) {
+            entry.second->retire();
+        }
+        m_sync->interrupt_waiters();
+        return generation;
+    }
+
+    // 呼び出し元スレッドの書き込みが属する世代を設定する（0 は世代を問わない、メインスレッド用）
+    static void set_thread_generation(uint64_t generation) { t_generation = generation; }
+
+    // 呼び出し元スレッドが古い世代のジョブを実行中か（キャンセル確認用。書き込みの可否は WriteScope で判定する）
+    bool is_stale_writer() const {
+        return t_generation != 0 && t_generation != m_render_generation.load(std::memory_order_relaxed);
+    }
+
     // ================================================================
     // GltfData キャッシュ（スレッド間 readonly 共有）
     // ================================================================
 
     // glTFファイルをロードしてキャッシュに格納（既にロード済みの場合はスキップ）
+    // パースはロックの外で行い、その間も他のスレッドはキャッシュを参照できる
     // @return true: ロード成功（または既にロード済み）, false: ロード失敗
     bool load_gltf(const std::string& name, const std::string& path) {
-        std::lock_guard<std::mutex> lock(m_resource_mutex);
-        // 既にロード済みならスキップ
-        if (m_gltf_cache.find(name) != m_gltf_cache.end()) {
-            return true;
+        {
+            std::lock_guard<std::mutex> lock(m_resource_mutex);
+            // 既にロード済みならスキップ
+            if (m_gltf_cache.find(name) != m_gltf_cache.end()) {
+                return true;
+            }
         }
         auto gltf = std::make_shared<GltfData>();
         if (!gltf->load(path)) {
             return false;
         }
-        m_gltf_cache[name] = std::move(gltf);
+        std::lock_guard<std::mutex> lock(m_resource_mutex);
+        // 同時に読み込まれた場合は先に登録されたものを使う
+        m_gltf_cache.emplace(name, std::move(gltf));
         return true;
     }
 
+    // glTF をバックグラウンドで読み込み、すべてのテクスチャを並列にデコードしてキャッシュに登録する
+    // テクスチャは texture_cache_name(name, 番号) で登録される（load_texture_image で同じ名前を使えば再デコードしない）
+    // @param decode_threads デコードに使うスレッド数の上限（0 なら論理CPU数）
+    // @return 進捗と完了を参照するジョブ（既にロード済みなら完了済みのジョブ）
+    std::shared_ptr<GltfLoadJob> load_gltf_async(const std::string& name, const std::string& path, unsigned int decode_threads = 0) {
+        std::lock_guard<std::mutex> lock(m_resource_mutex);
+        auto it = m_gltf_cache.find(name);
+        if (it != m_gltf_cache.end()) {
+            return GltfLoadJob::completed(path, it->second);
+        }
+        // 完了したジョブを片付ける
+        m_load_jobs.erase(std::remove_if(m_load_jobs.begin(), m_load_jobs.end(),
+                                         [](const std::shared_ptr<GltfLoadJob>& job) { return job->done(); }),
+                          m_load_jobs.end());
+        auto job = std::make_shared<GltfLoadJob>(path, decode_threads);
+        job->start([this, name](GltfLoadJob& loaded) { register_loaded_gltf(name, loaded); });
+        m_load_jobs.push_back(job);
+        return job;
+    }
+
+    // glTF のテクスチャのキャッシュ名（"<glTFの名前>_tex<番号>"）
+    static std::string texture_cache_name(const std::string& gltf_name, size_t texture_index) {
+        return gltf_name + "_tex" + std::to_string(texture_index);
+    }
+
     // キャッシュされた GltfData を取得（readonly）
     // @return 見つからない場合は nullptr
     std::shared_ptr<GltfData> get_gltf(const std::string& name) const {
@@ -140,6 +489,22 @@ public:
         return nullptr;
     }
 
+    // instantiate_gltf で追加したジオメトリの一覧を記録する（setup で追加し、各ワーカーの start で参照する）
+    void set_gltf_geometries(const std::string& name, std::vector<GltfGeometry> geometries) {
+        std::lock_guard<std::mutex> lock(m_resource_mutex);
+        m_gltf_geometries[name] = std::move(geometries);
+    }
+
+    // 記録されたジオメトリの一覧（未記録なら空）
+    std::vector<GltfGeometry> get_gltf_geometries(const std::string& name) const {
+        std::lock_guard<std::mutex> lock(m_resource_mutex);
+        auto it = m_gltf_geometries.find(name);
+        if (it != m_gltf_geometries.end()) {
+            return it->second;
+        }
+        return {};
+    }
+
     // ================================================================
     // TextureImage キャッシュ（スレッド間 readonly 共有）
     // ================================================================
@@ -150,20 +515,26 @@ public:
     // @param texture_index テクスチャインデックス
     // @return true: 成功（または既にロード済み）, false: 失敗
     bool load_texture_image(const std::string& name, const std::string& gltf_name, size_t texture_index) {
-        std::lock_guard<std::mutex> lock(m_resource_mutex);
-        // 既にロード済みならスキップ
-        if (m_texture_cache.find(name) != m_texture_cache.end()) {
-            return true;
-        }
-        auto gltf_it = m_gltf_cache.find(gltf_name);
-        if (gltf_it == m_gltf_cache.end() || !gltf_it->second) {
-            return false;
+        std::shared_ptr<GltfData> gltf;
+        {
+            std::lock_guard<std::mutex> lock(m_resource_mutex);
+            // 既にロード済みならスキップ
+            if (m_texture_cache.find(name) != m_texture_cache.end()) {
+                return true;
+            }
+            auto gltf_it = m_gltf_cache.find(gltf_name);
+            if (gltf_it == m_gltf_cache.end() || !gltf_it->second) {
+                return false;
+            }
+            gltf = gltf_it->second;
         }
-        auto image = std::make_shared<TextureImage>(gltf_it->second->getTextureImage(texture_index));
+        // デコードはロックの外で行う
+        auto image = std::make_shared<TextureImage>(gltf->getTextureImage(texture_index));
         if (image->width == 0 || image->height == 0) {
             return false;
         }
-        m_texture_cache[name] = std::move(image);
+        std::lock_guard<std::mutex> lock(m_resource_mutex);
+        m_texture_cache.emplace(name, std::move(image));
         return true;
     }
 
@@ -177,19 +548,156 @@ public:
         return nullptr;
     }
 
+    // ================================================================
+    // MaterialProgram キャッシュ（スレッド間 readonly 共有）
+    // ================================================================
+
+    // コンパイル済みのマテリアルグラフを登録する（同じ名前は置き換え、取得済みの参照はそのまま使える）
+    void set_material(const std::string& name, std::shared_ptr<MaterialProgram> program) {
+        std::lock_guard<std::mutex> lock(m_resource_mutex);
+        m_material_cache[name] = std::move(program);
+    }
+
+    // @return 見つからない場合は nullptr
+    std::shared_ptr<MaterialProgram> get_material(const std::string& name) const {
+        std::lock_guard<std::mutex> lock(m_resource_mutex);
+        auto it = m_material_cache.find(name);
+        if (it != m_material_cache.end()) {
+            return it->second;
+        }
+        return nullptr;
+    }
+
 private:
+    // 世代付きスレッドの書き込み区間
+    // 書き込み中の数を数えてから世代を確認し、advance_render_generation は世代を進めてからその数が0になるまで待つ
+    // （どちらも seq_cst なので、世代の確認を通過した書き込みは必ず待たれ、待たれない書き込みは必ず古い世代と判定される）
+    // 世代未設定のスレッド（メインスレッド）は世代を進める側なので数えない
+    class WriteScope {
+    public:
+        explicit WriteScope(AppData& data) {
+            if (t_generation == 0) {
+                m_ok = true;
+                return;
+            }
+            m_count = &data.m_writers[writer_slot()].count;
+            m_count->fetch_add(1, std::memory_order_seq_cst);
+            m_ok = t_generation == data.m_render_generation.load(std::memory_order_seq_cst);
+        }
+        ~WriteScope() {
+            if (m_count) m_count->fetch_sub(1, std::memory_order_release);
+        }
+        WriteScope(const WriteScope&) = delete;
+        WriteScope& operator=(const WriteScope&) = delete;
+        explicit operator bool() const { return m_ok; }
+
+    private:
+        std::atomic<int>* m_count = nullptr;
+        bool m_ok = false;
+    };
+
+    // 書き込み中の数のカウンタ（スレッドごとに分散させ、書き込みのたびに同じキャッシュラインを奪い合わない）
+    static constexpr int WRITER_SLOTS = 64;
+    struct alignas(64) WriterCount {
+        std::atomic<int> count{0};
+    };
+
+    // 呼び出し元スレッドが使うカウンタ番号（初回に割り当てる）
+    static int writer_slot() {
+        static std::atomic<int> next{0};
+        thread_local int slot = next.fetch_add(1, std::memory_order_relaxed) % WRITER_SLOTS;
+        return slot;
+    }
+
+    std::vector<uint32_t>& front() { return m_buffers[m_role[FRONT]]; }
+    const std::vector<uint32_t>& front() const { return m_buffers[m_role[FRONT]]; }
+    std::vector<uint32_t>& back() { return m_buffers[m_role[BACK]]; }
+    const std::vector<uint32_t>& back() const { return m_buffers[m_role[BACK]]; }
+    // set_pixel の書き込み先（パイプラインPostEffect中のスレッドはSPARE）
+    std::vector<uint32_t>& target() { return m_buffers[m_role[t_post_pass ? SPARE : BACK]]; }
+
+    // 非同期読み込みの結果をキャッシュに登録する（ジョブのスレッドから呼ばれる。失敗時は何もしない）
+    // 同じ名前が既に登録されていれば、そちらを優先する
+    void register_loaded_gltf(const std::string& name, const GltfLoadJob& job) {
+        auto gltf = job.gltf();
+        if (!gltf) return;
+        std::lock_guard<std::mutex> lock(m_resource_mutex);
+        m_gltf_cache.emplace(name, std::move(gltf));
+        const auto& textures = job.textures();
+        for (size_t i = 0; i < textures.size(); ++i) {
+            if (textures[i]) {
+                m_texture_cache.emplace(texture_cache_name(name, i), textures[i]);
+            }
+        }
+    }
+
+    // (x, y) から size×size のブロックを画面内にクリップして塗りつぶす
+    void splat(int x, int y, int size, uint32_t color) {
+        int x_end = std::min(x + size, m_width);
+        int y_end = std::min(y + size, m_height);
+        uint32_t* buffer = target().data();
+        for (int yy = y; yy < y_end; ++yy) {
+            std::fill(buffer + static_cast<size_t>(yy) * m_width + x, buffer + static_cast<size_t>(yy) * m_width + x_end, color);
+        }
+        if (t_post_pass) return;
+        for (int row = y >> DIRTY_TILE_SHIFT; row <= (y_end - 1) >> DIRTY_TILE_SHIFT; ++row) {
+            for (int col = x >> DIRTY_TILE_SHIFT; col <= (x_end - 1) >> DIRTY_TILE_SHIFT; ++col) {
+                m_dirty_tiles[row * m_dirty_cols + col].store(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void reset_dirty_tiles() {
+        for (int i = 0; i < m_dirty_cols * m_dirty_rows; ++i) {
+            m_dirty_tiles[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
     int m_width;
     int m_height;
-    std::vector<uint32_t> m_front_buffer;
-    std::vector<uint32_t> m_back_buffer;
+    // 三重バッファ本体と、役割（FRONT/BACK/SPARE）ごとのバッファ番号・世代番号
+    std::vector<uint32_t> m_buffers[3];
+    int m_role[3] = {0, 1, 2};
+    uint64_t m_generation[3] = {0, 0, 0};
+    uint64_t m_present_count = 0;
+
+    // タイル単位のダーティフラグ（ワーカーから並行に書き込まれるためアトミック）
+    int m_dirty_cols = 0;
+    int m_dirty_rows = 0;
+    std::unique_ptr<std::atomic<uint8_t>[]> m_dirty_tiles;
+
+    // set_pixel のスプラットサイズ（スレッドごと、1 で通常の1ピクセル書き込み）
+    static inline thread_local int t_splat_size = 1;
+    // パイプラインPostEffect中か（スレッドごと）
+    static inline thread_local bool t_post_pass = false;
+
+    // レンダー世代（advance_render_generation で進む）と、スレッドごとの書き込み世代
+    std::atomic<uint64_t> m_render_generation{1};
+    static inline thread_local uint64_t t_generation = 0;
+    WriterCount m_writers[WRITER_SLOTS];
     
     // 文字列ストレージ（スレッド間データ共有用）
     std::unordered_map<std::string, std::string> m_string_storage;
     mutable std::mutex m_string_mutex;
 
+    std::unique_ptr<SyncRegistry> m_sync;
+    std::unique_ptr<SharedStore> m_store;
+
+    // タイルスケジューラ（アドレスはAppDataの寿命の間固定）
+    std::unordered_map<std::string, std::shared_ptr<TileScheduler>> m_tile_schedulers;
+    std::unordered_map<std::string, std::shared_ptr<TileDependencyQueue>> m_dependent_queues;
+    std::unordered_map<std::string, std::shared_ptr<RenderStats>> m_render_stats;
+    std::mutex m_tile_mutex;
+
+    // AOVバッファ（enable_aovs で確保されるまでは nullptr）
+    std::unique_ptr<AovBuffers> m_aovs;
+
     // リソースキャッシュ（スレッド間 readonly 共有用）
     std::unordered_map<std::string, std::shared_ptr<GltfData>> m_gltf_cache;
     std::unordered_map<std::string, std::shared_ptr<TextureImage>> m_texture_cache;
+    std::unordered_map<std::string, std::shared_ptr<MaterialProgram>> m_material_cache;
+    std::unordered_map<std::string, std::vector<GltfGeometry>> m_gltf_geometries;
+    std::vector<std::shared_ptr<GltfLoadJob>> m_load_jobs;
     mutable std::mutex m_resource_mutex;
 };
 
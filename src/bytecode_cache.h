@@ -0,0 +1,143 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <filesystem>
+extern "C" {
+#include <lua.h>
+#include <lauxlib.h>
+}
+
+// Luaモジュールのバイトコードキャッシュ（プロセス共通）
+// 各ファイルはパスと更新時刻をキーに一度だけコンパイルし（lua_dump）、以降はどのLua Stateでもバイトコードから読み込む
+// install_searcher() で package.searchers に追加すると、require がキャッシュ経由になる
+// ワーカーのLua Stateを作り直してもパースとコンパイルは発生しない
+class BytecodeCache {
+public:
+    static BytecodeCache& instance() {
+        static BytecodeCache cache;
+        return cache;
+    }
+
+    // path のチャンクを関数としてスタックに積む
+    // キャッシュが更新時刻と一致すればバイトコードから、そうでなければソースをコンパイルしてキャッシュする
+    // @return luaL_loadfilex と同じステータス（失敗時はエラーメッセージを積む）
+    int load(lua_State* L, const std::string& path) {
+        std::error_code ec;
+        auto mtime = std::filesystem::last_write_time(path, ec);
+        if (ec) {
+            // ファイルが無い場合は通常の読み込みでエラーメッセージを作る
+            return luaL_loadfilex(L, path.c_str(), nullptr);
+        }
+
+        std::shared_ptr<const Entry> entry;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_entries.find(path);
+            if (it != m_entries.end() && it->second->mtime == mtime) {
+                entry = it->second;
+                ++m_hits;
+            }
+        }
+        if (entry) {
+            std::string chunkname = "@" + path;
+            return luaL_loadbufferx(L, entry->bytecode.data(), entry->bytecode.size(), chunkname.c_str(), "b");
+        }
+
+        int status = luaL_loadfilex(L, path.c_str(), nullptr);
+        if (status != LUA_OK) {
+            return status;
+        }
+        // エラー時の行番号のためデバッグ情報は残す
+        auto compiled = std::make_shared<Entry>();
+        compiled->mtime = mtime;
+        lua_dump(L, &BytecodeCache::write_chunk, &compiled->bytecode, 0);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries[path] = std::move(compiled);
+        ++m_misses;
+        return LUA_OK;
+    }
+
+    // 全エントリを破棄する（シーンの再読み込み時）
+    void invalidate() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.clear();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries.size();
+    }
+    // キャッシュから読み込んだ回数と、コンパイルした回数
+    size_t hits() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_hits;
+    }
+    size_t misses() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_misses;
+    }
+
+    // package.searchers の2番目（preload の次、Luaファイルの検索より前）にキャッシュ経由の検索関数を追加する
+    // package ライブラリが開かれていない場合は何もしない
+    static void install_searcher(lua_State* L) {
+        if (lua_getglobal(L, "package") != LUA_TTABLE) {
+            lua_pop(L, 1);
+            return;
+        }
+        if (lua_getfield(L, -1, "searchers") != LUA_TTABLE) {
+            lua_pop(L, 2);
+            return;
+        }
+        lua_Integer count = luaL_len(L, -1);
+        for (lua_Integer i = count; i >= 2; --i) {
+            lua_rawgeti(L, -1, i);
+            lua_rawseti(L, -2, i + 1);
+        }
+        lua_pushcfunction(L, &BytecodeCache::search);
+        lua_rawseti(L, -2, 2);
+        lua_pop(L, 2);
+    }
+
+private:
+    struct Entry {
+        std::filesystem::file_time_type mtime;
+        std::string bytecode;
+    };
+
+    static int write_chunk(lua_State*, const void* data, size_t size, void* user) {
+        static_cast<std::string*>(user)->append(static_cast<const char*>(data), size);
+        return 0;
+    }
+
+    // package.searchers 用: package.path からファイルを探し、キャッシュ経由で読み込んだローダーとファイル名を返す
+    // 見つからない場合は何も返さず、後続の標準の検索関数に任せる
+    static int search(lua_State* L) {
+        const char* name = luaL_checkstring(L, 1);
+        lua_getglobal(L, "package");
+        lua_getfield(L, -1, "searchpath");
+        lua_pushvalue(L, 1);
+        lua_getfield(L, -3, "path");
+        lua_call(L, 2, 2);
+        if (lua_isnil(L, -2)) {
+            return 0;
+        }
+        // luaL_error は longjmp するため、ここではC++オブジェクトを生存させない（ファイル名はスタック上の文字列を使う）
+        const char* filename = lua_tostring(L, -2);
+        if (instance().load(L, filename) != LUA_OK) {
+            return luaL_error(L, "error loading module '%s' from file '%s':\n\t%s",
+                              name, filename, lua_tostring(L, -1));
+        }
+        lua_pushstring(L, filename);
+        return 2;
+    }
+
+    BytecodeCache() = default;
+
+    std::unordered_map<std::string, std::shared_ptr<const Entry>> m_entries;
+    size_t m_hits = 0;
+    size_t m_misses = 0;
+    mutable std::mutex m_mutex;
+};
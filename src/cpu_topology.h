@@ -0,0 +1,208 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <thread>
+#include <set>
+#include <utility>
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// ホストのCPUトポロジ（論理CPU・物理コア・NUMAノード）
+// Linux では /sys/devices/system 以下から読み取り、それ以外は hardware_concurrency のみを使う
+// ワーカーの自動スレッド数とCPUへのピン留め順の決定に使用する
+class CpuTopology {
+public:
+    struct Cpu {
+        int id;        // 論理CPU番号
+        int core;      // 物理コアの識別子（ソケットをまたいで一意）
+        int node;      // NUMAノード番号
+    };
+
+    // 現在のホストのトポロジを取得する
+    // @param allowed 使用を許可された論理CPU（既定はプロセスのアフィニティマスク）
+    //                オンラインのCPUをこれに絞り込む。空、または共通部分が無い場合は絞り込まない
+    static CpuTopology detect(const std::string& sysfs_root = "/sys/devices/system",
+                              const std::vector<int>& allowed = process_affinity()) {
+        CpuTopology topology;
+        std::vector<int> online = parse_cpu_list(read_first_line(sysfs_root + "/cpu/online"));
+        if (online.empty()) {
+            unsigned int count = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned int i = 0; i < count; ++i) {
+                online.push_back(static_cast<int>(i));
+            }
+        }
+        // taskset や cgroup の cpuset で制限されている場合、許可されていないCPUにはピン留めできない
+        if (!allowed.empty()) {
+            std::vector<int> usable;
+            for (int id : online) {
+                if (std::find(allowed.begin(), allowed.end(), id) != allowed.end()) usable.push_back(id);
+            }
+            if (!usable.empty()) online = std::move(usable);
+        }
+
+        // NUMAノードごとのCPU一覧（node ディレクトリが無い場合は全CPUをノード0とする）
+        std::vector<int> node_of(online.empty() ? 0 : online.back() + 1, 0);
+        for (int node = 0;; ++node) {
+            std::string list = read_first_line(sysfs_root + "/node/node" + std::to_string(node) + "/cpulist");
+            if (list.empty()) break;
+            for (int cpu : parse_cpu_list(list)) {
+                if (cpu >= 0 && cpu < static_cast<int>(node_of.size())) node_of[cpu] = node;
+            }
+        }
+
+        for (int id : online) {
+            std::string base = sysfs_root + "/cpu/cpu" + std::to_string(id) + "/topology/";
+            int package = to_int(read_first_line(base + "physical_package_id"), 0);
+            int core_id = to_int(read_first_line(base + "core_id"), id);
+            // core_id はソケット内でのみ一意なので、パッケージ番号と組み合わせる
+            topology.m_cpus.push_back(Cpu{id, package * 65536 + core_id, node_of[id]});
+        }
+        return topology;
+    }
+
+    // 任意のCPU構成から作成する（テスト用）
+    static CpuTopology from_cpus(std::vector<Cpu> cpus) {
+        CpuTopology topology;
+        topology.m_cpus = std::move(cpus);
+        return topology;
+    }
+
+    int logical_count() const { return static_cast<int>(m_cpus.size()); }
+
+    int physical_core_count() const {
+        std::set<std::pair<int, int>> cores;
+        for (const auto& cpu : m_cpus) cores.insert({cpu.node, cpu.core});
+        return static_cast<int>(cores.size());
+    }
+
+    int numa_node_count() const {
+        std::set<int> nodes;
+        for (const auto& cpu : m_cpus) nodes.insert(cpu.node);
+        return static_cast<int>(nodes.size());
+    }
+
+    // ワーカーを順にピン留めする論理CPUの並び
+    // まず各物理コアの1スレッド目をNUMAノード間で交互に並べ、その後にSMTの兄弟スレッドを並べる
+    // ワーカー i は pin_order()[i % size] に割り当てる
+    std::vector<int> pin_order() const {
+        // ノード → (コア → 論理CPU一覧)
+        std::vector<std::vector<std::vector<int>>> nodes;
+        std::vector<std::vector<int>> node_core_ids;
+        for (const auto& cpu : m_cpus) {
+            if (cpu.node >= static_cast<int>(nodes.size())) {
+                nodes.resize(cpu.node + 1);
+                node_core_ids.resize(cpu.node + 1);
+            }
+            auto& ids = node_core_ids[cpu.node];
+            auto it = std::find(ids.begin(), ids.end(), cpu.core);
+            size_t index = static_cast<size_t>(it - ids.begin());
+            if (it == ids.end()) {
+                ids.push_back(cpu.core);
+                nodes[cpu.node].emplace_back();
+            }
+            nodes[cpu.node][index].push_back(cpu.id);
+        }
+
+        std::vector<int> order;
+        for (size_t smt = 0;; ++smt) {
+            bool any = false;
+            for (size_t core = 0;; ++core) {
+                bool any_core = false;
+                for (const auto& node : nodes) {
+                    if (core < node.size()) {
+                        any_core = true;
+                        if (smt < node[core].size()) {
+                            order.push_back(node[core][smt]);
+                            any = true;
+                        }
+                    }
+                }
+                if (!any_core) break;
+            }
+            if (!any) break;
+        }
+        return order;
+    }
+
+    // 論理CPUの所属NUMAノード（不明な場合は0）
+    int node_of(int cpu_id) const {
+        for (const auto& cpu : m_cpus) {
+            if (cpu.id == cpu_id) return cpu.node;
+        }
+        return 0;
+    }
+
+    const std::vector<Cpu>& cpus() const { return m_cpus; }
+
+    // "0-3,8,10-11" 形式のCPUリストを展開する
+    static std::vector<int> parse_cpu_list(const std::string& list) {
+        std::vector<int> result;
+        std::stringstream ss(list);
+        std::string range;
+        while (std::getline(ss, range, ',')) {
+            if (range.empty()) continue;
+            size_t dash = range.find('-');
+            int first = to_int(range.substr(0, dash), -1);
+            int last = dash == std::string::npos ? first : to_int(range.substr(dash + 1), -1);
+            if (first < 0 || last < first) continue;
+            for (int cpu = first; cpu <= last; ++cpu) result.push_back(cpu);
+        }
+        return result;
+    }
+
+    // プロセスのアフィニティマスクに含まれる論理CPUの一覧
+    // @return 取得できない場合（非対応プラットフォームを含む）は空
+    static std::vector<int> process_affinity() {
+        std::vector<int> result;
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) result.push_back(cpu);
+            }
+        }
+#endif
+        return result;
+    }
+
+    // 呼び出し元スレッドを指定した論理CPUに固定する
+    // @return 成功した場合 true（非対応プラットフォームでは常に false）
+    static bool pin_current_thread(int cpu_id) {
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+        if (cpu_id < 0 || cpu_id >= CPU_SETSIZE) return false;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu_id, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)cpu_id;
+        return false;
+#endif
+    }
+
+private:
+    static std::string read_first_line(const std::string& path) {
+        std::ifstream file(path);
+        std::string line;
+        if (file) std::getline(file, line);
+        return line;
+    }
+
+    static int to_int(const std::string& text, int fallback) {
+        try {
+            size_t used = 0;
+            int value = std::stoi(text, &used);
+            return used > 0 ? value : fallback;
+        } catch (...) {
+            return fallback;
+        }
+    }
+
+    std::vector<Cpu> m_cpus;
+};
@@ -98,10 +98,10 @@ unsigned int EmbreeScene::add_triangle(float x1, float y1, float z1, float x2, f
     return geomID;
 }
 
-unsigned int EmbreeScene::add_mesh(const std::vector<float>& vertices, const std::vector<unsigned int>& indices) {
-    if (!device || !scene) return RTC_INVALID_GEOMETRY_ID;
-    if (vertices.empty() || indices.empty()) return RTC_INVALID_GEOMETRY_ID;
+namespace {
 
+// 三角形メッシュのジオメトリを作成してコミットする
+RTCGeometry new_mesh_geometry(RTCDevice device, const std::vector<float>& vertices, const std::vector<unsigned int>& indices) {
     size_t vertexCount = vertices.size() / 3;
     size_t triangleCount = indices.size() / 3;
 
@@ -111,20 +111,83 @@ unsigned int EmbreeScene::add_mesh(const std::vector<float>& vertices, const std
     float* verts = (float*)rtcSetNewGeometryBuffer(
         geom, RTC_BUFFER_TYPE_VERTEX, 0,
         RTC_FORMAT_FLOAT3, 3 * sizeof(float), vertexCount);
-    std::memcpy(verts, vertices.data(), vertices.size() * sizeof(float));
+    std::memcpy(verts, vertices.data(), vertexCount * 3 * sizeof(float));
 
     // インデックスバッファを設定
     unsigned int* idxs = (unsigned int*)rtcSetNewGeometryBuffer(
         geom, RTC_BUFFER_TYPE_INDEX, 0,
         RTC_FORMAT_UINT3, 3 * sizeof(unsigned int), triangleCount);
-    std::memcpy(idxs, indices.data(), indices.size() * sizeof(unsigned int));
+    std::memcpy(idxs, indices.data(), triangleCount * 3 * sizeof(unsigned int));
 
     rtcCommitGeometry(geom);
+    return geom;
+}
+
+// 列優先の4x4変換 m の法線変換（左上3x3の逆転置）を列ごとに求める
+// 大きさは交差時に正規化するので、行列式では割らずに符号だけ合わせる
+std::array<float, 9> normal_matrix(const float* m) {
+    const float c0[3] = {m[0], m[1], m[2]};
+    const float c1[3] = {m[4], m[5], m[6]};
+    const float c2[3] = {m[8], m[9], m[10]};
+    auto cross = [](const float* a, const float* b, float* out) {
+        out[0] = a[1] * b[2] - a[2] * b[1];
+        out[1] = a[2] * b[0] - a[0] * b[2];
+        out[2] = a[0] * b[1] - a[1] * b[0];
+    };
+    std::array<float, 9> n;
+    cross(c1, c2, &n[0]);
+    cross(c2, c0, &n[3]);
+    cross(c0, c1, &n[6]);
+    float det = c0[0] * n[0] + c0[1] * n[1] + c0[2] * n[2];
+    if (det < 0.0f) {
+        for (float& value : n) value = -value;
+    }
+    return n;
+}
+
+} // namespace
+
+unsigned int EmbreeScene::add_mesh(const std::vector<float>& vertices, const std::vector<unsigned int>& indices) {
+    if (!device || !scene) return RTC_INVALID_GEOMETRY_ID;
+    if (vertices.empty() || indices.empty()) return RTC_INVALID_GEOMETRY_ID;
+
+    RTCGeometry geom = new_mesh_geometry(device, vertices, indices);
     unsigned int geomID = rtcAttachGeometry(scene, geom);
     rtcReleaseGeometry(geom);
     return geomID;
 }
 
+std::vector<unsigned int> EmbreeScene::add_instances(const std::vector<float>& vertices, const std::vector<unsigned int>& indices,
+                                                     const std::vector<float>& transforms) {
+    std::vector<unsigned int> ids;
+    if (!device || !scene) return ids;
+    if (vertices.empty() || indices.empty() || transforms.size() < 16) return ids;
+
+    // 共有するメッシュだけを持つ子シーン（インスタンスが参照を保持するので、ここでの参照はすぐ手放してよい）
+    RTCScene child = rtcNewScene(device);
+    RTCGeometry mesh = new_mesh_geometry(device, vertices, indices);
+    rtcAttachGeometry(child, mesh);
+    rtcReleaseGeometry(mesh);
+    rtcCommitScene(child);
+
+    for (size_t i = 0; i + 16 <= transforms.size(); i += 16) {
+        RTCGeometry instance = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_INSTANCE);
+        rtcSetGeometryInstancedScene(instance, child);
+        rtcSetGeometryTransform(instance, 0, RTC_FORMAT_FLOAT4X4_COLUMN_MAJOR, &transforms[i]);
+        rtcCommitGeometry(instance);
+        unsigned int geomID = rtcAttachGeometry(scene, instance);
+        rtcReleaseGeometry(instance);
+
+        if (normal_matrices.size() <= geomID) {
+            normal_matrices.resize(geomID + 1);
+        }
+        normal_matrices[geomID] = normal_matrix(&transforms[i]);
+        ids.push_back(geomID);
+    }
+    rtcReleaseScene(child);
+    return ids;
+}
+
 void EmbreeScene::commit() {
     if (scene) {
         rtcCommitScene(scene);
@@ -133,6 +196,7 @@ void EmbreeScene::commit() {
 
 std::tuple<bool, float, float, float, float, unsigned int, unsigned int, float, float> EmbreeScene::intersect(float ox, float oy, float oz, float dx, float dy, float dz) {
     if (!scene) return {false, 0.0f, 0.0f, 0.0f, 0.0f, RTC_INVALID_GEOMETRY_ID, RTC_INVALID_GEOMETRY_ID, 0.0f, 0.0f};
+    ++t_ray_count;
 
     RTCRayHit rayhit;
     rayhit.ray.org_x = ox; rayhit.ray.org_y = oy; rayhit.ray.org_z = oz;
@@ -143,19 +207,33 @@ std::tuple<bool, float, float, float, float, unsigned int, unsigned int, float,
     rayhit.ray.flags = 0;
     rayhit.hit.geomID = RTC_INVALID_GEOMETRY_ID;
     rayhit.hit.primID = RTC_INVALID_GEOMETRY_ID;
+    rayhit.hit.instID[0] = RTC_INVALID_GEOMETRY_ID;
 
     rtcIntersect1(scene, &rayhit);
 
     if (rayhit.hit.geomID != RTC_INVALID_GEOMETRY_ID) {
-        // Normalize normal
         float nx = rayhit.hit.Ng_x;
         float ny = rayhit.hit.Ng_y;
         float nz = rayhit.hit.Ng_z;
+        unsigned int geomID = rayhit.hit.geomID;
+        // インスタンスのヒット: 法線はインスタンス内の座標系なのでワールド空間に戻し、geomID はインスタンスのものを返す
+        unsigned int instID = rayhit.hit.instID[0];
+        if (instID != RTC_INVALID_GEOMETRY_ID) {
+            geomID = instID;
+            if (instID < normal_matrices.size()) {
+                const auto& m = normal_matrices[instID];
+                float wx = m[0] * nx + m[3] * ny + m[6] * nz;
+                float wy = m[1] * nx + m[4] * ny + m[7] * nz;
+                float wz = m[2] * nx + m[5] * ny + m[8] * nz;
+                nx = wx; ny = wy; nz = wz;
+            }
+        }
+        // Normalize normal
         float len = std::sqrt(nx*nx + ny*ny + nz*nz);
         if (len > 0) {
             nx /= len; ny /= len; nz /= len;
         }
-        return {true, rayhit.ray.tfar, nx, ny, nz, rayhit.hit.geomID, rayhit.hit.primID, rayhit.hit.u, rayhit.hit.v};
+        return {true, rayhit.ray.tfar, nx, ny, nz, geomID, rayhit.hit.primID, rayhit.hit.u, rayhit.hit.v};
     } else {
         return {false, 0.0f, 0.0f, 0.0f, 0.0f, RTC_INVALID_GEOMETRY_ID, RTC_INVALID_GEOMETRY_ID, 0.0f, 0.0f};
     }
@@ -2,7 +2,9 @@
 #include <embree4/rtcore.h>
 #include <vector>
 #include <tuple>
+#include <array>
 #include <memory>
+#include <cstdint>
 
 // RAII Wrapper for Embree Device
 class EmbreeDevice {
@@ -45,13 +47,26 @@ public:
     unsigned int add_sphere(float cx, float cy, float cz, float r);
     unsigned int add_triangle(float x1, float y1, float z1, float x2, float y2, float z2, float x3, float y3, float z3);
     unsigned int add_mesh(const std::vector<float>& vertices, const std::vector<unsigned int>& indices);
+    // 1つのメッシュを複数の変換（列優先の4x4を16要素ずつ並べたフラット配列）で配置する
+    // メッシュは子シーンとして1回だけ構築し、変換ごとに Embree インスタンスを追加する
+    // @return 変換ごとの geomID（intersect はインスタンスの geomID と法線をワールド空間で返す）
+    std::vector<unsigned int> add_instances(const std::vector<float>& vertices, const std::vector<unsigned int>& indices,
+                                            const std::vector<float>& transforms);
     void commit();
     void release();
     
     // Return hit, t, nx, ny, nz, geomID, primID, baryU, baryV
     std::tuple<bool, float, float, float, float, unsigned int, unsigned int, float, float> intersect(float ox, float oy, float oz, float dx, float dy, float dz);
 
+    // 呼び出し元スレッドがこれまでに intersect したレイの数（スループット計測用）
+    static uint64_t thread_ray_count() { return t_ray_count; }
+
 private:
+    static inline thread_local uint64_t t_ray_count = 0;
+
+    // インスタンスの geomID ごとの法線変換（変換の逆転置の列、インスタンス以外は未使用）
+    std::vector<std::array<float, 9>> normal_matrices;
+
     RTCDevice device; // We might need to store device if we create geometries later, but add_sphere uses it.
     RTCScene scene;
 };
@@ -0,0 +1,174 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gltf_loader.h"
+
+// glTF の非同期読み込み
+// バックグラウンドスレッドでパースし、テクスチャはスレッドを複数立てて並列にデコードする
+// 読み込みの間は呼び出し元のロックを一切取らず、結果は完了時のコールバックでまとめて登録する
+// Lua へはハンドル（進捗・完了待ち）として渡す
+class GltfLoadJob {
+public:
+    enum class Status { Parsing, Decoding, Done, Failed };
+
+    // 完了時（成功・失敗とも、状態が Done / Failed になる直前）にジョブのスレッドから呼ばれる
+    using OnComplete = std::function<void(GltfLoadJob&)>;
+
+    // @param decode_threads テクスチャのデコードに使うスレッド数の上限（0 なら論理CPU数）
+    explicit GltfLoadJob(std::string path, unsigned int decode_threads = 0)
+        : m_path(std::move(path)), m_decode_threads(decode_threads) {}
+
+    ~GltfLoadJob() { join(); }
+
+    GltfLoadJob(const GltfLoadJob&) = delete;
+    GltfLoadJob& operator=(const GltfLoadJob&) = delete;
+
+    // 読み込み済みのデータから完了状態のジョブを作る（キャッシュ済みの場合）
+    static std::shared_ptr<GltfLoadJob> completed(std::string path, std::shared_ptr<GltfData> gltf) {
+        auto job = std::make_shared<GltfLoadJob>(std::move(path));
+        job->m_gltf = std::move(gltf);
+        job->m_status = Status::Done;
+        return job;
+    }
+
+    // バックグラウンドスレッドで読み込みを開始する（1回だけ）
+    void start(OnComplete on_complete) {
+        m_thread = std::thread([this, on_complete = std::move(on_complete)]() { run(on_complete); });
+    }
+
+    Status status() const { return m_status.load(std::memory_order_acquire); }
+
+    bool done() const {
+        Status s = status();
+        return s == Status::Done || s == Status::Failed;
+    }
+
+    static const char* status_name(Status status) {
+        switch (status) {
+            case Status::Parsing: return "parsing";
+            case Status::Decoding: return "decoding";
+            case Status::Done: return "done";
+            default: return "failed";
+        }
+    }
+
+    const std::string& path() const { return m_path; }
+
+    // テクスチャ数（パースが終わるまでは 0）と、デコードを終えた数
+    size_t textures_total() const { return m_textures_total.load(std::memory_order_acquire); }
+    size_t textures_decoded() const { return m_textures_decoded.load(std::memory_order_acquire); }
+
+    // 失敗時の理由（done() になってから参照する）
+    std::string error() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_error;
+    }
+
+    // 完了まで待つ
+    // @param timeout_ms 負なら無期限
+    // @return 時間内に完了したか
+    bool wait(int timeout_ms = -1) const {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto finished = [this] { return done(); };
+        if (timeout_ms < 0) {
+            m_done_cv.wait(lock, finished);
+            return true;
+        }
+        return m_done_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), finished);
+    }
+
+    // 読み込んだデータ（成功して done() になってから参照する）
+    std::shared_ptr<GltfData> gltf() const { return m_gltf; }
+
+    // テクスチャ番号ごとのデコード結果（デコードできなかったものは nullptr）
+    const std::vector<std::shared_ptr<TextureImage>>& textures() const { return m_textures; }
+
+    // スレッドの終了を待つ
+    void join() {
+        if (m_thread.joinable() && m_thread.get_id() != std::this_thread::get_id()) {
+            m_thread.join();
+        }
+    }
+
+private:
+    void run(const OnComplete& on_complete) {
+        auto gltf = std::make_shared<GltfData>();
+        if (!gltf->load(m_path)) {
+            finish(on_complete, Status::Failed, "failed to load glTF: " + m_path);
+            return;
+        }
+        m_gltf = gltf;
+
+        size_t count = gltf->getTextureCount();
+        m_textures.assign(count, nullptr);
+        m_textures_total.store(count, std::memory_order_release);
+        m_status.store(Status::Decoding, std::memory_order_release);
+        decode_textures(*gltf);
+        finish(on_complete, Status::Done, "");
+    }
+
+    // テクスチャを番号の早い順に取り合って並列にデコードする（各要素へ書くのは1スレッドだけ）
+    void decode_textures(const GltfData& gltf) {
+        size_t count = m_textures.size();
+        if (count == 0) return;
+        unsigned int threads = m_decode_threads > 0 ? m_decode_threads : std::max(1u, std::thread::hardware_concurrency());
+        threads = static_cast<unsigned int>(std::min<size_t>(threads, count));
+
+        std::atomic<size_t> next{0};
+        auto decode = [&]() {
+            for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+                auto image = std::make_shared<TextureImage>(gltf.getTextureImage(i));
+                if (image->width > 0 && image->height > 0) {
+                    m_textures[i] = std::move(image);
+                }
+                m_textures_decoded.fetch_add(1, std::memory_order_acq_rel);
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned int t = 1; t < threads; ++t) {
+            pool.emplace_back(decode);
+        }
+        decode();
+        for (auto& thread : pool) {
+            thread.join();
+        }
+    }
+
+    void finish(const OnComplete& on_complete, Status status, std::string error) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_error = std::move(error);
+        }
+        if (on_complete) {
+            on_complete(*this);
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_status.store(status, std::memory_order_release);
+        }
+        m_done_cv.notify_all();
+    }
+
+    std::string m_path;
+    unsigned int m_decode_threads;
+    std::thread m_thread;
+
+    mutable std::mutex m_mutex;
+    mutable std::condition_variable m_done_cv;
+    std::atomic<Status> m_status{Status::Parsing};
+    std::atomic<size_t> m_textures_total{0};
+    std::atomic<size_t> m_textures_decoded{0};
+    std::string m_error;
+
+    // ジョブのスレッドだけが書き、完了後（done() が true になってから）に読まれる
+    std::shared_ptr<GltfData> m_gltf;
+    std::vector<std::shared_ptr<TextureImage>> m_textures;
+};
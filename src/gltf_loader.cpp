@@ -1,11 +1,53 @@
 #define CGLTF_IMPLEMENTATION
 #include "cgltf.h"
 #include "gltf_loader.h"
+#include "embree_wrapper.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
 #include <iostream>
+#include <numeric>
+#include <algorithm>
+
+namespace {
+
+// 列優先の4x4行列の積 out = a * b
+void multiply(const float* a, const float* b, float* out) {
+    for (int col = 0; col < 4; ++col) {
+        for (int row = 0; row < 4; ++row) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; ++k) {
+                sum += a[k * 4 + row] * b[col * 4 + k];
+            }
+            out[col * 4 + row] = sum;
+        }
+    }
+}
+
+// 左上3x3の行列式（負なら裏返る変換）
+float determinant3(const float* m) {
+    return m[0] * (m[5] * m[10] - m[9] * m[6])
+         - m[4] * (m[1] * m[10] - m[9] * m[2])
+         + m[8] * (m[1] * m[6] - m[5] * m[2]);
+}
+
+// 頂点座標に変換を焼き込む（裏返る変換では三角形の向きを保つため頂点順を入れ替える）
+void bake_transform(std::vector<float>& vertices, std::vector<unsigned int>& indices, const float* m) {
+    for (size_t i = 0; i + 2 < vertices.size(); i += 3) {
+        float x = vertices[i], y = vertices[i + 1], z = vertices[i + 2];
+        vertices[i]     = m[0] * x + m[4] * y + m[8] * z + m[12];
+        vertices[i + 1] = m[1] * x + m[5] * y + m[9] * z + m[13];
+        vertices[i + 2] = m[2] * x + m[6] * y + m[10] * z + m[14];
+    }
+    if (determinant3(m) < 0.0f) {
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            std::swap(indices[i + 1], indices[i + 2]);
+        }
+    }
+}
+
+} // namespace
 
 // ----------------------------------------------------------------
 // GltfData
@@ -63,6 +105,140 @@ size_t GltfData::getMeshCount() const {
     return data_->meshes_count;
 }
 
+size_t GltfData::getPrimitiveCount(size_t meshIndex) const {
+    if (!data_ || meshIndex >= data_->meshes_count) return 0;
+    return data_->meshes[meshIndex].primitives_count;
+}
+
+std::vector<GltfMeshInstance> GltfData::getMeshInstances() const {
+    std::vector<GltfMeshInstance> instances;
+    if (!data_) return instances;
+
+    // 親のワールド変換を持ち回って深さ優先で辿る（cgltf_node_transform_world のように親を遡らない）
+    struct Entry {
+        const cgltf_node* node;
+        float parent[16];
+    };
+    const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    std::vector<Entry> stack;
+    auto push = [&stack](const cgltf_node* node, const float* parent) {
+        Entry entry;
+        entry.node = node;
+        std::copy(parent, parent + 16, entry.parent);
+        stack.push_back(entry);
+    };
+
+    // 既定シーン（なければ最初のシーン）のルートから。シーンがなければ親のないノードすべて
+    const cgltf_scene* scene = data_->scene ? data_->scene : (data_->scenes_count > 0 ? &data_->scenes[0] : nullptr);
+    if (scene) {
+        for (size_t i = scene->nodes_count; i-- > 0;) {
+            push(scene->nodes[i], identity);
+        }
+    } else {
+        for (size_t i = data_->nodes_count; i-- > 0;) {
+            if (!data_->nodes[i].parent) {
+                push(&data_->nodes[i], identity);
+            }
+        }
+    }
+
+    std::vector<bool> visited(data_->nodes_count, false);
+    while (!stack.empty()) {
+        Entry entry = stack.back();
+        stack.pop_back();
+        size_t index = cgltf_node_index(data_, entry.node);
+        // 不正なファイルの循環参照・重複参照は1回だけ辿る
+        if (visited[index]) continue;
+        visited[index] = true;
+
+        float local[16];
+        float world[16];
+        cgltf_node_transform_local(entry.node, local);
+        multiply(entry.parent, local, world);
+
+        if (entry.node->mesh) {
+            GltfMeshInstance instance;
+            instance.node = index;
+            instance.mesh = cgltf_mesh_index(data_, entry.node->mesh);
+            std::copy(world, world + 16, instance.world);
+            instances.push_back(instance);
+        }
+        for (size_t i = entry.node->children_count; i-- > 0;) {
+            push(entry.node->children[i], world);
+        }
+    }
+    return instances;
+}
+
+std::vector<GltfGeometry> GltfData::instantiate(EmbreeScene& scene) const {
+    std::vector<GltfGeometry> geometries;
+    if (!data_) return geometries;
+
+    // メッシュごとに参照しているノードをまとめる
+    auto instances = getMeshInstances();
+    std::vector<std::vector<const GltfMeshInstance*>> users(data_->meshes_count);
+    for (const auto& instance : instances) {
+        users[instance.mesh].push_back(&instance);
+    }
+
+    for (size_t meshIndex = 0; meshIndex < users.size(); ++meshIndex) {
+        const auto& nodes = users[meshIndex];
+        if (nodes.empty()) continue;
+        const cgltf_mesh& mesh = data_->meshes[meshIndex];
+
+        for (size_t primIndex = 0; primIndex < mesh.primitives_count; ++primIndex) {
+            const cgltf_primitive& prim = mesh.primitives[primIndex];
+            if (prim.type != cgltf_primitive_type_triangles) continue;
+
+            auto vertices = getVertices(meshIndex, primIndex);
+            auto indices = getIndices(meshIndex, primIndex);
+            size_t vertexCount = vertices.size() / 3;
+            // インデックスのないプリミティブは頂点の並び順どおり
+            if (!prim.indices) {
+                indices.resize(vertexCount);
+                std::iota(indices.begin(), indices.end(), 0u);
+            }
+            indices.resize(indices.size() / 3 * 3);
+            if (indices.empty() || *std::max_element(indices.begin(), indices.end()) >= vertexCount) continue;
+
+            GltfGeometry geometry;
+            geometry.mesh = meshIndex;
+            geometry.primitive = primIndex;
+            if (prim.material) {
+                geometry.material = static_cast<int>(cgltf_material_index(data_, prim.material));
+                const cgltf_texture* texture = prim.material->pbr_metallic_roughness.base_color_texture.texture;
+                if (prim.material->has_pbr_metallic_roughness && texture) {
+                    geometry.texture = static_cast<int>(cgltf_texture_index(data_, texture));
+                }
+            }
+
+            if (nodes.size() == 1) {
+                bake_transform(vertices, indices, nodes[0]->world);
+                geometry.geomID = scene.add_mesh(vertices, indices);
+                if (geometry.geomID == RTC_INVALID_GEOMETRY_ID) continue;
+                geometry.node = nodes[0]->node;
+                geometry.instanced = false;
+                geometries.push_back(geometry);
+                continue;
+            }
+
+            std::vector<float> transforms;
+            transforms.reserve(nodes.size() * 16);
+            for (const auto* node : nodes) {
+                transforms.insert(transforms.end(), node->world, node->world + 16);
+            }
+            auto ids = scene.add_instances(vertices, indices, transforms);
+            for (size_t i = 0; i < ids.size(); ++i) {
+                geometry.geomID = ids[i];
+                geometry.node = nodes[i]->node;
+                geometry.instanced = true;
+                geometries.push_back(geometry);
+            }
+        }
+    }
+    return geometries;
+}
+
 std::vector<float> GltfData::getVertices(size_t meshIndex, size_t primitiveIndex) const {
     if (!data_ || meshIndex >= data_->meshes_count) return {};
 
@@ -122,6 +298,11 @@ std::vector<float> GltfData::getTexCoords(size_t meshIndex, size_t primitiveInde
     return {};
 }
 
+size_t GltfData::getTextureCount() const {
+    if (!data_) return 0;
+    return data_->textures_count;
+}
+
 TextureImage GltfData::getTextureImage(size_t textureIndex) const {
     TextureImage result;
     if (!data_) return result;
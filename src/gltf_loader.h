@@ -4,6 +4,7 @@
 
 // 前方宣言 (cgltf の型はcppで使用)
 struct cgltf_data;
+class EmbreeScene;
 
 /// テクスチャ画像データ
 struct TextureImage {
@@ -13,6 +14,25 @@ struct TextureImage {
     std::vector<unsigned char> pixels;
 };
 
+/// ノード階層を展開したメッシュの配置
+struct GltfMeshInstance {
+    size_t node = 0;
+    size_t mesh = 0;
+    /// ワールド変換（列優先の4x4、glTF と同じ並び）
+    float world[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+};
+
+/// instantiate() でシーンに追加した1プリミティブ分のジオメトリ
+struct GltfGeometry {
+    unsigned int geomID = 0;
+    size_t node = 0;
+    size_t mesh = 0;
+    size_t primitive = 0;
+    int material = -1;      ///< マテリアル番号（なければ -1）
+    int texture = -1;       ///< baseColor テクスチャ番号（なければ -1）
+    bool instanced = false; ///< Embree インスタンスか（false なら変換を頂点に焼き込み済み）
+};
+
 /// glTFファイルのRAIIラッパー
 class GltfData {
 public:
@@ -36,6 +56,16 @@ public:
     /// メッシュ数を取得
     size_t getMeshCount() const;
 
+    /// 指定メッシュのプリミティブ数を取得
+    size_t getPrimitiveCount(size_t meshIndex) const;
+
+    /// 既定シーンのノード階層を辿り、メッシュを持つノードの配置を列挙する
+    std::vector<GltfMeshInstance> getMeshInstances() const;
+
+    /// ノード階層のすべてのメッシュ・プリミティブ（三角形）を scene に追加する
+    /// 1ノードだけが参照するメッシュは変換を頂点に焼き込み、複数ノードが共有するメッシュは Embree インスタンスにする
+    std::vector<GltfGeometry> instantiate(EmbreeScene& scene) const;
+
     /// 指定メッシュ・プリミティブの頂点座標を取得 (x,y,zのフラット配列)
     std::vector<float> getVertices(size_t meshIndex, size_t primitiveIndex) const;
 
@@ -45,7 +75,11 @@ public:
     /// 指定メッシュ・プリミティブのUV座標 (TEXCOORD_0) を取得 (u,vのフラット配列)
     std::vector<float> getTexCoords(size_t meshIndex, size_t primitiveIndex) const;
 
+    /// テクスチャ数を取得
+    size_t getTextureCount() const;
+
     /// 指定インデックスのテクスチャ画像を取得（デコード済み）
+    /// 読み取り専用なので、異なるテクスチャを複数スレッドから同時にデコードしてよい
     TextureImage getTextureImage(size_t textureIndex) const;
 
     /// リソースを解放する
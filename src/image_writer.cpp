@@ -0,0 +1,259 @@
+#include "image_writer.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+namespace {
+
+float channel_to_float(uint32_t color, int shift) {
+    return static_cast<float>((color >> shift) & 0xFF) / 255.0f;
+}
+
+bool check_size(int width, int height, const std::vector<uint32_t>& pixels, std::string& error) {
+    if (width <= 0 || height <= 0 || pixels.size() < static_cast<size_t>(width) * height) {
+        error = "invalid image size";
+        return false;
+    }
+    return true;
+}
+
+// リトルエンディアンでの書き込みヘルパー
+void put_u32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+void put_u64(std::string& out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+void put_f32(std::string& out, float f) {
+    uint32_t v;
+    std::memcpy(&v, &f, sizeof(v));
+    put_u32(out, v);
+}
+
+void put_attribute(std::string& out, const char* name, const char* type, const std::string& value) {
+    out.append(name);
+    out.push_back('\0');
+    out.append(type);
+    out.push_back('\0');
+    put_u32(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+bool write_file(const std::string& path, const std::string& bytes, std::string& error) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        error = "failed to open " + path;
+        return false;
+    }
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+        error = "failed to write " + path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+ImageWriter::ImageWriter() {
+    m_thread = std::thread(&ImageWriter::thread_func, this);
+}
+
+ImageWriter::~ImageWriter() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_job_cv.notify_all();
+    // 登録済みのジョブは全て書き出してから終了する
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+ImageWriter& ImageWriter::instance() {
+    static ImageWriter writer;
+    return writer;
+}
+
+bool ImageWriter::parse_format(const std::string& name, const std::string& path, Format& format) {
+    std::string key = name;
+    if (key.empty()) {
+        auto dot = path.find_last_of('.');
+        if (dot == std::string::npos) return false;
+        key = path.substr(dot + 1);
+    }
+    std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (key == "png") { format = Format::PNG; return true; }
+    if (key == "pfm") { format = Format::PFM; return true; }
+    if (key == "exr") { format = Format::EXR; return true; }
+    return false;
+}
+
+uint64_t ImageWriter::submit(const void* owner, std::string path, Format format,
+                             int width, int height, std::vector<uint32_t> pixels) {
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        id = m_next_id++;
+        m_jobs.push_back(Job{id, owner, std::move(path), format, width, height, std::move(pixels)});
+        ++m_in_flight;
+    }
+    m_job_cv.notify_one();
+    return id;
+}
+
+std::vector<ImageWriter::Result> ImageWriter::take_completed(const void* owner) {
+    std::vector<Result> results;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = std::remove_if(m_completed.begin(), m_completed.end(), [&](Completion& c) {
+        if (c.owner != owner) return false;
+        results.push_back(std::move(c.result));
+        return true;
+    });
+    m_completed.erase(it, m_completed.end());
+    return results;
+}
+
+void ImageWriter::wait_idle() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle_cv.wait(lock, [this] { return m_in_flight == 0; });
+}
+
+size_t ImageWriter::pending() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_in_flight;
+}
+
+void ImageWriter::thread_func() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_job_cv.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+            if (m_jobs.empty()) {
+                return; // m_stop かつキューが空
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        Result result;
+        result.id = job.id;
+        result.path = job.path;
+        switch (job.format) {
+            case Format::PNG: result.success = write_png(job.path, job.width, job.height, job.pixels, result.error); break;
+            case Format::PFM: result.success = write_pfm(job.path, job.width, job.height, job.pixels, result.error); break;
+            case Format::EXR: result.success = write_exr(job.path, job.width, job.height, job.pixels, result.error); break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_completed.push_back(Completion{job.owner, std::move(result)});
+            --m_in_flight;
+        }
+        m_idle_cv.notify_all();
+    }
+}
+
+bool ImageWriter::write_png(const std::string& path, int width, int height, const std::vector<uint32_t>& pixels, std::string& error) {
+    if (!check_size(width, height, pixels, error)) return false;
+    std::vector<unsigned char> rgba(static_cast<size_t>(width) * height * 4);
+    for (size_t i = 0; i * 4 < rgba.size(); ++i) {
+        uint32_t c = pixels[i];
+        rgba[i * 4 + 0] = static_cast<unsigned char>(c & 0xFF);
+        rgba[i * 4 + 1] = static_cast<unsigned char>((c >> 8) & 0xFF);
+        rgba[i * 4 + 2] = static_cast<unsigned char>((c >> 16) & 0xFF);
+        rgba[i * 4 + 3] = static_cast<unsigned char>((c >> 24) & 0xFF);
+    }
+    if (!stbi_write_png(path.c_str(), width, height, 4, rgba.data(), width * 4)) {
+        error = "failed to write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool ImageWriter::write_pfm(const std::string& path, int width, int height, const std::vector<uint32_t>& pixels, std::string& error) {
+    if (!check_size(width, height, pixels, error)) return false;
+    // PFM: RGB float、スケール負値でリトルエンディアン、下の行から順に格納
+    std::string out = "PF\n" + std::to_string(width) + " " + std::to_string(height) + "\n-1.0\n";
+    out.reserve(out.size() + static_cast<size_t>(width) * height * 12);
+    for (int y = height - 1; y >= 0; --y) {
+        for (int x = 0; x < width; ++x) {
+            uint32_t c = pixels[static_cast<size_t>(y) * width + x];
+            put_f32(out, channel_to_float(c, 0));
+            put_f32(out, channel_to_float(c, 8));
+            put_f32(out, channel_to_float(c, 16));
+        }
+    }
+    return write_file(path, out, error);
+}
+
+bool ImageWriter::write_exr(const std::string& path, int width, int height, const std::vector<uint32_t>& pixels, std::string& error) {
+    if (!check_size(width, height, pixels, error)) return false;
+    // 非圧縮スキャンラインの OpenEXR（FLOAT の B, G, R チャンネル、1ブロック1行）
+    std::string out;
+    put_u32(out, 20000630); // マジックナンバー
+    put_u32(out, 2);        // バージョン2、シングルパート・スキャンライン
+
+    // チャンネルはアルファベット順に並べる必要がある
+    std::string channels;
+    for (const char* name : {"B", "G", "R"}) {
+        channels.append(name);
+        channels.push_back('\0');
+        put_u32(channels, 2);    // pixel type: FLOAT
+        channels.append(4, '\0'); // pLinear + reserved
+        put_u32(channels, 1);    // xSampling
+        put_u32(channels, 1);    // ySampling
+    }
+    channels.push_back('\0');
+
+    std::string box;
+    put_u32(box, 0);
+    put_u32(box, 0);
+    put_u32(box, static_cast<uint32_t>(width - 1));
+    put_u32(box, static_cast<uint32_t>(height - 1));
+
+    std::string one;
+    put_f32(one, 1.0f);
+    std::string center;
+    put_f32(center, 0.0f);
+    put_f32(center, 0.0f);
+
+    put_attribute(out, "channels", "chlist", channels);
+    put_attribute(out, "compression", "compression", std::string(1, '\0'));
+    put_attribute(out, "dataWindow", "box2i", box);
+    put_attribute(out, "displayWindow", "box2i", box);
+    put_attribute(out, "lineOrder", "lineOrder", std::string(1, '\0'));
+    put_attribute(out, "pixelAspectRatio", "float", one);
+    put_attribute(out, "screenWindowCenter", "v2f", center);
+    put_attribute(out, "screenWindowWidth", "float", one);
+    out.push_back('\0');
+
+    // オフセットテーブルの後ろに各行のブロック（y, データサイズ, B行, G行, R行）が続く
+    const uint64_t line_bytes = static_cast<uint64_t>(width) * 3 * 4;
+    const uint64_t block_bytes = 8 + line_bytes;
+    const uint64_t first_block = out.size() + static_cast<uint64_t>(height) * 8;
+    out.reserve(first_block + block_bytes * height);
+    for (int y = 0; y < height; ++y) {
+        put_u64(out, first_block + block_bytes * y);
+    }
+    for (int y = 0; y < height; ++y) {
+        put_u32(out, static_cast<uint32_t>(y));
+        put_u32(out, static_cast<uint32_t>(line_bytes));
+        const uint32_t* row = pixels.data() + static_cast<size_t>(y) * width;
+        for (int shift : {16, 8, 0}) {
+            for (int x = 0; x < width; ++x) {
+                put_f32(out, channel_to_float(row[x], shift));
+            }
+        }
+    }
+    return write_file(path, out, error);
+}
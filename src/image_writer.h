@@ -0,0 +1,84 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 完成したフレームをバックグラウンドスレッドでエンコードしてファイルに書き出す
+// ワーカーやUIスレッドはピクセルを渡した時点で戻り、完了結果は依頼元ごとに後から回収する
+class ImageWriter {
+public:
+    enum class Format { PNG, PFM, EXR };
+
+    struct Result {
+        uint64_t id = 0;
+        bool success = false;
+        std::string path;
+        std::string error;
+    };
+
+    ImageWriter();
+    ~ImageWriter();
+
+    ImageWriter(const ImageWriter&) = delete;
+    ImageWriter& operator=(const ImageWriter&) = delete;
+
+    // プロセス共通のインスタンス（Luaバインディングから使用）
+    static ImageWriter& instance();
+
+    // "png" / "pfm" / "exr" を解釈する（空文字列の場合はパスの拡張子から判定）
+    static bool parse_format(const std::string& name, const std::string& path, Format& format);
+
+    // 書き出しジョブを登録する
+    // @param owner 完了結果を回収する依頼元の識別子（Luaのメインスレッドなど）
+    // @param pixels AppData と同じ RGBA8 (0xAABBGGRR) 形式、上の行から順に並ぶ
+    // @return ジョブID（1以上）
+    uint64_t submit(const void* owner, std::string path, Format format,
+                    int width, int height, std::vector<uint32_t> pixels);
+
+    // owner が依頼したジョブのうち完了したものを取り出す
+    std::vector<Result> take_completed(const void* owner);
+
+    // キューが空になり、実行中のジョブが終わるまで待つ
+    void wait_idle();
+
+    // 未完了（待機中＋実行中）のジョブ数
+    size_t pending() const;
+
+    // 同期エンコード（バックグラウンドスレッドとテストから使用）
+    // PFM/EXR は 8bit 値を 0.0〜1.0 の float に変換して書き出す
+    static bool write_png(const std::string& path, int width, int height, const std::vector<uint32_t>& pixels, std::string& error);
+    static bool write_pfm(const std::string& path, int width, int height, const std::vector<uint32_t>& pixels, std::string& error);
+    static bool write_exr(const std::string& path, int width, int height, const std::vector<uint32_t>& pixels, std::string& error);
+
+private:
+    struct Job {
+        uint64_t id;
+        const void* owner;
+        std::string path;
+        Format format;
+        int width;
+        int height;
+        std::vector<uint32_t> pixels;
+    };
+
+    struct Completion {
+        const void* owner;
+        Result result;
+    };
+
+    void thread_func();
+
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_job_cv;
+    std::condition_variable m_idle_cv;
+    std::deque<Job> m_jobs;
+    std::vector<Completion> m_completed;
+    uint64_t m_next_id = 1;
+    size_t m_in_flight = 0;
+    bool m_stop = false;
+};
@@ -57,6 +57,12 @@ void bind_imgui(sol::state& lua) {
         [](const char* label, bool selected) -> bool { return ImGui::Selectable(label, selected); }
     ));
 
+    // Checkbox: InputInt と同様に (changed, new_value) のタプルを返す
+    imgui.set_function("Checkbox", [](const char* label, bool value) -> std::tuple<bool, bool> {
+        bool changed = ImGui::Checkbox(label, &value);
+        return std::make_tuple(changed, value);
+    });
+
     // InputInt: Luaでは参照渡しできないため、(changed, new_value)のタプルを返す
     imgui.set_function("InputInt", [](const char* label, int value) -> std::tuple<bool, int> {
         bool changed = ImGui::InputInt(label, &value);
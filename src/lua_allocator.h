@@ -0,0 +1,225 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// ワーカーのLua State用のメモリアロケータ（lua_Alloc 互換）
+// 小さなブロック（MAX_POOLED_SIZE 以下）はサイズクラスごとのフリーリストから割り当て、
+// フリーリストが空の場合はワーカー専用のアリーナ（CHUNK_SIZE 単位で確保）から切り出す
+// 大きなブロックは malloc / realloc に任せる
+// 1つのアロケータは1つのスレッドからのみ使われる前提でロックを持たない（統計値のみ他スレッドから読める）
+// Lua State を閉じると全ブロックがフリーリストに戻り、次の Lua State で再利用される
+class LuaPoolAllocator {
+public:
+    static constexpr size_t GRANULARITY = 16;
+    static constexpr size_t MAX_POOLED_SIZE = 256;
+    static constexpr size_t NUM_CLASSES = MAX_POOLED_SIZE / GRANULARITY;
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    // 他スレッドから読める統計値のスナップショット
+    struct Stats {
+        uint64_t allocations = 0;       // 新規割り当て回数（realloc でのブロック移動を含む）
+        uint64_t frees = 0;             // 解放回数
+        uint64_t pooled = 0;            // うちフリーリスト/アリーナから割り当てた回数
+        uint64_t bytes_in_use = 0;      // Luaが使用中のバイト数（要求サイズの合計）
+        uint64_t peak_bytes = 0;        // bytes_in_use の最大値
+        uint64_t arena_bytes = 0;       // アリーナとして確保済みのバイト数
+    };
+
+    LuaPoolAllocator() = default;
+    LuaPoolAllocator(const LuaPoolAllocator&) = delete;
+    LuaPoolAllocator& operator=(const LuaPoolAllocator&) = delete;
+
+    ~LuaPoolAllocator() {
+        release_arena();
+    }
+
+    // lua_newstate / sol::state に渡す関数（ud にアロケータのポインタを渡す）
+    static void* alloc(void* ud, void* ptr, size_t osize, size_t nsize) {
+        return static_cast<LuaPoolAllocator*>(ud)->reallocate(ptr, osize, nsize);
+    }
+
+    void* reallocate(void* ptr, size_t osize, size_t nsize) {
+        // ptr が NULL の場合、osize はオブジェクトの種類を表すので 0 として扱う
+        if (!ptr) {
+            osize = 0;
+        }
+        if (nsize == 0) {
+            if (ptr) {
+                deallocate(ptr, osize);
+                record_free(osize);
+            }
+            return nullptr;
+        }
+        if (!ptr) {
+            void* block = allocate(nsize);
+            if (block) {
+                record_alloc(nsize);
+            }
+            return block;
+        }
+
+        // 同じサイズクラス内の伸縮はそのまま
+        if (osize <= MAX_POOLED_SIZE && nsize <= MAX_POOLED_SIZE && size_class(osize) == size_class(nsize)) {
+            record_resize(osize, nsize);
+            return ptr;
+        }
+        // 大きなブロック同士は realloc
+        if (osize > MAX_POOLED_SIZE && nsize > MAX_POOLED_SIZE) {
+            void* block = std::realloc(ptr, nsize);
+            if (block) {
+                record_resize(osize, nsize);
+                bump(m_allocations);
+            }
+            return block;
+        }
+
+        // プールと malloc の間の移動
+        void* block = allocate(nsize);
+        if (!block) {
+            // Luaは縮小が失敗しない前提なので、縮小時は元のブロックを使い続ける
+            // （以降は nsize で解放されるが、ブロックは nsize 以上あるため安全）
+            if (nsize > osize) {
+                return nullptr;
+            }
+            record_resize(osize, nsize);
+            return ptr;
+        }
+        std::memcpy(block, ptr, osize < nsize ? osize : nsize);
+        deallocate(ptr, osize);
+        record_resize(osize, nsize);
+        bump(m_allocations);
+        return block;
+    }
+
+    // 使用中のブロックが無い場合にアリーナをOSに返す
+    // （Lua Stateを破棄した後、別のCPUに固定し直す前などに呼ぶ）
+    // @return 返却した場合 true
+    bool trim() {
+        if (m_bytes_in_use.load(std::memory_order_relaxed) != 0) {
+            return false;
+        }
+        release_arena();
+        return true;
+    }
+
+    Stats stats() const {
+        Stats s;
+        s.allocations = m_allocations.load(std::memory_order_relaxed);
+        s.frees = m_frees.load(std::memory_order_relaxed);
+        s.pooled = m_pooled.load(std::memory_order_relaxed);
+        s.bytes_in_use = m_bytes_in_use.load(std::memory_order_relaxed);
+        s.peak_bytes = m_peak_bytes.load(std::memory_order_relaxed);
+        s.arena_bytes = m_arena_bytes.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static size_t size_class(size_t size) {
+        return (size + GRANULARITY - 1) / GRANULARITY - 1;
+    }
+
+    void* allocate(size_t size) {
+        if (size > MAX_POOLED_SIZE) {
+            return std::malloc(size);
+        }
+        size_t index = size_class(size);
+        FreeBlock* block = m_free[index];
+        if (block) {
+            m_free[index] = block->next;
+        } else {
+            block = static_cast<FreeBlock*>(carve((index + 1) * GRANULARITY));
+            if (!block) {
+                return nullptr;
+            }
+        }
+        bump(m_pooled);
+        return block;
+    }
+
+    void deallocate(void* ptr, size_t size) {
+        if (size > MAX_POOLED_SIZE) {
+            std::free(ptr);
+            return;
+        }
+        size_t index = size_class(size);
+        FreeBlock* block = static_cast<FreeBlock*>(ptr);
+        block->next = m_free[index];
+        m_free[index] = block;
+    }
+
+    // アリーナの末尾から size バイトを切り出す（足りなければ新しいチャンクを確保）
+    void* carve(size_t size) {
+        if (static_cast<size_t>(m_end - m_cursor) < size) {
+            char* chunk = static_cast<char*>(std::malloc(CHUNK_SIZE));
+            if (!chunk) {
+                return nullptr;
+            }
+            m_chunks.push_back(chunk);
+            m_cursor = chunk;
+            m_end = chunk + CHUNK_SIZE;
+            bump(m_arena_bytes, CHUNK_SIZE);
+        }
+        void* block = m_cursor;
+        m_cursor += size;
+        return block;
+    }
+
+    void release_arena() {
+        for (char* chunk : m_chunks) {
+            std::free(chunk);
+        }
+        m_chunks.clear();
+        for (auto& head : m_free) {
+            head = nullptr;
+        }
+        m_cursor = m_end = nullptr;
+        m_arena_bytes.store(0, std::memory_order_relaxed);
+    }
+
+    // 統計値の書き込みスレッドは1つなので、アトミックな read-modify-write を使わず load + store で更新する
+    static void bump(std::atomic<uint64_t>& counter, uint64_t amount = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+    void record_alloc(size_t size) {
+        bump(m_allocations);
+        add_bytes(size);
+    }
+    void record_free(size_t size) {
+        bump(m_frees);
+        bump(m_bytes_in_use, 0 - static_cast<uint64_t>(size));
+    }
+    void record_resize(size_t osize, size_t nsize) {
+        if (nsize >= osize) {
+            add_bytes(nsize - osize);
+        } else {
+            bump(m_bytes_in_use, 0 - static_cast<uint64_t>(osize - nsize));
+        }
+    }
+    void add_bytes(size_t size) {
+        bump(m_bytes_in_use, size);
+        uint64_t in_use = m_bytes_in_use.load(std::memory_order_relaxed);
+        if (in_use > m_peak_bytes.load(std::memory_order_relaxed)) {
+            m_peak_bytes.store(in_use, std::memory_order_relaxed);
+        }
+    }
+
+    FreeBlock* m_free[NUM_CLASSES] = {};
+    std::vector<char*> m_chunks;
+    char* m_cursor = nullptr;
+    char* m_end = nullptr;
+
+    std::atomic<uint64_t> m_allocations{0};
+    std::atomic<uint64_t> m_frees{0};
+    std::atomic<uint64_t> m_pooled{0};
+    std::atomic<uint64_t> m_bytes_in_use{0};
+    std::atomic<uint64_t> m_peak_bytes{0};
+    std::atomic<uint64_t> m_arena_bytes{0};
+};
@@ -3,12 +3,463 @@
 #include "imgui_lua_binding.h"
 #include "embree_wrapper.h"
 #include "gltf_loader.h"
+#include "image_writer.h"
 #include "imgui.h"
 #include <iostream>
 
 #include "app.h"
 #include "app_data.h"
 #include "thread_worker.h"
+#include "cpu_topology.h"
+#include "bytecode_cache.h"
+#include "vec3_module.h"
+#include "lua_gc.h"
+#include "raw_bindings.h"
+#include "lua_profiler.h"
+
+namespace {
+
+// GC設定テーブル {mode, pause, step_multiplier, step_size, minor_multiplier, major_multiplier, tile_step_kb} を読み取る
+// 省略したパラメータは 0（Luaの現在値を変更しない）
+// @return 不明なモードの場合 false
+bool parse_gc_settings(const sol::table& cfg, LuaGcSettings& out) {
+    LuaGcSettings settings;
+    std::string mode = cfg["mode"].get_or(std::string(LuaGcSettings::mode_name(settings.mode)));
+    if (!LuaGcSettings::parse_mode(mode, settings.mode)) {
+        std::cerr << "Unknown GC mode: " << mode << std::endl;
+        return false;
+    }
+    settings.pause = cfg["pause"].get_or(0);
+    settings.step_multiplier = cfg["step_multiplier"].get_or(0);
+    settings.step_size = cfg["step_size"].get_or(0);
+    settings.minor_multiplier = cfg["minor_multiplier"].get_or(0);
+    settings.major_multiplier = cfg["major_multiplier"].get_or(0);
+    settings.tile_step_kb = cfg["tile_step_kb"].get_or(0);
+    out = settings;
+    return true;
+}
+
+sol::table gc_stats_table(sol::this_state ts, const LuaGcStats& stats) {
+    sol::state_view lua(ts);
+    return lua.create_table_with(
+        "collections", stats.collections.load(std::memory_order_relaxed),
+        "steps", stats.steps.load(std::memory_order_relaxed),
+        "step_ms", stats.step_ns.load(std::memory_order_relaxed) / 1e6
+    );
+}
+
+// object を this に束縛した高速パスの関数を返す（raw_bindings.h）
+sol::object raw_method(sol::this_state ts, void* object, lua_CFunction fn) {
+    raw_bindings::push_method(ts.lua_state(), object, fn);
+    return sol::stack::pop<sol::object>(ts.lua_state());
+}
+
+// メインステートのGC統計（シングルスレッドのレンダリングとUI）
+LuaGcStats g_main_gc_stats;
+
+// プロファイラの集計を { [折りたたみスタック] = {samples, ns} } のテーブルにする
+sol::table profile_table(sol::this_state ts, const LuaProfiler::Stacks& stacks) {
+    sol::state_view lua(ts);
+    sol::table result = lua.create_table(0, static_cast<int>(stacks.size()));
+    for (const auto& [stack, entry] : stacks) {
+        result[stack] = lua.create_table_with("samples", entry.samples, "ns", entry.ns);
+    }
+    return result;
+}
+
+// メインステートのサンプリングプロファイラ（シングルスレッドのレンダリングとUI）
+LuaProfiler g_main_profiler;
+
+// マテリアルグラフのノード配列 { {op, inputs = {...}, value = n|{r, g, b}, texture = name}, ... } を読み取る
+// inputs は Lua の 1 始まりのノード番号
+std::vector<MaterialProgram::Node> parse_material_nodes(const sol::table& nodes) {
+    std::vector<MaterialProgram::Node> result;
+    for (size_t i = 1; i <= nodes.size(); ++i) {
+        sol::table entry = nodes[i];
+        MaterialProgram::Node node;
+        node.op = entry.get_or<std::string>("op", "");
+        if (sol::optional<sol::table> inputs = entry["inputs"]) {
+            for (size_t k = 1; k <= inputs->size(); ++k) {
+                node.inputs.push_back(inputs->get<int>(k) - 1);
+            }
+        }
+        sol::object value = entry["value"];
+        if (value.is<float>()) {
+            node.value[0] = node.value[1] = node.value[2] = value.as<float>();
+        } else if (value.is<sol::table>()) {
+            sol::table rgb = value.as<sol::table>();
+            for (int ch = 0; ch < 3; ++ch) {
+                node.value[ch] = rgb.get_or(ch + 1, 0.0f);
+            }
+        }
+        node.texture = entry.get_or<std::string>("texture", "");
+        result.push_back(std::move(node));
+    }
+    return result;
+}
+
+// GltfData::instantiate の結果を { {geom_id, node, mesh, primitive, material, texture, instanced}, ... } にする
+// 番号は get_gltf_vertices / load_texture_image などと同じ 0 始まり（マテリアル・テクスチャがなければ nil）
+sol::table gltf_geometries_table(sol::state_view lua, const std::vector<GltfGeometry>& geometries) {
+    sol::table result = lua.create_table(static_cast<int>(geometries.size()), 0);
+    for (size_t i = 0; i < geometries.size(); ++i) {
+        const GltfGeometry& geometry = geometries[i];
+        sol::table entry = lua.create_table(0, 7);
+        entry["geom_id"] = geometry.geomID;
+        entry["node"] = geometry.node;
+        entry["mesh"] = geometry.mesh;
+        entry["primitive"] = geometry.primitive;
+        if (geometry.material >= 0) entry["material"] = geometry.material;
+        if (geometry.texture >= 0) entry["texture"] = geometry.texture;
+        entry["instanced"] = geometry.instanced;
+        result[i + 1] = entry;
+    }
+    return result;
+}
+
+// 共有ストアのスナップショットをLuaから参照するためのビュー
+// スナップショットを保持するだけで、要素はアクセス時にネイティブ配列から直接読む
+struct SharedView {
+    SharedSnapshot value;
+
+    // 1-indexed で要素を取得（範囲外は nil、int配列とバイナリは整数として返す）
+    sol::object get(sol::this_state ts, int index) const {
+        size_t i = static_cast<size_t>(index - 1);
+        if (index < 1 || i >= value->size()) {
+            return sol::make_object(ts, sol::nil);
+        }
+        switch (value->type) {
+            case SharedValue::Type::FloatArray: return sol::make_object(ts, value->floats[i]);
+            case SharedValue::Type::IntArray: return sol::make_object(ts, static_cast<lua_Integer>(value->ints[i]));
+            case SharedValue::Type::Blob: return sol::make_object(ts, static_cast<lua_Integer>(static_cast<uint8_t>(value->blob[i])));
+            default: return sol::make_object(ts, value->number);
+        }
+    }
+};
+
+const char* shared_type_name(SharedValue::Type type) {
+    switch (type) {
+        case SharedValue::Type::FloatArray: return "floats";
+        case SharedValue::Type::IntArray: return "ints";
+        case SharedValue::Type::Blob: return "blob";
+        default: return "number";
+    }
+}
+
+// 数値は Lua の数値として、それ以外はビューとして返す
+sol::object push_snapshot(sol::this_state ts, SharedSnapshot snapshot) {
+    if (!snapshot) {
+        return sol::make_object(ts, sol::nil);
+    }
+    if (snapshot->type == SharedValue::Type::Number) {
+        return sol::make_object(ts, snapshot->number);
+    }
+    return sol::make_object(ts, SharedView{std::move(snapshot)});
+}
+
+// save_async のコールバックを保持するレジストリ上のテーブル
+const char* kSaveCallbacksKey = "lua_ray.save_callbacks";
+
+sol::table save_callbacks(sol::state_view lua) {
+    sol::object existing = lua.registry()[kSaveCallbacksKey];
+    if (existing.is<sol::table>()) {
+        return existing.as<sol::table>();
+    }
+    sol::table callbacks = lua.create_table();
+    lua.registry()[kSaveCallbacksKey] = callbacks;
+    return callbacks;
+}
+
+// 完了した書き出しジョブのコールバックを呼び出す（このLua Stateが依頼したものだけ）
+// @return 処理した完了通知の数
+int dispatch_save_callbacks(sol::this_state ts) {
+    lua_State* main = sol::main_thread(ts.lua_state(), ts.lua_state());
+    auto results = ImageWriter::instance().take_completed(main);
+    if (results.empty()) {
+        return 0;
+    }
+    sol::state_view lua(main);
+    sol::table callbacks = save_callbacks(lua);
+    for (const auto& result : results) {
+        sol::object cb = callbacks[result.id];
+        callbacks[result.id] = sol::nil;
+        if (cb.is<sol::protected_function>()) {
+            sol::protected_function fn = cb.as<sol::protected_function>();
+            auto call = fn(result.success, result.path, result.error);
+            if (!call.valid()) {
+                sol::error err = call;
+                std::cerr << "save_async callback error: " << err.what() << std::endl;
+            }
+        }
+    }
+    return static_cast<int>(results.size());
+}
+
+} // namespace
+
+void bind_shared_store(sol::state& lua, sol::usertype<AppData>& app_data_type) {
+    lua.new_usertype<SharedView>("SharedView",
+        sol::no_constructor,
+        "type", [](const SharedView& self) { return shared_type_name(self.value->type); },
+        "size", [](const SharedView& self) { return self.value->size(); },
+        "get", &SharedView::get,
+        "to_string", [](const SharedView& self) {
+            return self.value->type == SharedValue::Type::Blob ? self.value->blob : std::string();
+        },
+        "to_table", [](const SharedView& self, sol::this_state ts) {
+            int n = static_cast<int>(self.value->size());
+            sol::state_view state(ts);
+            sol::table result = state.create_table(n, 0);
+            for (int i = 1; i <= n; ++i) {
+                result[i] = self.get(ts, i);
+            }
+            return result;
+        },
+        sol::meta_function::index, &SharedView::get,
+        sol::meta_function::length, [](const SharedView& self) { return self.value->size(); }
+    );
+
+    app_data_type["store_slot"] = [](AppData& self, const std::string& name) { return self.store().slot(name); };
+    app_data_type["store_number"] = [](AppData& self, const std::string& name, double value) {
+        self.store().set_number(name, value);
+    };
+    app_data_type["store_floats"] = [](AppData& self, const std::string& name, sol::table values) {
+        std::vector<float> data(values.size());
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = values[i + 1].get_or(0.0f);
+        }
+        self.store().set_floats(name, std::move(data));
+    };
+    app_data_type["store_ints"] = [](AppData& self, const std::string& name, sol::table values) {
+        std::vector<int32_t> data(values.size());
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = values[i + 1].get_or(0);
+        }
+        self.store().set_ints(name, std::move(data));
+    };
+    app_data_type["store_blob"] = [](AppData& self, const std::string& name, const std::string& bytes) {
+        self.store().set_blob(name, bytes);
+    };
+    app_data_type["store_remove"] = [](AppData& self, const std::string& name) { self.store().remove(name); };
+    // 名前またはスロット番号で最新のスナップショットを取得する
+    app_data_type["store_get"] = sol::overload(
+        [](AppData& self, int slot, sol::this_state ts) { return push_snapshot(ts, self.store().snapshot(slot)); },
+        [](AppData& self, const std::string& name, sol::this_state ts) { return push_snapshot(ts, self.store().get(name)); }
+    );
+}
+
+void bind_tile_scheduler(sol::state& lua, sol::usertype<AppData>& app_data_type) {
+    lua.new_usertype<TileScheduler>("TileScheduler",
+        sol::no_constructor,
+        // 次のタイルを x, y, w, h で返す（全キューが空なら nil）
+        "next_tile", [](TileScheduler& self, sol::optional<int> queue_index, sol::this_state ts) {
+            sol::variadic_results results;
+            TileScheduler::Tile tile;
+            if (!self.next(queue_index.value_or(0), tile)) {
+                results.push_back(sol::make_object(ts, sol::nil));
+                return results;
+            }
+            results.push_back(sol::make_object(ts, tile.x));
+            results.push_back(sol::make_object(ts, tile.y));
+            results.push_back(sol::make_object(ts, tile.w));
+            results.push_back(sol::make_object(ts, tile.h));
+            return results;
+        },
+        "remaining", &TileScheduler::remaining,
+        "size", &TileScheduler::size,
+        "num_queues", &TileScheduler::num_queues,
+        "complete_tile", &TileScheduler::complete_tile,
+        "wait_completed", [](const TileScheduler& self, sol::optional<int> timeout_ms) {
+            return self.wait_completed(timeout_ms.value_or(-1));
+        },
+        "retired", &TileScheduler::retired
+    );
+
+    // タイルを [x, y, w, h, ...] のフラットな配列で受け取り、num_queues 個のキューに分配する
+    app_data_type["setup_tiles"] = [](AppData& self, const std::string& name, sol::table packed, sol::optional<int> num_queues) {
+        std::vector<TileScheduler::Tile> tiles(packed.size() / 4);
+        for (size_t i = 0; i < tiles.size(); ++i) {
+            tiles[i] = TileScheduler::Tile{
+                packed[i * 4 + 1].get_or(0), packed[i * 4 + 2].get_or(0),
+                packed[i * 4 + 3].get_or(0), packed[i * 4 + 4].get_or(0)
+            };
+        }
+        self.setup_tiles(name, std::move(tiles), num_queues.value_or(1));
+    };
+    // 古い世代のワーカーが保持していても安全なよう、共有所有のままLuaへ渡す（未登録なら nil）
+    app_data_type["tile_queue"] = &AppData::tile_queue;
+    // ワーカーがエラーで中断したときに呼び、他のワーカーのタイル取得と待ち合わせを打ち切る
+    app_data_type["abort_tiles"] = &AppData::abort_tiles;
+
+    // 依存関係付きタイルキュー（レンダリングとPostEffectのパイプライン）
+    lua.new_usertype<TileDependencyQueue>("TileDependencyQueue",
+        sol::no_constructor,
+        "complete_render_tile", &TileDependencyQueue::complete_render_tile,
+        // 取得可能なPostEffectタイルを x, y, w, h で返す（今すぐ取得できなければ nil）
+        "next_tile", [](TileDependencyQueue& self, sol::this_state ts) {
+            sol::variadic_results results;
+            TileDependencyQueue::Tile tile;
+            if (!self.next(tile)) {
+                results.push_back(sol::make_object(ts, sol::nil));
+                return results;
+            }
+            results.push_back(sol::make_object(ts, tile.x));
+            results.push_back(sol::make_object(ts, tile.y));
+            results.push_back(sol::make_object(ts, tile.w));
+            results.push_back(sol::make_object(ts, tile.h));
+            return results;
+        },
+        "finished", &TileDependencyQueue::finished,
+        "remaining", &TileDependencyQueue::remaining,
+        "wait_ready", [](const TileDependencyQueue& self, sol::optional<int> timeout_ms) {
+            return self.wait_ready(timeout_ms.value_or(-1));
+        },
+        "retired", &TileDependencyQueue::retired,
+        "size", &TileDependencyQueue::size
+    );
+
+    // render_packed / post_packed は setup_tiles と同じ [x, y, w, h, ...] 形式
+    app_data_type["setup_dependent_tiles"] = [](AppData& self, const std::string& name, sol::table render_packed,
+                                                sol::table post_packed, int radius, sol::optional<int> flip_height) {
+        auto unpack = [](sol::table packed) {
+            std::vector<TileScheduler::Tile> tiles(packed.size() / 4);
+            for (size_t i = 0; i < tiles.size(); ++i) {
+                tiles[i] = TileScheduler::Tile{
+                    packed[i * 4 + 1].get_or(0), packed[i * 4 + 2].get_or(0),
+                    packed[i * 4 + 3].get_or(0), packed[i * 4 + 4].get_or(0)
+                };
+            }
+            return tiles;
+        };
+        self.setup_dependent_tiles(name, unpack(render_packed), unpack(post_packed), radius, flip_height.value_or(0));
+    };
+    app_data_type["remove_dependent_tiles"] = &AppData::remove_dependent_tiles;
+    app_data_type["dependent_tiles"] = &AppData::dependent_tiles;
+    app_data_type["set_post_pass"] = [](AppData&, bool enabled) { AppData::set_post_pass(enabled); };
+
+    // レンダー世代（世代を進めると実行中のタイルキューが打ち切られ、古いワーカーの書き込みは破棄される）
+    app_data_type["render_generation"] = &AppData::render_generation;
+    app_data_type["advance_render_generation"] = &AppData::advance_render_generation;
+
+    // レベル間の待ち合わせに使う名前付き同期プリミティブ
+    bind_sync_registry(lua, app_data_type);
+
+    // タイル単位の進捗・スループット統計
+    bind_render_stats(lua, app_data_type);
+}
+
+void bind_sync_registry(sol::state&, sol::usertype<AppData>& app_data_type) {
+    // 上限を超えた登録や範囲外のスロットは黙って無視せず Lua エラーにする
+    auto checked = [](int slot, int max, const char* kind) {
+        if (slot < 0 || slot >= max) {
+            throw sol::error(std::string("sync registry: invalid or exhausted ") + kind + " slot");
+        }
+        return slot;
+    };
+
+    // 名前付き同期プリミティブ（スロット番号を一度取得すれば以降はロックフリー）
+    app_data_type["counter_slot"] = [checked](AppData& self, const std::string& name) {
+        return checked(self.sync().counter_slot(name), SyncRegistry::MAX_COUNTERS, "counter");
+    };
+    app_data_type["counter_load"] = [checked](AppData& self, int slot) {
+        return self.sync().counter_load(checked(slot, SyncRegistry::MAX_COUNTERS, "counter"));
+    };
+    app_data_type["counter_store"] = [checked](AppData& self, int slot, int64_t value) {
+        self.sync().counter_store(checked(slot, SyncRegistry::MAX_COUNTERS, "counter"), value);
+    };
+    app_data_type["counter_fetch_add"] = [checked](AppData& self, int slot, sol::optional<int64_t> delta) {
+        return self.sync().counter_fetch_add(checked(slot, SyncRegistry::MAX_COUNTERS, "counter"), delta.value_or(1));
+    };
+    app_data_type["counter_compare_exchange"] = [checked](AppData& self, int slot, int64_t expected, int64_t desired) {
+        return self.sync().counter_compare_exchange(checked(slot, SyncRegistry::MAX_COUNTERS, "counter"), expected, desired);
+    };
+    app_data_type["barrier_slot"] = [checked](AppData& self, const std::string& name, int participants) {
+        return checked(self.sync().barrier_slot(name, participants), SyncRegistry::MAX_BARRIERS, "barrier");
+    };
+    app_data_type["barrier_reset"] = [checked](AppData& self, int slot, int participants) {
+        self.sync().barrier_reset(checked(slot, SyncRegistry::MAX_BARRIERS, "barrier"), participants);
+    };
+    app_data_type["barrier_arrive"] = [checked](AppData& self, int slot) {
+        return self.sync().barrier_arrive(checked(slot, SyncRegistry::MAX_BARRIERS, "barrier"));
+    };
+    app_data_type["barrier_wait"] = [checked](AppData& self, int slot, int64_t phase, sol::optional<int> timeout_ms) {
+        return self.sync().barrier_wait(checked(slot, SyncRegistry::MAX_BARRIERS, "barrier"), phase, timeout_ms.value_or(-1));
+    };
+    // 既存のラッチを引くだけなら count は省略できる（新規作成時は 0）
+    app_data_type["latch_slot"] = [checked](AppData& self, const std::string& name, sol::optional<int64_t> count) {
+        return checked(self.sync().latch_slot(name, count.value_or(0)), SyncRegistry::MAX_LATCHES, "latch");
+    };
+    app_data_type["latch_reset"] = [checked](AppData& self, int slot, int64_t count) {
+        self.sync().latch_reset(checked(slot, SyncRegistry::MAX_LATCHES, "latch"), count);
+    };
+    // 古い世代のワーカーからのカウントダウンは無視される
+    app_data_type["latch_count_down"] = [checked](AppData& self, int slot, sol::optional<int64_t> n) {
+        self.count_down_latch(checked(slot, SyncRegistry::MAX_LATCHES, "latch"), n.value_or(1));
+    };
+    app_data_type["latch_try_wait"] = [checked](AppData& self, int slot) {
+        return self.sync().latch_try_wait(checked(slot, SyncRegistry::MAX_LATCHES, "latch"));
+    };
+    app_data_type["latch_wait"] = [checked](AppData& self, int slot, sol::optional<int> timeout_ms) {
+        return self.sync().latch_wait(checked(slot, SyncRegistry::MAX_LATCHES, "latch"), timeout_ms.value_or(-1));
+    };
+}
+
+void bind_render_stats(sol::state& lua, sol::usertype<AppData>& app_data_type) {
+    lua.new_usertype<RenderStats>("RenderStats",
+        sol::no_constructor,
+        // ジョブ開始時に呼び出し元スレッドの EmbreeScene::intersect 回数を基準として記録する
+        "begin", [](RenderStats& self, int worker_index) {
+            self.begin(worker_index, EmbreeScene::thread_ray_count());
+        },
+        // タイル完了の報告（レイ数は begin() または前回の報告からの intersect 回数の差分）
+        "record_tile", [](RenderStats& self, int worker_index, uint64_t pixels) {
+            self.record_tile_at(worker_index, pixels, EmbreeScene::thread_ray_count());
+        },
+        "finish", &RenderStats::finish,
+        "finished", &RenderStats::finished,
+        "progress", &RenderStats::progress,
+        "eta_seconds", &RenderStats::eta_seconds,
+        "elapsed_seconds", &RenderStats::elapsed_seconds,
+        "num_workers", &RenderStats::num_workers,
+        // 進捗・ETA・ワーカーごとの件数と毎秒のスループットをテーブルで返す（UI表示・ログ用）
+        "snapshot", [](const RenderStats& self, sol::this_state ts) {
+            sol::state_view lua(ts);
+            double elapsed = self.elapsed_seconds();
+            double inv = elapsed > 0.0 ? 1.0 / elapsed : 0.0;
+            auto to_table = [&](const RenderStats::Counters& counters) {
+                sol::table entry = lua.create_table();
+                entry["tiles"] = counters.tiles;
+                entry["pixels"] = counters.pixels;
+                entry["samples"] = counters.samples;
+                entry["rays"] = counters.rays;
+                entry["pixels_per_sec"] = counters.pixels * inv;
+                entry["samples_per_sec"] = counters.samples * inv;
+                entry["rays_per_sec"] = counters.rays * inv;
+                return entry;
+            };
+
+            sol::table result = to_table(self.total());
+            result["elapsed"] = elapsed;
+            result["progress"] = self.progress();
+            result["eta"] = self.eta_seconds();
+            result["finished"] = self.finished();
+            result["total_pixels"] = self.total_pixels();
+            sol::table workers = lua.create_table();
+            for (int i = 0; i < self.num_workers(); ++i) {
+                workers[i + 1] = to_table(self.worker(i));
+            }
+            result["workers"] = workers;
+            return result;
+        }
+    );
+
+    // 統計は名前付きで共有し、古い世代のワーカーが保持していても安全なよう共有所有のまま渡す（未登録なら nil）
+    app_data_type["setup_render_stats"] = [](AppData& self, const std::string& name, int num_workers,
+                                             uint64_t total_pixels, sol::optional<int> samples_per_pixel) {
+        return self.setup_render_stats(name, num_workers, total_pixels, samples_per_pixel.value_or(1));
+    };
+    app_data_type["render_stats"] = &AppData::render_stats;
+}
 
 // Helper to bind common types (AppData, Embree, GltfData) to any state
 void bind_common_types(sol::state& lua) {
@@ -24,29 +475,122 @@ void bind_common_types(sol::state& lua) {
         "add_sphere", &EmbreeScene::add_sphere,
         "add_triangle", &EmbreeScene::add_triangle,
         "add_mesh", &EmbreeScene::add_mesh,
+        "add_instances", &EmbreeScene::add_instances,
         "commit", &EmbreeScene::commit,
         "intersect", &EmbreeScene::intersect,
+        // intersect の高速パス: local intersect = scene:raw_intersect() で取得し、intersect(scene, ox, oy, oz, dx, dy, dz) と呼ぶ
+        "raw_intersect", [](EmbreeScene& self, sol::this_state ts) { return raw_method(ts, &self, &raw_bindings::intersect); },
         "release", &EmbreeScene::release
     );
 
+    // コンパイル済みのマテリアルグラフ（app_data:get_material で取得）
+    lua.new_usertype<MaterialProgram>("MaterialProgram",
+        sol::no_constructor,
+        // eval(nx, ny, nz, vx, vy, vz, lx, ly, lz, u, v) -> r, g, b（法線・視線・光源方向は正規化済み、u, v はテクスチャ座標）
+        "eval", [](const MaterialProgram& self, float nx, float ny, float nz, float vx, float vy, float vz,
+                   float lx, float ly, float lz, float u, float v) {
+            float r, g, b;
+            self.evaluate(ShadingInput{nx, ny, nz, vx, vy, vz, lx, ly, lz, u, v}, r, g, b);
+            return std::make_tuple(r, g, b);
+        },
+        "instruction_count", &MaterialProgram::instruction_count
+    );
+
+    // 非同期 glTF 読み込みのハンドル（app_data:load_gltf_async で取得）
+    lua.new_usertype<GltfLoadJob>("GltfLoadJob",
+        sol::no_constructor,
+        "done", &GltfLoadJob::done,
+        // "parsing" / "decoding" / "done" / "failed"
+        "status", [](const GltfLoadJob& self) { return std::string(GltfLoadJob::status_name(self.status())); },
+        // progress() -> デコード済みのテクスチャ数, テクスチャ数（パース中は 0, 0）
+        "progress", [](const GltfLoadJob& self) { return std::make_tuple(self.textures_decoded(), self.textures_total()); },
+        "error", &GltfLoadJob::error,
+        // wait(timeout_ms) -> 成功したか, エラーメッセージ（timeout_ms を省略すると完了まで待つ。時間切れは false, "timeout"）
+        "wait", [](const GltfLoadJob& self, sol::optional<int> timeout_ms, sol::this_state ts) -> std::tuple<bool, sol::object> {
+            if (!self.wait(timeout_ms.value_or(-1))) {
+                return std::make_tuple(false, sol::make_object(ts, "timeout"));
+            }
+            if (self.status() == GltfLoadJob::Status::Failed) {
+                return std::make_tuple(false, sol::make_object(ts, self.error()));
+            }
+            return std::make_tuple(true, sol::make_object(ts, sol::nil));
+        }
+    );
+
     // Bind AppData
-    lua.new_usertype<AppData>("AppData",
+    auto app_data_type = lua.new_usertype<AppData>("AppData",
         sol::constructors<AppData(int, int)>(),
         "set_pixel", &AppData::set_pixel,
         "get_pixel", &AppData::get_pixel,
+        // set_pixel / get_pixel の高速パス（sol2 のディスパッチを通さない。呼び出し方は元のメソッドと同じ）
+        "raw_set_pixel", [](AppData& self, sol::this_state ts) { return raw_method(ts, &self, &raw_bindings::set_pixel); },
+        "raw_get_pixel", [](AppData& self, sol::this_state ts) { return raw_method(ts, &self, &raw_bindings::get_pixel); },
+        // プログレッシブプレビュー: 呼び出し元スレッドの set_pixel を size×size のブロック書き込みにする
+        "set_splat_size", [](AppData&, int size) { AppData::set_splat_size(size); },
+        "splat_size", [](const AppData&) { return AppData::splat_size(); },
         "swap", &AppData::swap,
+        "present", &AppData::present,
+        "display_generation", [](const AppData& self) { return self.get_generation(AppData::FRONT); },
         "copy_front_to_back", &AppData::copy_front_to_back,
         "copy_back_to_front", &AppData::copy_back_to_front,
         "width", &AppData::get_width,
         "height", &AppData::get_height,
         "clear", &AppData::clear,
         "clear_back_buffer", &AppData::clear_back_buffer,
+        // AOV（アルベド・法線・深度・オブジェクトID）
+        "enable_aovs", &AppData::enable_aovs,
+        "disable_aovs", &AppData::disable_aovs,
+        "has_aovs", &AppData::has_aovs,
+        "set_aov", &AppData::set_aov,
+        "get_albedo", &AppData::get_albedo,
+        "get_normal", &AppData::get_normal,
+        "get_depth", &AppData::get_depth,
+        "get_object_id", &AppData::get_object_id,
+        // フロントバッファをバックグラウンドで画像ファイルに書き出す
+        // @return ジョブID（失敗時は nil とエラーメッセージ）。完了時 callback(success, path, error) は app.poll_saves() から呼ばれる
+        "save_async", [](AppData& self, const std::string& path, sol::optional<std::string> format_name,
+                         sol::optional<sol::protected_function> callback, sol::this_state ts) -> std::tuple<sol::object, sol::object> {
+            ImageWriter::Format format;
+            if (!ImageWriter::parse_format(format_name.value_or(""), path, format)) {
+                return std::make_tuple(sol::make_object(ts, sol::nil), sol::make_object(ts, "unsupported image format: " + path));
+            }
+            lua_State* main = sol::main_thread(ts.lua_state(), ts.lua_state());
+            uint64_t id = ImageWriter::instance().submit(main, path, format, self.get_width(), self.get_height(), self.copy_front_pixels());
+            if (callback) {
+                save_callbacks(sol::state_view(main))[id] = *callback;
+            }
+            return std::make_tuple(sol::make_object(ts, id), sol::make_object(ts, sol::nil));
+        },
         "set_string", &AppData::set_string,
         "get_string", &AppData::get_string,
         "has_string", &AppData::has_string,
         "pop_next_index", &AppData::pop_next_index,
         "load_gltf", &AppData::load_gltf,
+        // バックグラウンドで読み込み、テクスチャを並列にデコードして "<name>_tex<番号>" でキャッシュする
+        "load_gltf_async", [](AppData& self, const std::string& name, const std::string& path, sol::optional<unsigned int> decode_threads) {
+            return self.load_gltf_async(name, path, decode_threads.value_or(0));
+        },
         "load_texture_image", &AppData::load_texture_image,
+        // マテリアルグラフをコンパイルして name で登録する（texture ノードは load_texture_image 済みの名前を参照）
+        // @return 成功時 true、失敗時 false とエラーメッセージ
+        "compile_material", [](AppData& self, const std::string& name, sol::table nodes, int output,
+                               sol::this_state ts) -> std::tuple<bool, sol::object> {
+            std::string error;
+            auto program = MaterialProgram::compile(parse_material_nodes(nodes), output - 1,
+                [&self](const std::string& texture) { return self.get_texture_image(texture); }, error);
+            if (!program) {
+                return std::make_tuple(false, sol::make_object(ts, error));
+            }
+            self.set_material(name, std::move(program));
+            return std::make_tuple(true, sol::make_object(ts, sol::nil));
+        },
+        "get_material", [](AppData& self, const std::string& name, sol::this_state ts) -> sol::object {
+            auto program = self.get_material(name);
+            if (!program) {
+                return sol::make_object(ts, sol::nil);
+            }
+            return sol::make_object(ts, std::move(program));
+        },
         "get_texture_image", [&lua](AppData& self, const std::string& name) -> sol::object {
             auto image = self.get_texture_image(name);
             if (!image) {
@@ -102,8 +646,30 @@ void bind_common_types(sol::state& lua) {
             auto gltf = self.get_gltf(gltf_name);
             if (!gltf) return 0;
             return static_cast<int>(gltf->getMeshCount());
+        },
+        "get_gltf_primitive_count", [](AppData& self, const std::string& gltf_name, size_t mesh_idx) -> int {
+            auto gltf = self.get_gltf(gltf_name);
+            if (!gltf) return 0;
+            return static_cast<int>(gltf->getPrimitiveCount(mesh_idx));
+        },
+        // ノード階層・全プリミティブを1回の呼び出しで scene に追加する（共有メッシュは Embree インスタンス）
+        // 結果は app_data に記録され、ワーカーの start からは get_gltf_geometries で参照できる
+        // @return ジオメトリの配列（gltf_geometries_table）。読み込まれていなければ nil
+        "instantiate_gltf", [&lua](AppData& self, EmbreeScene& scene, const std::string& gltf_name) -> sol::object {
+            auto gltf = self.get_gltf(gltf_name);
+            if (!gltf) {
+                return sol::make_object(lua, sol::nil);
+            }
+            auto geometries = gltf->instantiate(scene);
+            self.set_gltf_geometries(gltf_name, geometries);
+            return sol::make_object(lua, gltf_geometries_table(lua, geometries));
+        },
+        "get_gltf_geometries", [&lua](AppData& self, const std::string& gltf_name) {
+            return gltf_geometries_table(lua, self.get_gltf_geometries(gltf_name));
         }
     );
+    bind_shared_store(lua, app_data_type);
+    bind_tile_scheduler(lua, app_data_type);
 
     // Bind GltfData (glTFファイル読み込み)
     lua.new_usertype<GltfData>("GltfData",
@@ -111,6 +677,10 @@ void bind_common_types(sol::state& lua) {
         "load", &GltfData::load,
         "is_loaded", &GltfData::isLoaded,
         "get_mesh_count", &GltfData::getMeshCount,
+        "get_primitive_count", &GltfData::getPrimitiveCount,
+        "instantiate", [&lua](const GltfData& self, EmbreeScene& scene) {
+            return gltf_geometries_table(lua, self.instantiate(scene));
+        },
         "get_vertices", &GltfData::getVertices,
         "get_indices", &GltfData::getIndices,
         "get_tex_coords", &GltfData::getTexCoords,
@@ -130,11 +700,17 @@ void bind_common_types(sol::state& lua) {
         },
         "release", &GltfData::release
     );
+
+    // 割り当てなしのベクトル演算（グローバル v3、lib/V3.lua から参照）
+    open_vec3_module(lua.lua_state());
 }
 
 void bind_worker_lua(sol::state& lua) {
     // Basic types
     bind_common_types(lua);
+
+    // require はプロセス共通のバイトコードキャッシュ経由（モジュールのコンパイルは全ステートで1回）
+    BytecodeCache::install_searcher(lua.lua_state());
     
     // Create 'app' namespace for worker (limited functions)
     auto app = lua.create_named_table("app");
@@ -143,10 +719,16 @@ void bind_worker_lua(sol::state& lua) {
     app.set_function("get_ticks", []() -> uint32_t {
         return SDL_GetTicks();
     });
+
+    // save_async の完了コールバックを呼び出す
+    app.set_function("poll_saves", &dispatch_save_callbacks);
 }
 
 void bind_lua(sol::state& lua, AppContext& ctx) {
     lua.open_libraries(sol::lib::base, sol::lib::package, sol::lib::math, sol::lib::string, sol::lib::table, sol::lib::coroutine, sol::lib::os, sol::lib::io);
+    // メインステートでコンパイルしたモジュールはワーカーがバイトコードのまま再利用する
+    BytecodeCache::install_searcher(lua.lua_state());
+    install_gc_counter(lua.lua_state(), &g_main_gc_stats);
     bind_imgui(lua);
 
     // Create 'app' namespace
@@ -271,15 +853,79 @@ void bind_lua(sol::state& lua, AppContext& ctx) {
     });
 
     // Update texture from AppData's back buffer (for in-progress rendering)
+    // 前回の呼び出し以降に書き込まれたタイルの矩形のみを転送する
     app.set_function("update_texture_from_back", [](void* texture, AppData& data) {
         if (!texture) return;
         SDL_Texture* tex = static_cast<SDL_Texture*>(texture);
-        SDL_UpdateTexture(tex, NULL, data.get_back_data(), data.get_width() * sizeof(uint32_t));
+        const uint32_t* back = static_cast<const uint32_t*>(data.get_back_data());
+        const int width = data.get_width();
+        const int pitch = width * sizeof(uint32_t);
+        data.consume_dirty_rects([&](int x, int y, int w, int h) {
+            SDL_Rect rect{x, y, w, h};
+            SDL_UpdateTexture(tex, &rect, back + y * width + x, pitch);
+        });
     });
 
     app.set_function("get_ticks", []() -> uint32_t {
         return SDL_GetTicks();
     });
+
+    // 高分解能の経過時間（ナノ秒、整数）: フレーム予算の締め切り判定用
+    app.set_function("get_ticks_ns", []() -> int64_t {
+        return static_cast<int64_t>(SDL_GetTicksNS());
+    });
+
+    // メインステートのGC設定（tile_step_kb はワーカーのみ有効）
+    app.set_function("set_gc_settings", [](sol::table cfg, sol::this_state ts) -> bool {
+        LuaGcSettings settings;
+        if (!parse_gc_settings(cfg, settings)) {
+            return false;
+        }
+        apply_gc_settings(ts.lua_state(), settings);
+        return true;
+    });
+    // メインステートのGCサイクル数（累積）
+    app.set_function("gc_stats", [](sol::this_state ts) { return gc_stats_table(ts, g_main_gc_stats); });
+
+    // メインステートのサンプリングプロファイラ（period 命令ごと、0 で停止。以降に作られたコルーチンも計測される）
+    app.set_function("set_profiling", [](int period, sol::this_state ts) {
+        if (period > 0) {
+            g_main_profiler.start(ts.lua_state(), period);
+        } else {
+            g_main_profiler.stop(ts.lua_state());
+        }
+    });
+    // メインステートで集計したスタックを取り出して空にする
+    app.set_function("take_profile", [](sol::this_state ts) { return profile_table(ts, g_main_profiler.take()); });
+
+    // モジュールのバイトコードキャッシュを破棄する（Reload Scene 用、変更されたファイルは更新時刻でも検出される）
+    app.set_function("invalidate_module_cache", []() {
+        BytecodeCache::instance().invalidate();
+    });
+
+    // save_async の完了コールバックを呼び出す（毎フレーム呼び出す想定）
+    app.set_function("poll_saves", &dispatch_save_callbacks);
+
+    // ホストのCPUトポロジ（自動スレッド数とワーカーのピン留め順の決定用）
+    // { logical, cores, numa_nodes, pin_order = {cpu, ...}, nodes = {node, ...} } を返す（nodes は pin_order と同じ並び）
+    app.set_function("cpu_topology", [](sol::this_state ts) {
+        sol::state_view state(ts);
+        CpuTopology topology = CpuTopology::detect();
+        std::vector<int> order = topology.pin_order();
+        sol::table pin_order = state.create_table(static_cast<int>(order.size()), 0);
+        sol::table nodes = state.create_table(static_cast<int>(order.size()), 0);
+        for (size_t i = 0; i < order.size(); ++i) {
+            pin_order[i + 1] = order[i];
+            nodes[i + 1] = topology.node_of(order[i]);
+        }
+        return state.create_table_with(
+            "logical", topology.logical_count(),
+            "cores", topology.physical_core_count(),
+            "numa_nodes", topology.numa_node_count(),
+            "pin_order", pin_order,
+            "nodes", nodes
+        );
+    });
     
     // Get Keyboard State for generalized input
     app.set_function("get_keyboard_state", [&lua]() -> sol::table {
@@ -375,10 +1021,41 @@ void bind_lua(sol::state& lua, AppContext& ctx) {
         },
         "start", &ThreadWorker::start,
         "join", &ThreadWorker::join,
+        "cancel", &ThreadWorker::cancel,
         "terminate", &ThreadWorker::terminate,
+        "shutdown", &ThreadWorker::shutdown,
+        "reset_state", &ThreadWorker::reset_state,
+        "set_cpu_affinity", &ThreadWorker::set_cpu_affinity,
+        "cpu_affinity", &ThreadWorker::cpu_affinity,
         "is_done", &ThreadWorker::is_done,
         "is_cancel_requested", &ThreadWorker::is_cancel_requested,
-        "get_progress", &ThreadWorker::get_progress
+        "get_progress", &ThreadWorker::get_progress,
+        // GC設定（次に登録するジョブから反映）と直近のジョブのGC統計
+        "set_gc_settings", [](ThreadWorker& self, sol::table cfg) -> bool {
+            LuaGcSettings settings;
+            if (!parse_gc_settings(cfg, settings)) {
+                return false;
+            }
+            self.set_gc_settings(settings);
+            return true;
+        },
+        "gc_stats", [](const ThreadWorker& self, sol::this_state ts) { return gc_stats_table(ts, self.gc_stats()); },
+        // サンプリングプロファイラ（次に登録するジョブから反映）と集計したスタックの取り出し
+        "set_profiling", &ThreadWorker::set_profiling,
+        "take_profile", [](ThreadWorker& self, sol::this_state ts) { return profile_table(ts, self.take_profile()); },
+        // Lua Stateのメモリ割り当て統計（回数と使用中・最大・アリーナのバイト数）
+        "memory_stats", [](const ThreadWorker& self, sol::this_state ts) {
+            sol::state_view lua(ts);
+            auto stats = self.memory_stats();
+            return lua.create_table_with(
+                "allocations", stats.allocations,
+                "frees", stats.frees,
+                "pooled", stats.pooled,
+                "bytes_in_use", stats.bytes_in_use,
+                "peak_bytes", stats.peak_bytes,
+                "arena_bytes", stats.arena_bytes
+            );
+        }
     );
 }
 
@@ -3,6 +3,8 @@
 #include <string>
 #include <SDL3/SDL.h>
 
+class AppData;
+
 struct AppContext {
     int width = 800;
     int height = 600;
@@ -16,6 +18,16 @@ struct AppContext {
 
 // Bind common types (AppData, Embree, GltfData) to any Lua state.
 void bind_common_types(sol::state& lua);
+// Bind the typed shared store (SharedView and AppData store_*/load methods).
+void bind_shared_store(sol::state& lua, sol::usertype<AppData>& app_data_type);
+// Bind the work-stealing tile scheduler (TileScheduler and AppData setup_tiles/tile_queue),
+// including the dependent tile queues and render statistics.
+void bind_tile_scheduler(sol::state& lua, sol::usertype<AppData>& app_data_type);
+// Bind the named counters, barriers and latches (AppData counter_*/barrier_*/latch_* methods).
+// Exhausted or invalid slots raise a Lua error.
+void bind_sync_registry(sol::state& lua, sol::usertype<AppData>& app_data_type);
+// Bind per-worker render statistics (RenderStats and AppData setup_render_stats/render_stats).
+void bind_render_stats(sol::state& lua, sol::usertype<AppData>& app_data_type);
 // Bind Lua functions.
 void bind_lua(sol::state& lua, AppContext& ctx);
 // Bind Lua functions for worker threads.
@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+extern "C" {
+#include <lua.h>
+#include <lauxlib.h>
+}
+
+// Lua State のGC設定（モードとペース配分）
+// 0 のパラメータは変更しない（Lua 5.4 の lua_gc と同じ規約）
+struct LuaGcSettings {
+    enum class Mode { Incremental, Generational };
+
+    Mode mode = Mode::Incremental;
+    // インクリメンタルモード: 次のサイクルまでの待ち(%)、ステップ倍率(%)、ステップサイズ(log2 バイト)
+    int pause = 0;
+    int step_multiplier = 0;
+    int step_size = 0;
+    // 世代別モード: マイナー/メジャーコレクションの倍率(%)
+    int minor_multiplier = 0;
+    int major_multiplier = 0;
+    // 0より大きい場合、ジョブ中は自動GCを止め、タイルの境界で少なくともこのKB分のGCステップを実行する
+    int tile_step_kb = 0;
+
+    static const char* mode_name(Mode mode) {
+        return mode == Mode::Generational ? "generational" : "incremental";
+    }
+    // @return 不明なモード名の場合 false
+    static bool parse_mode(const std::string& name, Mode& out) {
+        if (name == "incremental") {
+            out = Mode::Incremental;
+        } else if (name == "generational") {
+            out = Mode::Generational;
+        } else {
+            return false;
+        }
+        return true;
+    }
+};
+
+// GCの統計（1つのLua Stateにつき1つ。書き込みはそのStateのスレッドのみ、読み取りはどのスレッドからでも可）
+struct LuaGcStats {
+    std::atomic<uint64_t> collections{0}; // 完了したGCサイクル数（世代別モードではマイナー/メジャーコレクション数）
+    std::atomic<uint64_t> steps{0};       // タイル境界で実行したGCステップ数
+    std::atomic<uint64_t> step_ns{0};     // タイル境界のGCステップにかかった時間
+
+    void reset() {
+        collections.store(0, std::memory_order_relaxed);
+        steps.store(0, std::memory_order_relaxed);
+        step_ns.store(0, std::memory_order_relaxed);
+    }
+};
+
+namespace lua_gc {
+
+inline constexpr const char* kCounterMetatable = "lua_ray.gc_counter";
+
+// GCサイクルの完了を数える番兵を作る（参照を持たないため次のサイクルで回収され、ファイナライザで次の番兵を作り直す）
+inline void push_sentinel(lua_State* L, LuaGcStats* stats) {
+    auto** slot = static_cast<LuaGcStats**>(lua_newuserdatauv(L, sizeof(LuaGcStats*), 0));
+    *slot = stats;
+    luaL_setmetatable(L, kCounterMetatable);
+}
+
+inline int sentinel_gc(lua_State* L) {
+    LuaGcStats* stats = *static_cast<LuaGcStats**>(lua_touserdata(L, 1));
+    stats->collections.store(stats->collections.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    // lua_close 中に作った番兵はファイナライズされずに解放される
+    push_sentinel(L, stats);
+    lua_pop(L, 1);
+    return 0;
+}
+
+} // namespace lua_gc
+
+// GC設定を Lua State に適用する
+inline void apply_gc_settings(lua_State* L, const LuaGcSettings& settings) {
+    if (settings.mode == LuaGcSettings::Mode::Generational) {
+        lua_gc(L, LUA_GCGEN, settings.minor_multiplier, settings.major_multiplier);
+    } else {
+        lua_gc(L, LUA_GCINC, settings.pause, settings.step_multiplier, settings.step_size);
+    }
+}
+
+// stats で GC サイクルを数え始める（stats は Lua State より長く生存すること）
+inline void install_gc_counter(lua_State* L, LuaGcStats* stats) {
+    if (luaL_newmetatable(L, lua_gc::kCounterMetatable)) {
+        lua_pushcfunction(L, &lua_gc::sentinel_gc);
+        lua_setfield(L, -2, "__gc");
+    }
+    lua_pop(L, 1);
+    lua_gc::push_sentinel(L, stats);
+    lua_pop(L, 1);
+}
+
+// タイル境界のGCステップ（tile_step_kb と、前回のステップ以降に増えたヒープのうち大きい方を進める）
+// @param last_kb 前回のステップ後のヒープサイズ（KB、呼び出し側が保持する）
+inline void step_gc(lua_State* L, int min_kb, int& last_kb, LuaGcStats& stats) {
+    int heap_kb = lua_gc(L, LUA_GCCOUNT);
+    int kb = heap_kb - last_kb;
+    if (kb < min_kb) {
+        kb = min_kb;
+    }
+    auto start = std::chrono::steady_clock::now();
+    lua_gc(L, LUA_GCSTEP, kb);
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    last_kb = lua_gc(L, LUA_GCCOUNT);
+    stats.steps.store(stats.steps.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    stats.step_ns.store(stats.step_ns.load(std::memory_order_relaxed) + static_cast<uint64_t>(elapsed), std::memory_order_relaxed);
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+extern "C" {
+#include <lua.h>
+}
+
+// Lua State のサンプリングプロファイラ
+// 命令数フック（lua_sethook の LUA_MASKCOUNT）で period 命令ごとにスタックを記録し、
+// 折りたたみスタック（"root;caller;callee" 形式、フレームグラフ用）ごとにサンプル数と経過時間を集計する
+// 各サンプルには前回のサンプルからの経過時間を加算するため、C関数（intersect など）の時間は呼び出し元の Lua 関数に計上される
+// フックはメインスレッドに設定し、計測中に作られたコルーチンはフックを引き継ぐ（既存のコルーチンは計測されない）
+class LuaProfiler {
+public:
+    struct Entry {
+        uint64_t samples = 0;
+        uint64_t ns = 0;
+    };
+    using Stacks = std::unordered_map<std::string, Entry>;
+
+    static constexpr int DEFAULT_PERIOD = 10000; // サンプリング間隔（VM命令数）
+    static constexpr int MAX_DEPTH = 64;         // 記録するスタックの深さ（超えた分は葉側を残す）
+
+    // L のメインスレッドにフックを設定して計測を始める（L につき1つのプロファイラ）
+    void start(lua_State* L, int period = DEFAULT_PERIOD) {
+        L = main_thread(L);
+        lua_pushlightuserdata(L, this);
+        lua_rawsetp(L, LUA_REGISTRYINDEX, &registry_key());
+        m_last = std::chrono::steady_clock::now();
+        lua_sethook(L, &LuaProfiler::hook, LUA_MASKCOUNT, period > 0 ? period : DEFAULT_PERIOD);
+    }
+
+    // フックを外す（集計済みのサンプルは take() まで保持する）
+    void stop(lua_State* L) {
+        L = main_thread(L);
+        lua_sethook(L, nullptr, 0, 0);
+        lua_pushnil(L);
+        lua_rawsetp(L, LUA_REGISTRYINDEX, &registry_key());
+    }
+
+    // 集計したスタックを取り出して空にする（どのスレッドからでも呼べる）
+    Stacks take() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Stacks result;
+        result.swap(m_stacks);
+        return result;
+    }
+
+private:
+    static char& registry_key() {
+        static char key;
+        return key;
+    }
+
+    static lua_State* main_thread(lua_State* L) {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+        lua_State* main = lua_tothread(L, -1);
+        lua_pop(L, 1);
+        return main;
+    }
+
+    static void hook(lua_State* L, lua_Debug*) {
+        lua_rawgetp(L, LUA_REGISTRYINDEX, &registry_key());
+        auto* profiler = static_cast<LuaProfiler*>(lua_touserdata(L, -1));
+        lua_pop(L, 1);
+        if (profiler) {
+            profiler->record(L);
+        }
+    }
+
+    // "name@source:line" 形式のフレーム名（フレームグラフの区切り文字 ';' は置き換える）
+    static void append_frame(std::string& out, lua_Debug& ar) {
+        size_t begin = out.size();
+        if (std::strcmp(ar.what, "C") == 0) {
+            out += ar.name ? ar.name : "[C]";
+        } else if (std::strcmp(ar.what, "main") == 0) {
+            out += "(main)@";
+            out += ar.short_src;
+        } else {
+            out += ar.name ? ar.name : "?";
+            out += '@';
+            out += ar.short_src;
+            out += ':';
+            out += std::to_string(ar.linedefined);
+        }
+        for (size_t i = begin; i < out.size(); ++i) {
+            if (out[i] == ';') {
+                out[i] = ':';
+            }
+        }
+    }
+
+    void record(lua_State* L) {
+        auto now = std::chrono::steady_clock::now();
+        uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_last).count());
+        m_last = now;
+
+        // レベル0が実行中の関数。根から順に連結するため先に集める
+        lua_Debug frames[MAX_DEPTH];
+        int depth = 0;
+        while (depth < MAX_DEPTH && lua_getstack(L, depth, &frames[depth])) {
+            lua_getinfo(L, "Sn", &frames[depth]);
+            ++depth;
+        }
+        m_key.clear();
+        for (int i = depth - 1; i >= 0; --i) {
+            append_frame(m_key, frames[i]);
+            if (i > 0) {
+                m_key += ';';
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_stacks.find(m_key);
+        if (it == m_stacks.end()) {
+            it = m_stacks.emplace(m_key, Entry{}).first;
+        }
+        it->second.samples += 1;
+        it->second.ns += ns;
+    }
+
+    std::mutex m_mutex;
+    Stacks m_stacks;
+    // フックを実行するスレッド専用（スタックのキーは使い回して、既存のスタックでは割り当てない）
+    std::string m_key;
+    std::chrono::steady_clock::time_point m_last;
+};
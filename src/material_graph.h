@@ -0,0 +1,255 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "gltf_loader.h"
+
+// ネイティブのマテリアルグラフ
+// Lua（setup）で記述したノードの列を一度だけ命令列にコンパイルし、ワーカーはヒットごとに C++ で評価する
+// ノードは自分より前のノードだけを入力に取るため、ノード番号がそのままレジスタ番号になる（並べ替え不要）
+// 各レジスタは RGB の3成分で、スカラー（mix の t、ggx の roughness）は R 成分を使う
+// 照明は強さ1の平行光源1つで、lambert / ggx は「BRDF × π × n·l」（白い Lambert 面の正面で1になる単位）を返す
+
+// 1ヒット分のシェーディング入力（ベクトルは正規化済み、view はヒット点からカメラへの向き）
+struct ShadingInput {
+    float nx, ny, nz;
+    float vx, vy, vz;
+    float lx, ly, lz;
+    float u, v;
+};
+
+class MaterialProgram {
+public:
+    enum class Op { Constant, Texture, Add, Mul, Mix, Fresnel, Lambert, Ggx };
+
+    static constexpr int MAX_NODES = 64;
+    // evaluate() がまとめて評価するヒット数（命令ごとにレーンをループするため自動ベクトル化される）
+    static constexpr int LANES = 8;
+
+    // Lua から渡されるノード（inputs は 0 始まりのノード番号）
+    struct Node {
+        std::string op;
+        std::vector<int> inputs;
+        float value[3] = {0.0f, 0.0f, 0.0f};
+        std::string texture;
+    };
+
+    using TextureLookup = std::function<std::shared_ptr<TextureImage>(const std::string&)>;
+
+    // ノード列を命令列にコンパイルする
+    // @param output 出力ノード番号（0 始まり）
+    // @param error 失敗時の理由
+    // @return 失敗した場合 nullptr
+    static std::shared_ptr<MaterialProgram> compile(const std::vector<Node>& nodes, int output,
+                                                    const TextureLookup& lookup, std::string& error) {
+        if (nodes.empty() || static_cast<int>(nodes.size()) > MAX_NODES) {
+            error = "material graph must have 1.." + std::to_string(MAX_NODES) + " nodes";
+            return nullptr;
+        }
+        if (output < 0 || output >= static_cast<int>(nodes.size())) {
+            error = "output node " + std::to_string(output + 1) + " does not exist";
+            return nullptr;
+        }
+        auto program = std::make_shared<MaterialProgram>();
+        program->m_output = output;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            const Node& node = nodes[i];
+            Instruction instr;
+            int arity = 0;
+            if (!parse_op(node.op, instr.op, arity)) {
+                error = "node " + std::to_string(i + 1) + ": unknown op '" + node.op + "'";
+                return nullptr;
+            }
+            if (static_cast<int>(node.inputs.size()) != arity) {
+                error = "node " + std::to_string(i + 1) + ": '" + node.op + "' takes " + std::to_string(arity) + " input(s)";
+                return nullptr;
+            }
+            for (int k = 0; k < arity; ++k) {
+                int input = node.inputs[k];
+                if (input < 0 || input >= static_cast<int>(i)) {
+                    error = "node " + std::to_string(i + 1) + ": input " + std::to_string(input + 1) + " must be an earlier node";
+                    return nullptr;
+                }
+                instr.in[k] = static_cast<uint8_t>(input);
+            }
+            std::copy(node.value, node.value + 3, instr.value);
+            if (instr.op == Op::Texture) {
+                auto image = lookup ? lookup(node.texture) : nullptr;
+                if (!image || image->width <= 0 || image->height <= 0 || image->channels < 3 ||
+                    image->pixels.size() < static_cast<size_t>(image->width) * image->height * image->channels) {
+                    error = "node " + std::to_string(i + 1) + ": texture '" + node.texture + "' is not loaded";
+                    return nullptr;
+                }
+                instr.texture = static_cast<uint8_t>(program->m_textures.size());
+                program->m_textures.push_back(std::move(image));
+            }
+            program->m_code.push_back(instr);
+        }
+        return program;
+    }
+
+    // count 個のヒットを評価し、out に RGB を書き込む（LANES 個ずつまとめて評価する）
+    void evaluate(const ShadingInput* inputs, int count, float* out) const {
+        for (int base = 0; base < count; base += LANES) {
+            evaluate_lanes(inputs + base, std::min(LANES, count - base), out + base * 3);
+        }
+    }
+
+    // 1ヒットを評価する
+    void evaluate(const ShadingInput& input, float& r, float& g, float& b) const {
+        float out[3];
+        evaluate_lanes(&input, 1, out);
+        r = out[0];
+        g = out[1];
+        b = out[2];
+    }
+
+    size_t instruction_count() const { return m_code.size(); }
+
+private:
+    struct Instruction {
+        Op op = Op::Constant;
+        uint8_t in[3] = {0, 0, 0};
+        uint8_t texture = 0;
+        float value[3] = {0.0f, 0.0f, 0.0f};
+    };
+
+    // レジスタ（ノード番号 × RGB × レーン、SoA）
+    struct Registers {
+        float v[MAX_NODES][3][LANES];
+    };
+
+    static bool parse_op(const std::string& name, Op& op, int& arity) {
+        struct Entry { const char* name; Op op; int arity; };
+        static const Entry table[] = {
+            {"constant", Op::Constant, 0}, {"texture", Op::Texture, 0},
+            {"add", Op::Add, 2}, {"mul", Op::Mul, 2}, {"mix", Op::Mix, 3},
+            {"fresnel", Op::Fresnel, 1}, {"lambert", Op::Lambert, 1}, {"ggx", Op::Ggx, 2},
+        };
+        for (const auto& entry : table) {
+            if (name == entry.name) {
+                op = entry.op;
+                arity = entry.arity;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static float dot3(float ax, float ay, float az, float bx, float by, float bz) {
+        return ax * bx + ay * by + az * bz;
+    }
+
+    // Schlick の近似
+    static float schlick(float f0, float cos_theta) {
+        float m = 1.0f - std::clamp(cos_theta, 0.0f, 1.0f);
+        float m2 = m * m;
+        return f0 + (1.0f - f0) * m2 * m2 * m;
+    }
+
+    // Texture.lua と同じ最近傍サンプリング（リピート）
+    static void sample(const TextureImage& image, float u, float v, float& r, float& g, float& b) {
+        u -= std::floor(u);
+        v -= std::floor(v);
+        int px = std::clamp(static_cast<int>(u * image.width), 0, image.width - 1);
+        int py = std::clamp(static_cast<int>(v * image.height), 0, image.height - 1);
+        const unsigned char* p = &image.pixels[(static_cast<size_t>(py) * image.width + px) * image.channels];
+        r = p[0] * (1.0f / 255.0f);
+        g = p[1] * (1.0f / 255.0f);
+        b = p[2] * (1.0f / 255.0f);
+    }
+
+    void evaluate_lanes(const ShadingInput* in, int n, float* out) const {
+        Registers regs;
+        for (size_t i = 0; i < m_code.size(); ++i) {
+            const Instruction& instr = m_code[i];
+            float (*dst)[LANES] = regs.v[i];
+            const float (*a)[LANES] = regs.v[instr.in[0]];
+            const float (*b)[LANES] = regs.v[instr.in[1]];
+            const float (*c)[LANES] = regs.v[instr.in[2]];
+            switch (instr.op) {
+            case Op::Constant:
+                for (int ch = 0; ch < 3; ++ch) {
+                    for (int l = 0; l < n; ++l) dst[ch][l] = instr.value[ch];
+                }
+                break;
+            case Op::Texture: {
+                const TextureImage& image = *m_textures[instr.texture];
+                for (int l = 0; l < n; ++l) {
+                    sample(image, in[l].u, in[l].v, dst[0][l], dst[1][l], dst[2][l]);
+                }
+                break;
+            }
+            case Op::Add:
+                for (int ch = 0; ch < 3; ++ch) {
+                    for (int l = 0; l < n; ++l) dst[ch][l] = a[ch][l] + b[ch][l];
+                }
+                break;
+            case Op::Mul:
+                for (int ch = 0; ch < 3; ++ch) {
+                    for (int l = 0; l < n; ++l) dst[ch][l] = a[ch][l] * b[ch][l];
+                }
+                break;
+            case Op::Mix:
+                for (int ch = 0; ch < 3; ++ch) {
+                    for (int l = 0; l < n; ++l) dst[ch][l] = a[ch][l] + (b[ch][l] - a[ch][l]) * c[0][l];
+                }
+                break;
+            case Op::Fresnel:
+                for (int l = 0; l < n; ++l) {
+                    float cos_v = dot3(in[l].nx, in[l].ny, in[l].nz, in[l].vx, in[l].vy, in[l].vz);
+                    for (int ch = 0; ch < 3; ++ch) dst[ch][l] = schlick(a[ch][l], cos_v);
+                }
+                break;
+            case Op::Lambert:
+                for (int l = 0; l < n; ++l) {
+                    float nl = std::max(0.0f, dot3(in[l].nx, in[l].ny, in[l].nz, in[l].lx, in[l].ly, in[l].lz));
+                    for (int ch = 0; ch < 3; ++ch) dst[ch][l] = a[ch][l] * nl;
+                }
+                break;
+            case Op::Ggx:
+                for (int l = 0; l < n; ++l) {
+                    const ShadingInput& s = in[l];
+                    float nl = dot3(s.nx, s.ny, s.nz, s.lx, s.ly, s.lz);
+                    float nv = dot3(s.nx, s.ny, s.nz, s.vx, s.vy, s.vz);
+                    if (nl <= 0.0f || nv <= 0.0f) {
+                        dst[0][l] = dst[1][l] = dst[2][l] = 0.0f;
+                        continue;
+                    }
+                    float hx = s.lx + s.vx, hy = s.ly + s.vy, hz = s.lz + s.vz;
+                    float inv_len = 1.0f / std::sqrt(std::max(dot3(hx, hy, hz, hx, hy, hz), 1e-12f));
+                    hx *= inv_len;
+                    hy *= inv_len;
+                    hz *= inv_len;
+                    float nh = std::max(0.0f, dot3(s.nx, s.ny, s.nz, hx, hy, hz));
+                    float vh = std::max(0.0f, dot3(s.vx, s.vy, s.vz, hx, hy, hz));
+                    // 法線分布 D（GGX、alpha = roughness^2）とマスキング G（Smith-Schlick、k = (roughness + 1)^2 / 8）
+                    float roughness = std::clamp(b[0][l], 0.02f, 1.0f);
+                    float alpha2 = roughness * roughness * roughness * roughness;
+                    float d_denom = nh * nh * (alpha2 - 1.0f) + 1.0f;
+                    float d = alpha2 / (3.14159265f * d_denom * d_denom);
+                    float k = (roughness + 1.0f) * (roughness + 1.0f) * 0.125f;
+                    float g = (nl / (nl * (1.0f - k) + k)) * (nv / (nv * (1.0f - k) + k));
+                    // π × D G F / (4 n·l n·v) × n·l
+                    float scale = 3.14159265f * d * g / (4.0f * nv);
+                    for (int ch = 0; ch < 3; ++ch) dst[ch][l] = schlick(a[ch][l], vh) * scale;
+                }
+                break;
+            }
+        }
+        const float (*result)[LANES] = regs.v[m_output];
+        for (int l = 0; l < n; ++l) {
+            out[l * 3 + 0] = result[0][l];
+            out[l * 3 + 1] = result[1][l];
+            out[l * 3 + 2] = result[2][l];
+        }
+    }
+
+    std::vector<Instruction> m_code;
+    std::vector<std::shared_ptr<TextureImage>> m_textures;
+    int m_output = 0;
+};
@@ -0,0 +1,69 @@
+#pragma once
+#include <cmath>
+extern "C" {
+#include <lua.h>
+}
+#include "app_data.h"
+#include "embree_wrapper.h"
+
+// ホットパス用の手書き lua_CFunction（set_pixel / get_pixel / intersect）
+// sol2 のメンバー関数ディスパッチ（usertype の検索・引数チェック・タプル変換）を通さず、
+// 対象オブジェクトの this はクロージャのアップバリュー（ライトユーザーデータ）から取り出す
+// 呼び出し方は元のメソッドと同じ fn(obj, ...) で、第1引数（self）は無視する
+// 対象オブジェクトより長く使わないこと（ワーカーの _app_data / _scene と同じ寿命の前提）
+namespace raw_bindings {
+
+// sol2 と同じ整数変換（整数はそのまま、浮動小数点は四捨五入）
+inline int to_int(lua_State* L, int index) {
+    int isnum = 0;
+    lua_Integer value = lua_tointegerx(L, index, &isnum);
+    if (isnum) {
+        return static_cast<int>(value);
+    }
+    return static_cast<int>(std::llround(lua_tonumber(L, index)));
+}
+
+template <typename T>
+inline T* self(lua_State* L) {
+    return static_cast<T*>(lua_touserdata(L, lua_upvalueindex(1)));
+}
+
+// set_pixel(self, x, y, r, g, b)
+inline int set_pixel(lua_State* L) {
+    self<AppData>(L)->set_pixel(to_int(L, 2), to_int(L, 3), to_int(L, 4), to_int(L, 5), to_int(L, 6));
+    return 0;
+}
+
+// get_pixel(self, x, y) -> r, g, b
+inline int get_pixel(lua_State* L) {
+    auto [r, g, b] = self<AppData>(L)->get_pixel(to_int(L, 2), to_int(L, 3));
+    lua_pushinteger(L, r);
+    lua_pushinteger(L, g);
+    lua_pushinteger(L, b);
+    return 3;
+}
+
+// intersect(self, ox, oy, oz, dx, dy, dz) -> hit, t, nx, ny, nz, geomID, primID, u, v
+inline int intersect(lua_State* L) {
+    auto [hit, t, nx, ny, nz, geom_id, prim_id, u, v] = self<EmbreeScene>(L)->intersect(
+        static_cast<float>(lua_tonumber(L, 2)), static_cast<float>(lua_tonumber(L, 3)), static_cast<float>(lua_tonumber(L, 4)),
+        static_cast<float>(lua_tonumber(L, 5)), static_cast<float>(lua_tonumber(L, 6)), static_cast<float>(lua_tonumber(L, 7)));
+    lua_pushboolean(L, hit);
+    lua_pushnumber(L, t);
+    lua_pushnumber(L, nx);
+    lua_pushnumber(L, ny);
+    lua_pushnumber(L, nz);
+    lua_pushinteger(L, geom_id);
+    lua_pushinteger(L, prim_id);
+    lua_pushnumber(L, u);
+    lua_pushnumber(L, v);
+    return 9;
+}
+
+// object を this としてアップバリューに持つクロージャをスタックに積む
+inline void push_method(lua_State* L, void* object, lua_CFunction fn) {
+    lua_pushlightuserdata(L, object);
+    lua_pushcclosure(L, fn, 1);
+}
+
+} // namespace raw_bindings
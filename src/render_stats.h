@@ -0,0 +1,131 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <chrono>
+
+// レンダリングの進捗とスループットの集計（ワーカーごと）
+// ワーカーはタイルを終えるたびに record_tile() で処理したピクセル数とレイ数を報告し、
+// メインスレッドは snapshot() で進捗・ETA・毎秒のサンプル数/レイ数を読み取る
+// ワーカーは書き込み用のスロットを持つため、報告はアトミックな加算のみで済む
+class RenderStats {
+public:
+    struct Counters {
+        uint64_t tiles = 0;
+        uint64_t pixels = 0;
+        uint64_t samples = 0;
+        uint64_t rays = 0;
+    };
+
+    // @param num_workers ワーカー数（スロット数、worker_index はこの剰余を使用）
+    // @param total_pixels レンダリング全体で処理するピクセル数（ETAの算出用）
+    // @param samples_per_pixel 1ピクセルあたりのサンプル数
+    RenderStats(int num_workers, uint64_t total_pixels, int samples_per_pixel)
+        : m_slots(new Slot[num_workers < 1 ? 1 : num_workers]),
+          m_num_workers(num_workers < 1 ? 1 : num_workers),
+          m_total_pixels(total_pixels),
+          m_samples_per_pixel(samples_per_pixel < 1 ? 1 : samples_per_pixel),
+          m_start(std::chrono::steady_clock::now()) {}
+
+    // タイルの完了を報告する
+    void record_tile(int worker_index, uint64_t pixels, uint64_t rays) {
+        Slot& slot = m_slots[(worker_index < 0 ? 0 : worker_index) % m_num_workers];
+        slot.tiles.fetch_add(1, std::memory_order_relaxed);
+        slot.pixels.fetch_add(pixels, std::memory_order_relaxed);
+        slot.rays.fetch_add(rays, std::memory_order_relaxed);
+    }
+
+    // ワーカーのジョブ開始時に呼び、そのスレッドの累積レイ数を基準として記録する
+    // （スレッドの累積カウンタは前回のレンダーや別のジョブの分も含むため）
+    void begin(int worker_index, uint64_t ray_count) {
+        Slot& slot = m_slots[(worker_index < 0 ? 0 : worker_index) % m_num_workers];
+        slot.ray_mark.store(ray_count, std::memory_order_relaxed);
+    }
+
+    // タイルの完了を、呼び出し元スレッドの累積レイ数で報告する（begin() または前回の報告からの差分を加算）
+    void record_tile_at(int worker_index, uint64_t pixels, uint64_t ray_count) {
+        Slot& slot = m_slots[(worker_index < 0 ? 0 : worker_index) % m_num_workers];
+        uint64_t mark = slot.ray_mark.exchange(ray_count, std::memory_order_relaxed);
+        record_tile(worker_index, pixels, ray_count - mark);
+    }
+
+    // 全ワーカーの完了時に呼び、経過時間を固定する
+    void finish() {
+        int64_t expected = 0;
+        m_finished_ns.compare_exchange_strong(expected, elapsed_ns(), std::memory_order_acq_rel);
+    }
+    bool finished() const { return m_finished_ns.load(std::memory_order_acquire) != 0; }
+
+    Counters worker(int worker_index) const {
+        const Slot& slot = m_slots[(worker_index < 0 ? 0 : worker_index) % m_num_workers];
+        Counters counters;
+        counters.tiles = slot.tiles.load(std::memory_order_relaxed);
+        counters.pixels = slot.pixels.load(std::memory_order_relaxed);
+        counters.samples = counters.pixels * m_samples_per_pixel;
+        counters.rays = slot.rays.load(std::memory_order_relaxed);
+        return counters;
+    }
+
+    Counters total() const {
+        Counters sum;
+        for (int i = 0; i < m_num_workers; ++i) {
+            Counters counters = worker(i);
+            sum.tiles += counters.tiles;
+            sum.pixels += counters.pixels;
+            sum.samples += counters.samples;
+            sum.rays += counters.rays;
+        }
+        return sum;
+    }
+
+    // 開始からの経過秒数（finish() 後は完了までの時間）
+    double elapsed_seconds() const {
+        int64_t finished = m_finished_ns.load(std::memory_order_acquire);
+        return static_cast<double>(finished != 0 ? finished : elapsed_ns()) * 1e-9;
+    }
+
+    // 進捗（0.0〜1.0）
+    double progress() const {
+        if (m_total_pixels == 0) return 1.0;
+        double ratio = static_cast<double>(total().pixels) / static_cast<double>(m_total_pixels);
+        return ratio < 1.0 ? ratio : 1.0;
+    }
+
+    // 残り時間の推定（秒）。これまでの平均スループットから求め、まだ推定できない場合は負の値
+    double eta_seconds() const {
+        if (finished()) return 0.0;
+        uint64_t done = total().pixels;
+        if (done == 0) return -1.0;
+        if (done >= m_total_pixels) return 0.0;
+        return elapsed_seconds() * static_cast<double>(m_total_pixels - done) / static_cast<double>(done);
+    }
+
+    int num_workers() const { return m_num_workers; }
+    uint64_t total_pixels() const { return m_total_pixels; }
+    int samples_per_pixel() const { return m_samples_per_pixel; }
+
+private:
+    // 偽共有を避けるためキャッシュライン単位で配置
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> tiles{0};
+        std::atomic<uint64_t> pixels{0};
+        std::atomic<uint64_t> rays{0};
+        // 担当ワーカーのスレッドの累積レイ数（前回の報告時点）
+        std::atomic<uint64_t> ray_mark{0};
+    };
+
+    int64_t elapsed_ns() const {
+        auto elapsed = std::chrono::steady_clock::now() - m_start;
+        // finish() の「未完了」表現と区別するため最低1ns
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        return ns > 0 ? ns : 1;
+    }
+
+    std::unique_ptr<Slot[]> m_slots;
+    int m_num_workers;
+    uint64_t m_total_pixels;
+    int m_samples_per_pixel;
+    std::chrono::steady_clock::time_point m_start;
+    std::atomic<int64_t> m_finished_ns{0};
+};
@@ -0,0 +1,187 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 共有ストアに格納される不変の値（数値・float配列・int配列・バイナリ）
+struct SharedValue {
+    enum class Type { Number, FloatArray, IntArray, Blob };
+
+    Type type = Type::Number;
+    double number = 0.0;
+    std::vector<float> floats;
+    std::vector<int32_t> ints;
+    std::string blob;
+
+    // 要素数（数値は1、バイナリはバイト数）
+    size_t size() const {
+        switch (type) {
+            case Type::FloatArray: return floats.size();
+            case Type::IntArray: return ints.size();
+            case Type::Blob: return blob.size();
+            default: return 1;
+        }
+    }
+};
+
+using SharedSnapshot = std::shared_ptr<const SharedValue>;
+
+// スレッド間で共有する型付きストア
+// 値は書き込みのたびに新しい不変スナップショットとして公開され、読み手は参照カウントを
+// 増やすだけでコピーもデコードもせずに参照できる（古いスナップショットは最後の読み手が解放）
+// 各スロットはスナップショットを指すアトミックな生ポインタで、スロット番号での読み取りは
+// ロックを取らない（ポインタを読んで shared_ptr をコピーするだけ）
+// 置き換えられた古いポインタはエポックベースで回収する: 読み手は現在のエポックの偶奇ごとの
+// カウンタを増減し、書き手はエポックを2回進めてそれぞれ前の偶奇の読み手がいなくなるまで待ってから解放する
+// 名前からスロット番号への解決と書き手同士の直列化だけをミューテックスで保護する
+class SharedStore {
+public:
+    static constexpr int MAX_SLOTS = 256;
+    // 読み手のカウンタの分散数（スレッドごとに1つ割り当て、超えた分は共有する）
+    static constexpr int READER_SLOTS = 64;
+
+    SharedStore() = default;
+    SharedStore(const SharedStore&) = delete;
+    SharedStore& operator=(const SharedStore&) = delete;
+    ~SharedStore() {
+        for (auto& slot : m_slots) {
+            delete slot.load(std::memory_order_relaxed);
+        }
+    }
+
+    // 名前に対応するスロット番号を取得（未登録なら空のスロットを割り当てる）
+    // @return スロット番号。スロットが枯渇している場合は -1
+    int slot(const std::string& name) {
+        std::lock_guard<std::mutex> lock(m_name_mutex);
+        auto it = m_names.find(name);
+        if (it != m_names.end()) {
+            return it->second;
+        }
+        int slot = static_cast<int>(m_names.size());
+        if (slot >= MAX_SLOTS) {
+            return -1;
+        }
+        m_names.emplace(name, slot);
+        return slot;
+    }
+
+    // 新しいスナップショットを公開する（置き換えた古い値は読み取り中の読み手がいなくなってから解放する）
+    void publish(int slot, SharedSnapshot value) {
+        if (slot < 0 || slot >= MAX_SLOTS) return;
+        const SharedSnapshot* next = value ? new SharedSnapshot(std::move(value)) : nullptr;
+        std::lock_guard<std::mutex> lock(m_publish_mutex);
+        const SharedSnapshot* old = m_slots[slot].exchange(next, std::memory_order_seq_cst);
+        if (old) {
+            wait_for_readers();
+            delete old;
+        }
+    }
+
+    // ロックフリー: ワーカーは slot() で一度だけ解決したスロット番号で読み取る
+    // @return 未設定の場合は nullptr
+    SharedSnapshot snapshot(int slot) const {
+        if (slot < 0 || slot >= MAX_SLOTS) return nullptr;
+        ReadScope scope(*this);
+        const SharedSnapshot* current = m_slots[slot].load(std::memory_order_seq_cst);
+        return current ? *current : nullptr;
+    }
+
+    void set_number(const std::string& name, double value) {
+        auto v = std::make_shared<SharedValue>();
+        v->type = SharedValue::Type::Number;
+        v->number = value;
+        publish(slot(name), std::move(v));
+    }
+
+    void set_floats(const std::string& name, std::vector<float> values) {
+        auto v = std::make_shared<SharedValue>();
+        v->type = SharedValue::Type::FloatArray;
+        v->floats = std::move(values);
+        publish(slot(name), std::move(v));
+    }
+
+    void set_ints(const std::string& name, std::vector<int32_t> values) {
+        auto v = std::make_shared<SharedValue>();
+        v->type = SharedValue::Type::IntArray;
+        v->ints = std::move(values);
+        publish(slot(name), std::move(v));
+    }
+
+    void set_blob(const std::string& name, std::string bytes) {
+        auto v = std::make_shared<SharedValue>();
+        v->type = SharedValue::Type::Blob;
+        v->blob = std::move(bytes);
+        publish(slot(name), std::move(v));
+    }
+
+    // 値を削除（以降の読み取りは nullptr、既に取得済みのスナップショットは有効なまま）
+    void remove(const std::string& name) {
+        publish(slot(name), nullptr);
+    }
+
+    // 名前の解決にミューテックスを取るため、繰り返し読む場合は slot() と snapshot() を使う
+    // @return 未登録・未設定の場合は nullptr
+    SharedSnapshot get(const std::string& name) {
+        int found = -1;
+        {
+            std::lock_guard<std::mutex> lock(m_name_mutex);
+            auto it = m_names.find(name);
+            if (it != m_names.end()) {
+                found = it->second;
+            }
+        }
+        return snapshot(found);
+    }
+
+private:
+    // 読み取り中であることを、読み始めたエポックの偶奇のカウンタで示す
+    class ReadScope {
+    public:
+        explicit ReadScope(const SharedStore& store) {
+            uint64_t epoch = store.m_epoch.load(std::memory_order_seq_cst);
+            m_count = &store.m_readers[reader_slot()].count[epoch & 1];
+            m_count->fetch_add(1, std::memory_order_seq_cst);
+        }
+        ~ReadScope() { m_count->fetch_sub(1, std::memory_order_release); }
+        ReadScope(const ReadScope&) = delete;
+        ReadScope& operator=(const ReadScope&) = delete;
+
+    private:
+        std::atomic<int>* m_count;
+    };
+
+    struct alignas(64) ReaderCount {
+        std::atomic<int> count[2] = {};
+    };
+
+    static int reader_slot() {
+        static std::atomic<int> next{0};
+        thread_local int slot = next.fetch_add(1, std::memory_order_relaxed) % READER_SLOTS;
+        return slot;
+    }
+
+    // 古いポインタを読んだ可能性のある読み手は、交換前のエポックかその前のエポックの偶奇で数えられている
+    // エポックを2回進め、そのたびに進める前の偶奇の読み手が抜けるのを待つ（新しい読み手は反対側で数えるため待ち続けない）
+    void wait_for_readers() {
+        for (int phase = 0; phase < 2; ++phase) {
+            uint64_t epoch = m_epoch.fetch_add(1, std::memory_order_seq_cst);
+            for (auto& reader : m_readers) {
+                while (reader.count[epoch & 1].load(std::memory_order_seq_cst) != 0) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    std::atomic<const SharedSnapshot*> m_slots[MAX_SLOTS] = {};
+    std::atomic<uint64_t> m_epoch{0};
+    mutable ReaderCount m_readers[READER_SLOTS];
+    std::unordered_map<std::string, int> m_names;
+    std::mutex m_name_mutex;
+    std::mutex m_publish_mutex;
+};
@@ -0,0 +1,206 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+// ワーカー間で共有する名前付き同期プリミティブ（カウンタ・バリア・ラッチ）
+// 名前からスロット番号への解決だけをミューテックスで保護し、
+// スロット番号を使った以降の操作はアトミック命令のみで行う（ロックフリー・アロケーションフリー）
+// 待機（barrier_wait / latch_wait）だけは条件変数でスリープし、バリアの解放・ラッチの到達時にのみロックを取って起こす
+class SyncRegistry {
+public:
+    static constexpr int MAX_COUNTERS = 256;
+    static constexpr int MAX_BARRIERS = 32;
+    static constexpr int MAX_LATCHES = 32;
+
+    // ================================================================
+    // カウンタ
+    // ================================================================
+
+    // 名前に対応するカウンタのスロット番号を取得（未登録なら値0で作成）
+    // @return スロット番号。スロットが枯渇している場合は -1
+    int counter_slot(const std::string& name) {
+        return find_or_create(m_counter_names, name, MAX_COUNTERS, [](int) {});
+    }
+
+    int64_t counter_load(int slot) const {
+        if (!valid(slot, MAX_COUNTERS)) return 0;
+        return m_counters[slot].value.load(std::memory_order_acquire);
+    }
+
+    void counter_store(int slot, int64_t value) {
+        if (!valid(slot, MAX_COUNTERS)) return;
+        m_counters[slot].value.store(value, std::memory_order_release);
+    }
+
+    // 加算して加算前の値を返す
+    int64_t counter_fetch_add(int slot, int64_t delta) {
+        if (!valid(slot, MAX_COUNTERS)) return 0;
+        return m_counters[slot].value.fetch_add(delta, std::memory_order_acq_rel);
+    }
+
+    // 値が expected と等しければ desired に置き換える
+    // @return (成功したか, 操作前の値)
+    std::tuple<bool, int64_t> counter_compare_exchange(int slot, int64_t expected, int64_t desired) {
+        if (!valid(slot, MAX_COUNTERS)) return std::make_tuple(false, int64_t(0));
+        bool ok = m_counters[slot].value.compare_exchange_strong(expected, desired, std::memory_order_acq_rel);
+        return std::make_tuple(ok, expected);
+    }
+
+    // ================================================================
+    // バリア（再利用可能、フェーズ番号で世代を区別）
+    // ================================================================
+
+    // 名前に対応するバリアのスロット番号を取得（参加数は作成時のみ反映）
+    int barrier_slot(const std::string& name, int participants) {
+        return find_or_create(m_barrier_names, name, MAX_BARRIERS, [&](int slot) {
+            barrier_reset(slot, participants);
+        });
+    }
+
+    // 参加数を設定し直して待機状態を初期化する（待機中のスレッドが無いときに呼ぶこと）
+    void barrier_reset(int slot, int participants) {
+        if (!valid(slot, MAX_BARRIERS)) return;
+        Barrier& b = m_barriers[slot];
+        b.participants.store(participants, std::memory_order_relaxed);
+        b.remaining.store(participants, std::memory_order_relaxed);
+        b.phase.fetch_add(1, std::memory_order_release);
+    }
+
+    // バリアに到着し、待機用のフェーズ番号を返す
+    // 最後に到着したスレッドがフェーズを進めて全員を解放する
+    int64_t barrier_arrive(int slot) {
+        if (!valid(slot, MAX_BARRIERS)) return 0;
+        Barrier& b = m_barriers[slot];
+        int64_t phase = b.phase.load(std::memory_order_acquire);
+        if (b.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            b.remaining.store(b.participants.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            b.phase.fetch_add(1, std::memory_order_release);
+            notify_waiters();
+        }
+        return phase;
+    }
+
+    // barrier_arrive が返したフェーズが完了するまで待機する
+    // @param timeout_ms 負なら無期限、0ならポーリングのみ
+    // @return true: 解放された, false: タイムアウトまたは interrupt_waiters（キャンセル確認後に再度呼び出す）
+    bool barrier_wait(int slot, int64_t phase, int timeout_ms) const {
+        if (!valid(slot, MAX_BARRIERS)) return true;
+        const Barrier& b = m_barriers[slot];
+        return wait_until([&] { return b.phase.load(std::memory_order_acquire) != phase; }, timeout_ms);
+    }
+
+    // ================================================================
+    // ラッチ（カウントが0になるまで待機、reset で再利用）
+    // ================================================================
+
+    // 名前に対応するラッチのスロット番号を取得（カウントは作成時のみ反映）
+    int latch_slot(const std::string& name, int64_t count) {
+        return find_or_create(m_latch_names, name, MAX_LATCHES, [&](int slot) {
+            latch_reset(slot, count);
+        });
+    }
+
+    void latch_reset(int slot, int64_t count) {
+        if (!valid(slot, MAX_LATCHES)) return;
+        m_latches[slot].value.store(count, std::memory_order_release);
+        if (count <= 0) notify_waiters();
+    }
+
+    // カウントが0に到達したときだけ待機中のスレッドを起こす
+    void latch_count_down(int slot, int64_t n) {
+        if (!valid(slot, MAX_LATCHES)) return;
+        int64_t previous = m_latches[slot].value.fetch_sub(n, std::memory_order_acq_rel);
+        if (previous > 0 && previous - n <= 0) notify_waiters();
+    }
+
+    bool latch_try_wait(int slot) const {
+        if (!valid(slot, MAX_LATCHES)) return true;
+        return m_latches[slot].value.load(std::memory_order_acquire) <= 0;
+    }
+
+    // @param timeout_ms 負なら無期限、0ならポーリングのみ
+    // @return true: カウントが0に到達, false: タイムアウトまたは interrupt_waiters
+    bool latch_wait(int slot, int timeout_ms) const {
+        return wait_until([&] { return latch_try_wait(slot); }, timeout_ms);
+    }
+
+    // 待機中のスレッドを全て起こし、待機を false で終わらせる（キューの打ち切り・レンダー世代の更新時）
+    // 起こされたスレッドはキャンセルや打ち切りを確認してから、必要なら待機し直す
+    void interrupt_waiters() {
+        m_interrupts.fetch_add(1, std::memory_order_acq_rel);
+        notify_waiters();
+    }
+
+private:
+    // 偽共有を避けるためスロットごとにキャッシュラインを分ける
+    struct alignas(64) Counter {
+        std::atomic<int64_t> value{0};
+    };
+
+    struct alignas(64) Barrier {
+        std::atomic<int> participants{0};
+        std::atomic<int> remaining{0};
+        std::atomic<int64_t> phase{0};
+    };
+
+    static bool valid(int slot, int max) {
+        return slot >= 0 && slot < max;
+    }
+
+    template <typename OnCreate>
+    int find_or_create(std::unordered_map<std::string, int>& names, const std::string& name, int max, OnCreate&& on_create) {
+        std::lock_guard<std::mutex> lock(m_name_mutex);
+        auto it = names.find(name);
+        if (it != names.end()) {
+            return it->second;
+        }
+        int slot = static_cast<int>(names.size());
+        if (slot >= max) {
+            return -1;
+        }
+        on_create(slot);
+        names.emplace(name, slot);
+        return slot;
+    }
+
+    // 状態の更新後にロックを取ってから起こす（待機側の条件確認との間で通知を取りこぼさない）
+    void notify_waiters() {
+        { std::lock_guard<std::mutex> lock(m_wait_mutex); }
+        m_wait_cv.notify_all();
+    }
+
+    template <typename Pred>
+    bool wait_until(Pred&& pred, int timeout_ms) const {
+        if (pred()) return true;
+        if (timeout_ms == 0) return false;
+        uint64_t interrupts = m_interrupts.load(std::memory_order_acquire);
+        auto done = [&] { return pred() || m_interrupts.load(std::memory_order_acquire) != interrupts; };
+        std::unique_lock<std::mutex> lock(m_wait_mutex);
+        if (timeout_ms < 0) {
+            m_wait_cv.wait(lock, done);
+        } else {
+            m_wait_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), done);
+        }
+        return pred();
+    }
+
+    Counter m_counters[MAX_COUNTERS];
+    Barrier m_barriers[MAX_BARRIERS];
+    Counter m_latches[MAX_LATCHES];
+
+    std::unordered_map<std::string, int> m_counter_names;
+    std::unordered_map<std::string, int> m_barrier_names;
+    std::unordered_map<std::string, int> m_latch_names;
+    std::mutex m_name_mutex;
+
+    // 待機用（解放・到達・interrupt_waiters の通知にのみ使う）
+    mutable std::mutex m_wait_mutex;
+    mutable std::condition_variable m_wait_cv;
+    std::atomic<uint64_t> m_interrupts{0};
+};
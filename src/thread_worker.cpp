@@ -1,5 +1,7 @@
 #include "thread_worker.h"
 #include "lua_binding.h"
+#include "cpu_topology.h"
+#include "bytecode_cache.h"
 #include <iostream>
 
 // Defined in lua_binding.cpp, but we need to declare it here or in lua_binding.h
@@ -10,32 +12,79 @@ ThreadWorker::ThreadWorker(AppData* data, EmbreeScene* scene, Bounds bounds, int
     : m_data(data), m_scene(scene), m_bounds(bounds), m_thread_id(thread_id) {}
 
 ThreadWorker::~ThreadWorker() {
-    if (m_thread.joinable()) {
-        m_thread.join();
-    }
+    shutdown();
 }
 
 void ThreadWorker::start(const std::string& script_path, const std::string& scene_type) {
-    if (m_thread.joinable()) {
-        m_thread.join(); // Ensure previous run is finished
-    }
+    // キャンセル済みのジョブが実行中でも待たない（世代が古いジョブはタイル単位で自ら終了する）
+    std::lock_guard<std::mutex> lock(m_mutex);
     m_done = false;
-    m_cancel_requested = false;
     m_progress = 0.0f;
-    m_thread = std::thread(&ThreadWorker::thread_func, this, script_path, scene_type);
+    m_jobs.push_back(Job{script_path, scene_type, m_data->render_generation(), m_gc_settings, m_profile_period});
+    if (!m_thread.joinable()) {
+        m_stop = false;
+        m_thread = std::thread(&ThreadWorker::thread_func, this);
+    }
+    m_job_cv.notify_one();
 }
 
 void ThreadWorker::join() {
-    if (m_thread.joinable()) {
-        m_thread.join();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done_cv.wait(lock, [this] { return m_jobs.empty() && !m_running; });
+}
+
+void ThreadWorker::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.clear();
+        m_cancel_requested = true;
+        m_done = !m_running;
     }
+    m_done_cv.notify_all();
 }
 
 void ThreadWorker::terminate() {
-    m_cancel_requested = true;
+    cancel();
     join();
 }
 
+void ThreadWorker::shutdown() {
+    {
+        // 停止を先に立ててからキャンセルを要求する（ジョブの取り出しでキャンセルが解除されないよう、どちらもロック内で行う）
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_cancel_requested = true;
+    }
+    m_job_cv.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void ThreadWorker::reset_state() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_reset_state = true;
+}
+
+void ThreadWorker::set_cpu_affinity(int cpu_id) {
+    m_cpu_affinity = cpu_id;
+}
+
+void ThreadWorker::set_gc_settings(const LuaGcSettings& settings) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_gc_settings = settings;
+}
+
+LuaGcSettings ThreadWorker::gc_settings() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_gc_settings;
+}
+
+void ThreadWorker::set_profiling(int period) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_profile_period = period;
+}
+
 bool ThreadWorker::is_cancel_requested() const {
     return m_cancel_requested;
 }
@@ -48,12 +97,13 @@ float ThreadWorker::get_progress() const {
     return m_progress;
 }
 
-void ThreadWorker::thread_func(std::string script_path, std::string scene_type) {
-    sol::state lua;
-    lua.open_libraries(sol::lib::base, sol::lib::package, sol::lib::math, sol::lib::string, sol::lib::table, sol::lib::coroutine, sol::lib::os, sol::lib::io);
+std::unique_ptr<sol::state> ThreadWorker::create_state() {
+    // 他のワーカーとmallocのアリーナを奪い合わないよう、ワーカー専用のプールアロケータを使う
+    auto lua = std::make_unique<sol::state>(sol::default_at_panic, &LuaPoolAllocator::alloc, &m_allocator);
+    lua->open_libraries(sol::lib::base, sol::lib::package, sol::lib::math, sol::lib::string, sol::lib::table, sol::lib::coroutine, sol::lib::os, sol::lib::io);
 
     // Bind strict subset of functionality
-    bind_worker_lua(lua);
+    bind_worker_lua(*lua);
 
     // Inject shared data
     // Note: We are passing pointers to C++ objects.
@@ -61,33 +111,152 @@ void ThreadWorker::thread_func(std::string script_path, std::string scene_type)
     // Thread safety of AppData and EmbreeScene is crucial.
     // AppData: set_pixel is thread-safe if x,y are disjoint.
     // EmbreeScene: intersect is thread-safe (const method basically).
-    lua["_app_data"] = m_data; // sol will verify this type matches the bind
-    lua["_scene"] = m_scene;
+    (*lua)["_app_data"] = m_data; // sol will verify this type matches the bind
+    (*lua)["_scene"] = m_scene;
     
-    lua["_bounds"] = lua.create_table_with(
+    (*lua)["_bounds"] = lua->create_table_with(
         "x", m_bounds.x,
         "y", m_bounds.y,
         "w", m_bounds.w,
         "h", m_bounds.h
     );
     
-    lua["_scene_type"] = scene_type;
-    lua["_thread_id"] = m_thread_id;
+    (*lua)["_thread_id"] = m_thread_id;
+
+    // GCサイクル数の計測（統計はLua Stateより長く生存する）
+    install_gc_counter(lua->lua_state(), &m_gc_stats);
     
     // キャンセル確認関数を注入（ワーカーからC++のフラグを確認できるようにする）
-    lua["_is_cancel_requested"] = [this]() -> bool {
-        return m_cancel_requested.load();
+    // 明示的なキャンセルに加えて、ジョブのレンダー世代が古くなった場合も true を返す
+    (*lua)["_is_cancel_requested"] = [this]() -> bool {
+        return m_cancel_requested.load(std::memory_order_relaxed) || m_data->is_stale_writer();
     };
+    return lua;
+}
+
+void ThreadWorker::run_job(sol::state& lua, const Job& job) {
+    lua["_scene_type"] = job.scene_type;
+
+    // 前のジョブがプログレッシブパスの途中で終了していてもスプラットが残らないようにする
+    AppData::set_splat_size(1);
+    AppData::set_post_pass(false);
+    // このスレッドの書き込みを登録時の世代に紐づける（世代が進んだ後の書き込みは破棄される）
+    AppData::set_thread_generation(job.generation);
+
+    // GC設定はジョブごとに適用し、統計はジョブ単位で数える
+    lua_State* L = lua.lua_state();
+    apply_gc_settings(L, job.gc);
+    m_gc_stats.reset();
+    const int tile_step_kb = job.gc.tile_step_kb;
+    if (tile_step_kb > 0) {
+        // シェーディング中は自動GCを止め、ワーカースクリプトがタイルの境界で _gc_step() を呼ぶ
+        lua_gc(L, LUA_GCSTOP);
+        m_gc_last_kb = lua_gc(L, LUA_GCCOUNT);
+        lua["_gc_step"] = [this, tile_step_kb](sol::this_state ts) {
+            step_gc(ts.lua_state(), tile_step_kb, m_gc_last_kb, m_gc_stats);
+        };
+    } else {
+        lua["_gc_step"] = sol::lua_nil;
+    }
+    struct GcRestart {
+        lua_State* L;
+        bool stopped;
+        ~GcRestart() { if (stopped) lua_gc(L, LUA_GCRESTART); }
+    } gc_restart{L, tile_step_kb > 0};
+
+    // プロファイラはジョブの間だけフックを設定する（サンプルは take_profile() まで累積する）
+    if (job.profile_period > 0) {
+        m_profiler.start(L, job.profile_period);
+    }
+    struct ProfilerStop {
+        LuaProfiler& profiler;
+        lua_State* L;
+        bool started;
+        ~ProfilerStop() { if (started) profiler.stop(L); }
+    } profiler_stop{m_profiler, L, job.profile_period > 0};
+
+    // スクリプトはステートごとに一度だけ読み込み、以降のジョブでは再実行のみ行う
+    // 読み込みはプロセス共通のバイトコードキャッシュ経由なので、ステートを作り直してもコンパイルは発生しない
+    // （シーンモジュールは package.loaded に残るため require も再評価されない）
+    auto it = m_scripts.find(job.script_path);
+    if (it == m_scripts.end()) {
+        if (BytecodeCache::instance().load(L, job.script_path) != LUA_OK) {
+            std::cerr << "Thread " << m_thread_id << " Lua Error: " << lua_tostring(L, -1) << std::endl;
+            lua_pop(L, 1);
+            return;
+        }
+        sol::protected_function script(L, -1);
+        lua_pop(L, 1);
+        it = m_scripts.emplace(job.script_path, std::move(script)).first;
+    }
 
     // Execute the worker script
     // The worker script is expected to require the scene and run the loop
-    sol::protected_function_result result = lua.script_file(script_path, sol::script_pass_on_error);
+    sol::protected_function_result result = it->second();
     
     if (!result.valid()) {
         sol::error err = result;
         std::cerr << "Thread " << m_thread_id << " Lua Error: " << err.what() << std::endl;
     }
+}
+
+void ThreadWorker::thread_func() {
+    std::unique_ptr<sol::state> lua;
+
+    while (true) {
+        Job job;
+        bool reset = false;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_job_cv.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+            if (m_stop) {
+                break;
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            m_running = true;
+            // キャンセル要求は取り出したジョブより前のジョブに対するもの
+            m_cancel_requested = false;
+            reset = m_reset_state;
+            m_reset_state = false;
+        }
+
+        // CPUへの固定（Lua Stateの作成より前に行い、ファーストタッチでローカルノードに確保させる）
+        int cpu = m_cpu_affinity.load();
+        if (cpu >= 0 && cpu != m_pinned_cpu && CpuTopology::pin_current_thread(cpu)) {
+            m_pinned_cpu = cpu;
+            reset = reset || lua != nullptr;
+        }
+
+        // 初回・明示的なリセット・シーン切り替え・CPUの変更時のみLua Stateを作り直す
+        if (!lua || reset || job.scene_type != m_loaded_scene_type) {
+            m_scripts.clear();
+            lua.reset();
+            // 古いLua Stateのブロックは全て解放済みなので、アリーナを返して（固定したCPUのノードに）確保し直す
+            m_allocator.trim();
+            lua = create_state();
+            m_loaded_scene_type = job.scene_type;
+        }
+
+        run_job(*lua, job);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+            m_progress = 1.0f;
+            m_done = m_jobs.empty();
+        }
+        m_done_cv.notify_all();
+    }
+
+    // 参照を持つ関数を先に解放してから Lua State を破棄する
+    m_scripts.clear();
+    lua.reset();
+    m_allocator.trim();
 
+    // 未実行のジョブは破棄し、待機中の join() を解放する
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.clear();
     m_done = true;
-    m_progress = 1.0f;
+    m_done_cv.notify_all();
 }
@@ -3,9 +3,21 @@
 #include <thread>
 #include <atomic>
 #include <string>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <unordered_map>
 #include "app_data.h"
 #include "embree_wrapper.h"
+#include "lua_allocator.h"
+#include "lua_gc.h"
+#include "lua_profiler.h"
 
+// 永続スレッドと、ジョブ間で使い回すLua State（ウォームステート）を持つワーカー
+// start() はスレッドを生成せずジョブキューに積むだけなので、再レンダリング時の再起動コストが小さい
+// ジョブは登録時点の AppData のレンダー世代を持ち、世代が進むと書き込みが破棄されて自然に終了する
+// スレッドとLua Stateは shutdown() またはデストラクタまで生存する
 class ThreadWorker {
 public:
     struct Bounds {
@@ -15,15 +27,50 @@ public:
     ThreadWorker(AppData* data, EmbreeScene* scene, Bounds bounds, int thread_id);
     ~ThreadWorker();
 
+    // スクリプト実行ジョブを登録する（待たずに戻り、実行中のジョブの後に実行される）
+    // 初回呼び出し時に永続スレッドを起動する
     void start(const std::string& script_path, const std::string& scene_type);
+    // 登録済みのジョブが全て完了するまで待つ（スレッドは終了しない）
     void join();
+    // 未実行のジョブを破棄し、実行中のジョブにキャンセルを要求する（完了は待たない）
+    void cancel();
+    // 実行中のジョブにキャンセルを要求し、完了を待つ
     void terminate();
+    // 永続スレッドを停止してLua Stateを破棄する（再度 start() すると新しいスレッドで起動）
+    void shutdown();
+    // 次のジョブの前にLua Stateを作り直す（スクリプトの再読み込み用）
+    void reset_state();
+    // ワーカースレッドを指定した論理CPUに固定する（負の値で固定しない）
+    // 次のジョブの開始時に反映され、Lua Stateはピン留め後に作られるためNUMAノードローカルなメモリに確保される
+    void set_cpu_affinity(int cpu_id);
+    int cpu_affinity() const { return m_cpu_affinity; }
     bool is_done() const;
     bool is_cancel_requested() const;
     float get_progress() const;
+    // Lua Stateのメモリ割り当て統計（どのスレッドからでも読める）
+    LuaPoolAllocator::Stats memory_stats() const { return m_allocator.stats(); }
+    // Lua StateのGC設定（以降に登録したジョブから反映される）
+    void set_gc_settings(const LuaGcSettings& settings);
+    LuaGcSettings gc_settings();
+    // 直近のジョブのGC統計（ジョブの開始時にリセットされる）
+    const LuaGcStats& gc_stats() const { return m_gc_stats; }
+    // サンプリングプロファイラ（period 命令ごと、0 で無効。以降に登録したジョブから反映される）
+    void set_profiling(int period);
+    // これまでに集計したスタックを取り出して空にする（どのスレッドからでも呼べる）
+    LuaProfiler::Stacks take_profile() { return m_profiler.take(); }
 
 private:
-    void thread_func(std::string script_path, std::string scene_type);
+    struct Job {
+        std::string script_path;
+        std::string scene_type;
+        uint64_t generation;
+        LuaGcSettings gc;
+        int profile_period;
+    };
+
+    void thread_func();
+    std::unique_ptr<sol::state> create_state();
+    void run_job(sol::state& lua, const Job& job);
 
     AppData* m_data;
     EmbreeScene* m_scene;
@@ -31,6 +78,29 @@ private:
     int m_thread_id;
     
     std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_job_cv;   // ジョブ到着・停止要求の通知
+    std::condition_variable m_done_cv;  // ジョブ完了の通知
+    std::deque<Job> m_jobs;             // 未実行のジョブ
+    bool m_running = false;             // ジョブを実行中か
+    bool m_stop = false;
+    bool m_reset_state = false;
+    LuaGcSettings m_gc_settings;
+    int m_profile_period = 0;
+
+    // ワーカースレッド専用（ジョブ間で保持するコンパイル済みスクリプトと、直前のシーン種別）
+    std::unordered_map<std::string, sol::protected_function> m_scripts;
+    std::string m_loaded_scene_type;
+
+    // ワーカー専用のLuaアロケータ（Lua Stateより長く生存するため、統計値はLua Stateを作り直しても累積する）
+    LuaPoolAllocator m_allocator;
+    LuaGcStats m_gc_stats;
+    int m_gc_last_kb = 0; // ワーカースレッド専用（直前のタイル境界GCステップ後のヒープサイズ）
+    LuaProfiler m_profiler;
+
+    std::atomic<int> m_cpu_affinity{-1};
+    int m_pinned_cpu = -1; // ワーカースレッド専用（現在固定しているCPU）
+
     std::atomic<bool> m_done{true};
     std::atomic<bool> m_cancel_requested{false};
     std::atomic<float> m_progress{0.0f};
@@ -0,0 +1,142 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <unordered_map>
+#include "tile_scheduler.h"
+
+// 依存関係付きのタイルキュー（レンダリングとPostEffectのパイプライン用）
+// PostEffectタイルは、フィルタ半径分を広げた範囲に重なるレンダリングタイルが全て完了した時点で取得可能になる
+// レンダリングワーカーは完了したタイルを報告し、手が空いたら取得可能なPostEffectタイルを処理する
+class TileDependencyQueue {
+public:
+    using Tile = TileScheduler::Tile;
+
+    // @param render_tiles レンダリングタイル（シェーディング座標）
+    // @param post_tiles PostEffectタイル（バッファ座標）
+    // @param radius PostEffectが読み取る近傍の半径（ピクセル）
+    // @param flip_height 0より大きい場合、レンダリングタイルの y を flip_height - y - h に反転してバッファ座標にする
+    //                    （シーンの shade は (x, height - 1 - y) に書き込む）
+    // ワーカーがこのキューを参照する前に呼ぶこと
+    void reset(const std::vector<Tile>& render_tiles, std::vector<Tile> post_tiles, int radius, int flip_height) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_post_tiles = std::move(post_tiles);
+        m_pending.reset(new std::atomic<int>[m_post_tiles.size()]);
+        m_dependents.assign(render_tiles.size(), {});
+        m_render_index.clear();
+        m_ready.clear();
+        m_taken = 0;
+        m_retired.store(false, std::memory_order_relaxed);
+
+        for (size_t r = 0; r < render_tiles.size(); ++r) {
+            const Tile& tile = render_tiles[r];
+            m_render_index[key(tile.x, tile.y)] = static_cast<int>(r);
+        }
+
+        for (size_t p = 0; p < m_post_tiles.size(); ++p) {
+            const Tile& post = m_post_tiles[p];
+            int x0 = post.x - radius, x1 = post.x + post.w + radius;
+            int y0 = post.y - radius, y1 = post.y + post.h + radius;
+            int count = 0;
+            for (size_t r = 0; r < render_tiles.size(); ++r) {
+                const Tile& render = render_tiles[r];
+                int ry = flip_height > 0 ? flip_height - render.y - render.h : render.y;
+                if (render.x < x1 && render.x + render.w > x0 && ry < y1 && ry + render.h > y0) {
+                    m_dependents[r].push_back(static_cast<int>(p));
+                    ++count;
+                }
+            }
+            m_pending[p].store(count, std::memory_order_relaxed);
+            if (count == 0) {
+                m_ready.push_back(static_cast<int>(p));
+            }
+        }
+    }
+
+    // レンダリングタイルの完了を報告する（タイルの左上座標で識別、未登録の座標は無視）
+    void complete_render_tile(int x, int y) {
+        auto it = m_render_index.find(key(x, y));
+        if (it == m_render_index.end()) return;
+        for (int post : m_dependents[it->second]) {
+            if (m_pending[post].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_ready.push_back(post);
+                }
+                m_ready_cv.notify_all();
+            }
+        }
+    }
+
+    // 取得可能なPostEffectタイルを1つ取り出す
+    // @return 今すぐ取得できるタイルが無い場合 false（finished() で全タイル取得済みかを確認する）
+    bool next(Tile& out) {
+        if (retired()) return false;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_ready.empty()) return false;
+        out = m_post_tiles[m_ready.back()];
+        m_ready.pop_back();
+        // 最後のタイルを取得したら、残りを待っているスレッドを終了させる
+        if (++m_taken >= m_post_tiles.size()) {
+            m_ready_cv.notify_all();
+        }
+        return true;
+    }
+
+    // 全てのPostEffectタイルが取得済み、または打ち切られたか
+    bool finished() const {
+        if (retired()) return true;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_taken >= m_post_tiles.size();
+    }
+
+    // 未取得のPostEffectタイル数
+    size_t remaining() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_post_tiles.size() - m_taken;
+    }
+
+    // 取得可能なタイルができるか、全タイルが取得済みになるまで待つ（待機中はCPUを使わずにスリープする）
+    // 依存が解消されてタイルが取得可能になったとき、retire() されたときに起こされる
+    // @param timeout_ms 負なら無期限、0ならポーリングのみ
+    // @return true: 取得可能なタイルがある
+    bool wait_ready(int timeout_ms) const {
+        auto done = [this] { return !m_ready.empty() || m_taken >= m_post_tiles.size() || retired(); };
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (timeout_ms < 0) {
+            m_ready_cv.wait(lock, done);
+        } else if (timeout_ms > 0) {
+            m_ready_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), done);
+        }
+        return !m_ready.empty() && !retired();
+    }
+
+    // 以降のタイル取得を打ち切る（世代の更新時）
+    void retire() {
+        m_retired.store(true, std::memory_order_release);
+        { std::lock_guard<std::mutex> lock(m_mutex); }
+        m_ready_cv.notify_all();
+    }
+    bool retired() const { return m_retired.load(std::memory_order_acquire); }
+
+    size_t size() const { return m_post_tiles.size(); }
+
+private:
+    static uint64_t key(int x, int y) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+    }
+
+    std::vector<Tile> m_post_tiles;
+    std::unique_ptr<std::atomic<int>[]> m_pending;   // PostEffectタイルごとの未完了の依存数
+    std::vector<std::vector<int>> m_dependents;      // レンダリングタイル → 依存するPostEffectタイル
+    std::unordered_map<uint64_t, int> m_render_index; // 左上座標 → レンダリングタイル番号
+    std::vector<int> m_ready;                        // 取得可能なPostEffectタイル
+    size_t m_taken = 0;
+    std::atomic<bool> m_retired{false};
+    mutable std::mutex m_mutex;
+    mutable std::condition_variable m_ready_cv;
+};
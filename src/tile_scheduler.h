@@ -0,0 +1,153 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+
+// ワークスティーリング方式のタイルスケジューラ
+// タイル配列を連続した区間に分けて各ワーカーのキューとし、
+// 自分のキューは先頭から、空になったら他のキューの末尾から取得する
+// 各キューの [head, tail) は 64bit の1ワードにまとめており、取得は CAS 1回で完了する
+// retire() されたスケジューラはタイルを返さなくなり、古いレンダー世代のワーカーはタイル単位で終了する
+class TileScheduler {
+public:
+    struct Tile {
+        int x, y, w, h;
+    };
+
+    // タイル配列を num_queues 個のキューに均等に分配する
+    // ワーカーが next() を呼んでいない間（レンダリング開始前）にのみ呼ぶこと
+    void reset(std::vector<Tile> tiles, int num_queues) {
+        if (num_queues < 1) num_queues = 1;
+        m_tiles = std::move(tiles);
+        m_queues.reset(new Queue[num_queues]);
+        m_num_queues = num_queues;
+        m_completed.store(0, std::memory_order_relaxed);
+        m_retired.store(false, std::memory_order_relaxed);
+
+        const uint32_t count = static_cast<uint32_t>(m_tiles.size());
+        for (int i = 0; i < num_queues; ++i) {
+            uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(count) * i / num_queues);
+            uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(count) * (i + 1) / num_queues);
+            m_queues[i].range.store(pack(begin, end), std::memory_order_release);
+        }
+    }
+
+    // 次のタイルを取得する
+    // @param queue_index 呼び出し元ワーカーのキュー番号（キュー数を超える場合は剰余を使用）
+    // @return 取得できた場合 true、全キューが空なら false
+    bool next(int queue_index, Tile& out) {
+        if (m_num_queues == 0 || retired()) return false;
+        int own = (queue_index < 0 ? 0 : queue_index) % m_num_queues;
+
+        // 自分のキューの先頭から取得
+        if (pop_front(own, out)) return true;
+
+        // 他のキューの末尾から盗む
+        for (int i = 1; i < m_num_queues; ++i) {
+            if (steal_back((own + i) % m_num_queues, out)) return true;
+        }
+        return false;
+    }
+
+    // 未取得のタイル数（進捗表示用の概算値）
+    size_t remaining() const {
+        size_t total = 0;
+        for (int i = 0; i < m_num_queues; ++i) {
+            uint64_t range = m_queues[i].range.load(std::memory_order_relaxed);
+            total += tail_of(range) - head_of(range);
+        }
+        return total;
+    }
+
+    size_t size() const { return m_tiles.size(); }
+    int num_queues() const { return m_num_queues; }
+
+    // 処理を終えたタイルを報告する（多段パスのレベル間の待ち合わせ用）
+    // 最後のタイルの完了時だけ待機中のスレッドを起こす
+    void complete_tile() {
+        if (m_completed.fetch_add(1, std::memory_order_acq_rel) + 1 == m_tiles.size()) {
+            notify_waiters();
+        }
+    }
+
+    // 全タイルが完了するか打ち切られるまで待つ（待機中はCPUを使わずにスリープする）
+    // @param timeout_ms 負なら無期限、0ならポーリングのみ
+    // @return true: 全タイルが完了した, false: タイムアウトまたは打ち切り
+    bool wait_completed(int timeout_ms) const {
+        auto done = [this] { return completed() || retired(); };
+        if (!done() && timeout_ms != 0) {
+            std::unique_lock<std::mutex> lock(m_wait_mutex);
+            if (timeout_ms < 0) {
+                m_wait_cv.wait(lock, done);
+            } else {
+                m_wait_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), done);
+            }
+        }
+        return completed();
+    }
+
+    // 以降のタイル取得と待ち合わせを打ち切る（スケジューラの置き換え・世代の更新時）
+    void retire() {
+        m_retired.store(true, std::memory_order_release);
+        notify_waiters();
+    }
+    bool retired() const { return m_retired.load(std::memory_order_acquire); }
+
+private:
+    bool completed() const { return m_completed.load(std::memory_order_acquire) >= m_tiles.size(); }
+
+    // 状態の更新後にロックを取ってから起こす（待機側の条件確認との間で通知を取りこぼさない）
+    void notify_waiters() {
+        { std::lock_guard<std::mutex> lock(m_wait_mutex); }
+        m_wait_cv.notify_all();
+    }
+
+    // 偽共有を避けるためキャッシュライン単位で配置
+    struct alignas(64) Queue {
+        std::atomic<uint64_t> range{0};
+    };
+
+    static uint64_t pack(uint32_t head, uint32_t tail) {
+        return (static_cast<uint64_t>(head) << 32) | tail;
+    }
+    static uint32_t head_of(uint64_t range) { return static_cast<uint32_t>(range >> 32); }
+    static uint32_t tail_of(uint64_t range) { return static_cast<uint32_t>(range & 0xFFFFFFFFu); }
+
+    bool pop_front(int index, Tile& out) {
+        auto& range = m_queues[index].range;
+        uint64_t current = range.load(std::memory_order_acquire);
+        while (head_of(current) < tail_of(current)) {
+            if (range.compare_exchange_weak(current, pack(head_of(current) + 1, tail_of(current)),
+                                            std::memory_order_acq_rel, std::memory_order_acquire)) {
+                out = m_tiles[head_of(current)];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool steal_back(int index, Tile& out) {
+        auto& range = m_queues[index].range;
+        uint64_t current = range.load(std::memory_order_acquire);
+        while (head_of(current) < tail_of(current)) {
+            if (range.compare_exchange_weak(current, pack(head_of(current), tail_of(current) - 1),
+                                            std::memory_order_acq_rel, std::memory_order_acquire)) {
+                out = m_tiles[tail_of(current) - 1];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<Tile> m_tiles;
+    std::unique_ptr<Queue[]> m_queues;
+    int m_num_queues = 0;
+    std::atomic<size_t> m_completed{0};
+    std::atomic<bool> m_retired{false};
+    mutable std::mutex m_wait_mutex;
+    mutable std::condition_variable m_wait_cv;
+};
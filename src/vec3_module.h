@@ -0,0 +1,162 @@
+#pragma once
+#include <cmath>
+extern "C" {
+#include <lua.h>
+#include <lauxlib.h>
+}
+
+// 割り当てなしの3Dベクトル演算モジュール（グローバル v3）
+// ベクトルは (x, y, z) の3つの数値として受け取り、結果も多値で返すため、テーブルやuserdataを一切作らない
+// シェーディングのホットパス（Material / PathTracer）が Vec3 テーブルの代わりに使う
+// Lua側からは lib/V3.lua 経由で参照する（ネイティブが無い環境では同じAPIのLua実装になる）
+namespace vec3_module {
+
+inline lua_Number arg(lua_State* L, int index) { return lua_tonumber(L, index); }
+
+inline int push3(lua_State* L, lua_Number x, lua_Number y, lua_Number z) {
+    lua_pushnumber(L, x);
+    lua_pushnumber(L, y);
+    lua_pushnumber(L, z);
+    return 3;
+}
+
+// add(ax, ay, az, bx, by, bz) -> a + b
+inline int add(lua_State* L) {
+    return push3(L, arg(L, 1) + arg(L, 4), arg(L, 2) + arg(L, 5), arg(L, 3) + arg(L, 6));
+}
+
+// sub(ax, ay, az, bx, by, bz) -> a - b
+inline int sub(lua_State* L) {
+    return push3(L, arg(L, 1) - arg(L, 4), arg(L, 2) - arg(L, 5), arg(L, 3) - arg(L, 6));
+}
+
+// mul(ax, ay, az, bx, by, bz) -> 要素ごとの積
+inline int mul(lua_State* L) {
+    return push3(L, arg(L, 1) * arg(L, 4), arg(L, 2) * arg(L, 5), arg(L, 3) * arg(L, 6));
+}
+
+// scale(ax, ay, az, s) -> a * s
+inline int scale(lua_State* L) {
+    lua_Number s = arg(L, 4);
+    return push3(L, arg(L, 1) * s, arg(L, 2) * s, arg(L, 3) * s);
+}
+
+// madd(ax, ay, az, bx, by, bz, s) -> a + b * s
+inline int madd(lua_State* L) {
+    lua_Number s = arg(L, 7);
+    return push3(L, arg(L, 1) + arg(L, 4) * s, arg(L, 2) + arg(L, 5) * s, arg(L, 3) + arg(L, 6) * s);
+}
+
+// dot(ax, ay, az, bx, by, bz) -> a・b
+inline int dot(lua_State* L) {
+    lua_pushnumber(L, arg(L, 1) * arg(L, 4) + arg(L, 2) * arg(L, 5) + arg(L, 3) * arg(L, 6));
+    return 1;
+}
+
+// cross(ax, ay, az, bx, by, bz) -> a × b
+inline int cross(lua_State* L) {
+    lua_Number ax = arg(L, 1), ay = arg(L, 2), az = arg(L, 3);
+    lua_Number bx = arg(L, 4), by = arg(L, 5), bz = arg(L, 6);
+    return push3(L, ay * bz - az * by, az * bx - ax * bz, ax * by - ay * bx);
+}
+
+inline int length_squared(lua_State* L) {
+    lua_Number x = arg(L, 1), y = arg(L, 2), z = arg(L, 3);
+    lua_pushnumber(L, x * x + y * y + z * z);
+    return 1;
+}
+
+inline int length(lua_State* L) {
+    lua_Number x = arg(L, 1), y = arg(L, 2), z = arg(L, 3);
+    lua_pushnumber(L, std::sqrt(x * x + y * y + z * z));
+    return 1;
+}
+
+// normalize(x, y, z) -> 単位ベクトル（長さ0の場合は 0, 0, 0）
+inline int normalize(lua_State* L) {
+    lua_Number x = arg(L, 1), y = arg(L, 2), z = arg(L, 3);
+    lua_Number len = std::sqrt(x * x + y * y + z * z);
+    if (len > 0) {
+        return push3(L, x / len, y / len, z / len);
+    }
+    return push3(L, 0, 0, 0);
+}
+
+// near_zero(x, y, z) -> 全成分が 1e-8 未満か
+inline int near_zero(lua_State* L) {
+    const lua_Number s = 1e-8;
+    lua_pushboolean(L, std::fabs(arg(L, 1)) < s && std::fabs(arg(L, 2)) < s && std::fabs(arg(L, 3)) < s);
+    return 1;
+}
+
+// reflect(vx, vy, vz, nx, ny, nz) -> v - n * 2(v・n)
+inline int reflect(lua_State* L) {
+    lua_Number vx = arg(L, 1), vy = arg(L, 2), vz = arg(L, 3);
+    lua_Number nx = arg(L, 4), ny = arg(L, 5), nz = arg(L, 6);
+    lua_Number d = 2 * (vx * nx + vy * ny + vz * nz);
+    return push3(L, vx - nx * d, vy - ny * d, vz - nz * d);
+}
+
+// refract(ux, uy, uz, nx, ny, nz, etai_over_etat) -> 屈折ベクトル（スネルの法則、u は単位ベクトル）
+inline int refract(lua_State* L) {
+    lua_Number ux = arg(L, 1), uy = arg(L, 2), uz = arg(L, 3);
+    lua_Number nx = arg(L, 4), ny = arg(L, 5), nz = arg(L, 6);
+    lua_Number eta = arg(L, 7);
+    lua_Number cos_theta = -(ux * nx + uy * ny + uz * nz);
+    if (cos_theta > 1) cos_theta = 1;
+    lua_Number px = (ux + nx * cos_theta) * eta;
+    lua_Number py = (uy + ny * cos_theta) * eta;
+    lua_Number pz = (uz + nz * cos_theta) * eta;
+    lua_Number k = -std::sqrt(std::fabs(1 - (px * px + py * py + pz * pz)));
+    return push3(L, px + nx * k, py + ny * k, pz + nz * k);
+}
+
+// onb(nx, ny, nz) -> wx, wy, wz, ux, uy, uz, vx, vy, vz（法線 w に直交する正規直交基底）
+inline int onb(lua_State* L) {
+    lua_Number x = arg(L, 1), y = arg(L, 2), z = arg(L, 3);
+    lua_Number len = std::sqrt(x * x + y * y + z * z);
+    lua_Number wx = 0, wy = 0, wz = 0;
+    if (len > 0) {
+        wx = x / len; wy = y / len; wz = z / len;
+    }
+    // w.x が0に近い場合は (1, 0, 0)、それ以外は (0, 1, 0) を基準に u を作る
+    lua_Number ax = 0, ay = 1, az = 0;
+    if (!(std::fabs(wx) > 1e-6)) {
+        ax = 1; ay = 0;
+    }
+    lua_Number ux = ay * wz - az * wy, uy = az * wx - ax * wz, uz = ax * wy - ay * wx;
+    lua_Number ulen = std::sqrt(ux * ux + uy * uy + uz * uz);
+    if (ulen > 0) {
+        ux /= ulen; uy /= ulen; uz /= ulen;
+    }
+    lua_Number vx = wy * uz - wz * uy, vy = wz * ux - wx * uz, vz = wx * uy - wy * ux;
+    push3(L, wx, wy, wz);
+    push3(L, ux, uy, uz);
+    push3(L, vx, vy, vz);
+    return 9;
+}
+
+} // namespace vec3_module
+
+// グローバル v3 テーブルとして登録する
+inline void open_vec3_module(lua_State* L) {
+    static const luaL_Reg functions[] = {
+        {"add", &vec3_module::add},
+        {"sub", &vec3_module::sub},
+        {"mul", &vec3_module::mul},
+        {"scale", &vec3_module::scale},
+        {"madd", &vec3_module::madd},
+        {"dot", &vec3_module::dot},
+        {"cross", &vec3_module::cross},
+        {"length_squared", &vec3_module::length_squared},
+        {"length", &vec3_module::length},
+        {"normalize", &vec3_module::normalize},
+        {"near_zero", &vec3_module::near_zero},
+        {"reflect", &vec3_module::reflect},
+        {"refract", &vec3_module::refract},
+        {"onb", &vec3_module::onb},
+        {nullptr, nullptr}
+    };
+    luaL_newlib(L, functions);
+    lua_setglobal(L, "v3");
+}
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include "app_data.h"
+#include <thread>
+#include <atomic>
+#include <chrono>
 
 class AppDataTest : public ::testing::Test {
 protected:
@@ -321,6 +324,83 @@ TEST_F(AppDataTest, ClearBackBufferClearsOnlyBackBuffer) {
     EXPECT_EQ(bB, 0);
 }
 
+// ========================================
+// present（三重バッファの回転）テスト
+// ========================================
+
+TEST_F(AppDataTest, PresentMovesBackToFrontWithoutCopy) {
+    AppData data(10, 10);
+
+    data.set_pixel(2, 2, 10, 20, 30);
+    const void* back_before = data.get_back_data();
+    const void* front_before = data.get_data();
+
+    data.present();
+
+    // バックだったバッファがそのままフロントになる
+    EXPECT_EQ(data.get_data(), back_before);
+    // 新しいバックは3つ目のバッファで、直前のフロントではない
+    EXPECT_NE(data.get_back_data(), back_before);
+    EXPECT_NE(data.get_back_data(), front_before);
+
+    auto [r, g, b] = data.get_pixel(2, 2);
+    EXPECT_EQ(r, 10);
+    EXPECT_EQ(g, 20);
+    EXPECT_EQ(b, 30);
+}
+
+// PostEffect: 回転後のフロントから読み、バックに書いて再度回転する
+TEST_F(AppDataTest, PresentSupportsPostEffectPass) {
+    AppData data(4, 4);
+
+    data.set_pixel(0, 0, 200, 0, 0); // レンダリング結果
+    data.present();
+
+    auto [r, g, b] = data.get_pixel(0, 0);
+    data.set_pixel(0, 0, g, r, b); // PostEffect: 赤と緑を入れ替え
+
+    // PostEffect中もレンダリング結果は読み取れる
+    EXPECT_EQ(std::get<0>(data.get_pixel(0, 0)), 200);
+
+    data.present();
+    auto [r2, g2, b2] = data.get_pixel(0, 0);
+    EXPECT_EQ(r2, 0);
+    EXPECT_EQ(g2, 200);
+    EXPECT_EQ(b2, 0);
+}
+
+TEST_F(AppDataTest, PresentCyclesThroughThreeBuffers) {
+    AppData data(4, 4);
+
+    const void* first = data.get_back_data();
+    data.present();
+    data.present();
+    data.present();
+
+    // 3回回転するとバックバッファが元に戻る
+    EXPECT_EQ(data.get_back_data(), first);
+}
+
+TEST_F(AppDataTest, PresentAdvancesGenerationAndResetsDirtyTiles) {
+    AppData data(64, 64);
+
+    EXPECT_EQ(data.get_generation(AppData::FRONT), 0u);
+
+    data.set_pixel(1, 1, 1, 1, 1);
+    EXPECT_EQ(data.present(), 1u);
+    EXPECT_EQ(data.present(), 2u);
+    EXPECT_EQ(data.get_generation(AppData::FRONT), 2u);
+    // 直前のフロントは待機バッファに回る
+    EXPECT_EQ(data.get_generation(AppData::SPARE), 1u);
+
+    int dirty_count = 0;
+    data.consume_dirty_rects([&](int, int, int, int) { ++dirty_count; });
+    EXPECT_EQ(dirty_count, 0);
+
+    data.clear();
+    EXPECT_EQ(data.get_generation(AppData::FRONT), 0u);
+}
+
 // ========================================
 // GltfData キャッシュテスト（TDD）
 // ========================================
@@ -392,3 +472,290 @@ TEST_F(AppDataTest, LoadTextureImageFailsWithoutGltf) {
     // GltfData がロードされていない場合は失敗
     EXPECT_FALSE(data.load_texture_image("tex", "missing_gltf", 0));
 }
+
+// ========================================
+// ダーティタイルテスト
+// ========================================
+
+TEST_F(AppDataTest, ConsumeDirtyRectsReportsWrittenTile) {
+    AppData data(100, 100);
+
+    data.set_pixel(40, 70, 255, 0, 0);
+
+    std::vector<std::tuple<int, int, int, int>> rects;
+    data.consume_dirty_rects([&](int x, int y, int w, int h) {
+        rects.emplace_back(x, y, w, h);
+    });
+
+    // (40, 70) はタイル (1, 2) に含まれる
+    ASSERT_EQ(rects.size(), 1u);
+    EXPECT_EQ(rects[0], std::make_tuple(32, 64, 32, 32));
+}
+
+TEST_F(AppDataTest, ConsumeDirtyRectsMergesAdjacentTilesAndClipsEdges) {
+    AppData data(100, 40);
+
+    // 同じタイル行の隣接タイル 0〜3 に書き込み（最後のタイルは幅4ピクセル）
+    data.set_pixel(0, 0, 1, 1, 1);
+    data.set_pixel(33, 0, 1, 1, 1);
+    data.set_pixel(70, 0, 1, 1, 1);
+    data.set_pixel(99, 0, 1, 1, 1);
+    // 2行目のタイル（高さ8ピクセル）
+    data.set_pixel(5, 39, 1, 1, 1);
+
+    std::vector<std::tuple<int, int, int, int>> rects;
+    data.consume_dirty_rects([&](int x, int y, int w, int h) {
+        rects.emplace_back(x, y, w, h);
+    });
+
+    ASSERT_EQ(rects.size(), 2u);
+    EXPECT_EQ(rects[0], std::make_tuple(0, 0, 100, 32));
+    EXPECT_EQ(rects[1], std::make_tuple(0, 32, 32, 8));
+}
+
+TEST_F(AppDataTest, ConsumeDirtyRectsClearsDirtyState) {
+    AppData data(64, 64);
+
+    data.set_pixel(1, 1, 1, 1, 1);
+
+    int first_count = 0;
+    data.consume_dirty_rects([&](int, int, int, int) { ++first_count; });
+    EXPECT_EQ(first_count, 1);
+
+    // 2回目は書き込みが無いので何も列挙されない
+    int second_count = 0;
+    data.consume_dirty_rects([&](int, int, int, int) { ++second_count; });
+    EXPECT_EQ(second_count, 0);
+
+    // クリア後もダーティ状態はリセットされる
+    data.set_pixel(1, 1, 1, 1, 1);
+    data.clear_back_buffer();
+    int after_clear_count = 0;
+    data.consume_dirty_rects([&](int, int, int, int) { ++after_clear_count; });
+    EXPECT_EQ(after_clear_count, 0);
+}
+
+// パイプラインPostEffectの書き込みはSPAREに行くため、バックバッファのダーティタイルにならない
+TEST_F(AppDataTest, PostPassWritesDoNotMarkBackBufferDirty) {
+    AppData data(64, 64);
+
+    AppData::set_post_pass(true);
+    data.set_pixel(1, 1, 1, 1, 1);
+    AppData::set_splat_size(4);
+    data.set_pixel(40, 40, 1, 1, 1);
+    AppData::set_splat_size(1);
+    AppData::set_post_pass(false);
+
+    int count = 0;
+    data.consume_dirty_rects([&](int, int, int, int) { ++count; });
+    EXPECT_EQ(count, 0);
+}
+
+// ========================================
+// AOVテスト
+// ========================================
+
+TEST_F(AppDataTest, AovsAreDisabledByDefault) {
+    AppData data(4, 4);
+    EXPECT_FALSE(data.has_aovs());
+    EXPECT_EQ(data.aovs(), nullptr);
+
+    // 無効時の書き込みは無視され、読み取りは既定値を返す
+    data.set_aov(1, 1, 0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 3.0f, 7);
+    EXPECT_FLOAT_EQ(data.get_depth(1, 1), 0.0f);
+    EXPECT_EQ(data.get_object_id(1, 1), AovBuffers::NO_OBJECT);
+}
+
+TEST_F(AppDataTest, SetAovStoresAllChannels) {
+    AppData data(4, 4);
+    data.enable_aovs();
+    ASSERT_TRUE(data.has_aovs());
+
+    data.set_aov(2, 3, 0.25f, 0.5f, 0.75f, 0.0f, 1.0f, 0.0f, 12.5f, 4);
+
+    auto [ar, ag, ab] = data.get_albedo(2, 3);
+    EXPECT_FLOAT_EQ(ar, 0.25f);
+    EXPECT_FLOAT_EQ(ag, 0.5f);
+    EXPECT_FLOAT_EQ(ab, 0.75f);
+    auto [nx, ny, nz] = data.get_normal(2, 3);
+    EXPECT_FLOAT_EQ(nx, 0.0f);
+    EXPECT_FLOAT_EQ(ny, 1.0f);
+    EXPECT_FLOAT_EQ(nz, 0.0f);
+    EXPECT_FLOAT_EQ(data.get_depth(2, 3), 12.5f);
+    EXPECT_EQ(data.get_object_id(2, 3), 4);
+
+    // 書き込んでいないピクセルと範囲外は「ヒットなし」
+    EXPECT_EQ(data.get_object_id(0, 0), AovBuffers::NO_OBJECT);
+    EXPECT_EQ(data.get_object_id(-1, 0), AovBuffers::NO_OBJECT);
+    data.set_aov(4, 0, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 9);
+    EXPECT_EQ(data.aovs()->object_id().size(), 16u);
+}
+
+TEST_F(AppDataTest, AovsSurvivePresentAndResetOnClear) {
+    AppData data(4, 4);
+    data.enable_aovs();
+    data.set_aov(1, 1, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 2.0f, 3);
+
+    // PostEffect から読めるよう、バッファの回転では保持される
+    data.present();
+    EXPECT_EQ(data.get_object_id(1, 1), 3);
+
+    // 再レンダリング開始時のクリアでリセットされる
+    data.clear();
+    EXPECT_TRUE(data.has_aovs());
+    EXPECT_EQ(data.get_object_id(1, 1), AovBuffers::NO_OBJECT);
+    EXPECT_FLOAT_EQ(data.get_depth(1, 1), 0.0f);
+
+    data.disable_aovs();
+    EXPECT_FALSE(data.has_aovs());
+}
+
+TEST_F(AppDataTest, SplatSizeFillsClippedBlockOnCallingThread) {
+    AppData data(6, 6);
+    AppData::set_splat_size(4);
+    data.set_pixel(4, 0, 255, 0, 0);
+    AppData::set_splat_size(1);
+    data.set_pixel(0, 5, 0, 0, 255);
+    data.present();
+
+    // (4, 0) から 4×4 のブロックが画面内にクリップされて塗られる
+    EXPECT_EQ(data.get_pixel(5, 3), std::make_tuple(255, 0, 0));
+    EXPECT_EQ(data.get_pixel(4, 4), std::make_tuple(0, 0, 0));
+    EXPECT_EQ(data.get_pixel(3, 0), std::make_tuple(0, 0, 0));
+    // スプラットサイズ1では通常の1ピクセル書き込み
+    EXPECT_EQ(data.get_pixel(0, 5), std::make_tuple(0, 0, 255));
+    EXPECT_EQ(data.get_pixel(1, 5), std::make_tuple(0, 0, 0));
+
+    // スプラットサイズはスレッドごとに独立
+    AppData::set_splat_size(8);
+    int other_thread_size = 0;
+    std::thread([&] { other_thread_size = AppData::splat_size(); }).join();
+    AppData::set_splat_size(1);
+    EXPECT_EQ(other_thread_size, 1);
+}
+
+// パイプラインPostEffect: バックバッファから読み、SPAREに書き、present 2回で結果が表示される
+TEST_F(AppDataTest, PostPassReadsBackAndWritesSpare) {
+    AppData data(2, 1);
+    data.set_pixel(0, 0, 10, 20, 30);
+
+    AppData::set_post_pass(true);
+    EXPECT_EQ(data.get_pixel(0, 0), std::make_tuple(10, 20, 30));
+    data.set_pixel(0, 0, 40, 50, 60);
+    // バックバッファのレンダリング結果は上書きされない
+    EXPECT_EQ(data.get_pixel(0, 0), std::make_tuple(10, 20, 30));
+    AppData::set_post_pass(false);
+
+    data.present();
+    EXPECT_EQ(data.get_pixel(0, 0), std::make_tuple(10, 20, 30));
+    data.present();
+    EXPECT_EQ(data.get_pixel(0, 0), std::make_tuple(40, 50, 60));
+}
+
+// 世代を進めた後は、世代の確認を通過済みだった古いワーカーの書き込みもバッファに残らない
+TEST_F(AppDataTest, AdvanceRenderGenerationWaitsForInFlightStaleWrites) {
+    AppData data(16, 16);
+    uint64_t generation = data.render_generation();
+    std::atomic<bool> started{false};
+    std::atomic<bool> stop{false};
+    std::thread writer([&]() {
+        AppData::set_thread_generation(generation);
+        while (!stop.load()) {
+            for (int i = 0; i < 16 * 16; ++i) {
+                data.set_pixel(i % 16, i / 16, 255, 0, 0);
+            }
+            started.store(true);
+        }
+        AppData::set_thread_generation(0);
+    });
+    while (!started.load()) {
+        std::this_thread::yield();
+    }
+
+    data.advance_render_generation();
+    data.clear();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    stop.store(true);
+    writer.join();
+
+    data.present();
+    for (int i = 0; i < 16 * 16; ++i) {
+        ASSERT_EQ(data.get_pixel(i % 16, i / 16), std::make_tuple(0, 0, 0)) << i;
+    }
+}
+
+// ワーカーのエラー時の打ち切り: 世代は進めずにタイルキューを打ち切り、古い世代のワーカーからは無視する
+TEST_F(AppDataTest, AbortTilesRetiresQueuesOfCurrentGeneration) {
+    AppData data(4, 4);
+    data.setup_tiles("render_queue", {{0, 0, 4, 4}}, 1);
+    data.setup_dependent_tiles("post_pipeline", {{0, 0, 4, 4}}, {{0, 0, 4, 4}}, 1, 0);
+    auto tiles = data.tile_queue("render_queue");
+    auto pipeline = data.dependent_tiles("post_pipeline");
+    uint64_t generation = data.render_generation();
+
+    AppData::set_thread_generation(generation + 1);
+    data.abort_tiles();
+    EXPECT_FALSE(tiles->retired());
+    EXPECT_FALSE(pipeline->retired());
+
+    AppData::set_thread_generation(generation);
+    data.abort_tiles();
+    AppData::set_thread_generation(0);
+    EXPECT_TRUE(tiles->retired());
+    EXPECT_TRUE(pipeline->retired());
+    EXPECT_TRUE(pipeline->finished());
+    EXPECT_FALSE(tiles->wait_completed(-1));
+    EXPECT_EQ(data.render_generation(), generation);
+}
+
+// レベルのラッチ: 古い世代のワーカーのカウントダウンは無視し、世代を進めると待機中のワーカーを起こす
+TEST_F(AppDataTest, CountDownLatchIgnoresStaleGenerationAndAdvanceWakesWaiters) {
+    AppData data(4, 4);
+    int latch = data.sync().latch_slot("render_queue@2", 2);
+    uint64_t generation = data.render_generation();
+
+    AppData::set_thread_generation(generation + 1);
+    data.count_down_latch(latch, 1);
+    AppData::set_thread_generation(generation);
+    data.count_down_latch(latch, 1);
+    AppData::set_thread_generation(0);
+    EXPECT_FALSE(data.sync().latch_try_wait(latch));
+
+    std::thread advancer([&data]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        data.advance_render_generation();
+    });
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(data.sync().latch_wait(latch, 5000));
+    advancer.join();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+}
+
+TEST_F(AppDataTest, AdvanceRenderGenerationDropsStaleWritesAndRetiresTiles) {
+    AppData data(4, 4);
+    data.setup_tiles("render_queue", {{0, 0, 4, 4}}, 1);
+    auto tiles = data.tile_queue("render_queue");
+    uint64_t first = data.render_generation();
+
+    uint64_t second = data.advance_render_generation();
+    EXPECT_EQ(second, first + 1);
+    EXPECT_TRUE(tiles->retired());
+
+    // 古い世代のジョブからの書き込みは破棄され、現在の世代と世代未設定（メインスレッド）は書き込める
+    AppData::set_thread_generation(first);
+    EXPECT_TRUE(data.is_stale_writer());
+    data.set_pixel(0, 0, 255, 0, 0);
+    AppData::set_thread_generation(second);
+    data.set_pixel(1, 0, 0, 255, 0);
+    AppData::set_thread_generation(0);
+    data.set_pixel(2, 0, 0, 0, 255);
+    data.present();
+    EXPECT_EQ(data.get_pixel(0, 0), std::make_tuple(0, 0, 0));
+    EXPECT_EQ(data.get_pixel(1, 0), std::make_tuple(0, 255, 0));
+    EXPECT_EQ(data.get_pixel(2, 0), std::make_tuple(0, 0, 255));
+
+    // 置き換え前のキューは保持している側が手放すまで有効
+    data.setup_tiles("render_queue", {{0, 0, 2, 2}}, 1);
+    EXPECT_NE(data.tile_queue("render_queue"), tiles);
+    EXPECT_EQ(tiles->size(), 1u);
+}
@@ -22,7 +22,14 @@ protected:
             "swap", &AppData::swap,
             "width", &AppData::get_width,
             "height", &AppData::get_height,
-            "clear", &AppData::clear
+            "clear", &AppData::clear,
+            "enable_aovs", &AppData::enable_aovs,
+            "has_aovs", &AppData::has_aovs,
+            "set_aov", &AppData::set_aov,
+            "get_albedo", &AppData::get_albedo,
+            "get_normal", &AppData::get_normal,
+            "get_depth", &AppData::get_depth,
+            "get_object_id", &AppData::get_object_id
         );
     }
 
@@ -183,3 +190,81 @@ TEST_F(BilateralFilterTest, FilterWithCustomParams) {
     ASSERT_NEAR(g, 100, 1);
     ASSERT_NEAR(b, 100, 1);
 }
+
+// ===========================================
+// AOVガイド付きフィルタテスト
+// ===========================================
+
+TEST_F(BilateralFilterTest, FilterGuidedFallsBackWithoutAovs) {
+    // AOVが無効な場合は通常のフィルタと同じ結果になる
+    auto result = lua.safe_script(R"(
+        local BF = require('lib.BilateralFilter')
+        local data = AppData.new(5, 5)
+        for y = 0, 4 do
+            for x = 0, 4 do
+                data:set_pixel(x, y, (x * 40) % 256, 80, 120)
+            end
+        end
+        data:swap()
+
+        local r1, g1, b1 = BF.filter(data, 2, 2, {radius = 2})
+        local r2, g2, b2 = BF.filter_guided(data, 2, 2, {radius = 2})
+        return r1 == r2 and g1 == g2 and b1 == b2
+    )");
+    ASSERT_TRUE(result.valid());
+    ASSERT_TRUE(result.get<bool>());
+}
+
+TEST_F(BilateralFilterTest, FilterGuidedDoesNotMixObjects) {
+    // 色が近くても別オブジェクトのピクセルは混合しない
+    auto result = lua.safe_script(R"(
+        local BF = require('lib.BilateralFilter')
+        local data = AppData.new(6, 6)
+        data:enable_aovs()
+
+        -- 左半分: オブジェクト0（明るさ100）、右半分: オブジェクト1（明るさ140）
+        for y = 0, 5 do
+            for x = 0, 5 do
+                local id = x < 3 and 0 or 1
+                local v = x < 3 and 100 or 140
+                data:set_pixel(x, y, v, v, v)
+                data:set_aov(x, y, 0.5, 0.5, 0.5, 0, 0, 1, 10, id)
+            end
+        end
+        data:swap()
+
+        local guided = BF.filter_guided(data, 2, 2, {radius = 2, sigma_color = 1.0})
+        local plain = BF.filter(data, 2, 2, {radius = 2, sigma_color = 1.0})
+        return guided, plain
+    )");
+    ASSERT_TRUE(result.valid());
+    auto [guided, plain] = result.get<std::tuple<int, int>>();
+    EXPECT_EQ(guided, 100);
+    EXPECT_GT(plain, 100);
+}
+
+TEST_F(BilateralFilterTest, FilterGuidedSmoothsNoiseWithinObject) {
+    // 同一オブジェクト・同一平面上のノイズは平滑化される
+    auto result = lua.safe_script(R"(
+        local BF = require('lib.BilateralFilter')
+        local data = AppData.new(5, 5)
+        data:enable_aovs()
+
+        for y = 0, 4 do
+            for x = 0, 4 do
+                local v = ((x + y) % 2 == 0) and 80 or 120
+                data:set_pixel(x, y, v, v, v)
+                data:set_aov(x, y, 0.5, 0.5, 0.5, 0, 1, 0, 5, 2)
+            end
+        end
+        data:swap()
+
+        local r = BF.filter_guided(data, 2, 2, {radius = 2})
+        return r
+    )");
+    ASSERT_TRUE(result.valid());
+    int r = result.get<int>();
+    // 中心は 80 だが周囲の 120 と混合されて平均に近づく
+    EXPECT_GT(r, 90);
+    EXPECT_LT(r, 110);
+}
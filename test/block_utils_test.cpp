@@ -4,6 +4,7 @@
 #include <gtest/gtest.h>
 #include <sol/sol.hpp>
 #include "../src/app_data.h"
+#include "../src/lua_binding.h"
 
 class BlockUtilsTest : public ::testing::Test {
 protected:
@@ -290,21 +291,22 @@ TEST_F(BlockUtilsTest, ShuffleBlocksDoesNotModifyOriginal) {
 // 注: これらのテストはAppDataモックを使用するため、
 // Lua単体ではなくapp_dataを注入してテストする必要がある
 
-// テスト13: setup_shared_queue がブロック配列をJSONで保存
-TEST_F(BlockUtilsTest, SetupSharedQueueStoresBlocksAsJson) {
+// テスト13: setup_shared_queue がブロック配列をタイルスケジューラに登録
+TEST_F(BlockUtilsTest, SetupSharedQueueRegistersTileScheduler) {
     // AppDataモックのバインディング
-    lua.new_usertype<AppData>("MockAppData",
+    auto mock_type = lua.new_usertype<AppData>("MockAppData",
         "set_string", &AppData::set_string,
         "get_string", &AppData::get_string,
         "pop_next_index", &AppData::pop_next_index
     );
+    bind_shared_store(lua, mock_type);
+    bind_tile_scheduler(lua, mock_type);
     
     AppData data(100, 100);
     lua["app_data"] = &data;
     
     lua.script(R"(
         local BlockUtils = require("lib.BlockUtils")
-        local json = require("lib.json")
         
         local blocks = {
             {x = 0, y = 0, w = 64, h = 64},
@@ -312,27 +314,33 @@ TEST_F(BlockUtilsTest, SetupSharedQueueStoresBlocksAsJson) {
         }
         
         BlockUtils.setup_shared_queue(app_data, blocks, "test_queue")
-        
-        -- 保存されたデータを確認
-        stored_json = app_data:get_string("test_queue")
-        stored_blocks = json.decode(stored_json)
     )");
     
-    sol::table stored_blocks = lua["stored_blocks"];
-    ASSERT_EQ(stored_blocks.size(), 2);
-    
-    sol::table first = stored_blocks[1];
-    ASSERT_EQ(first["x"].get<int>(), 0);
-    ASSERT_EQ(first["y"].get<int>(), 0);
+    // キュー1つのスケジューラにブロック順で登録されている
+    auto tiles = data.tile_queue("test_queue");
+    ASSERT_NE(tiles, nullptr);
+    EXPECT_EQ(tiles->size(), 2u);
+    EXPECT_EQ(tiles->num_queues(), 1);
+
+    TileScheduler::Tile tile;
+    ASSERT_TRUE(tiles->next(0, tile));
+    EXPECT_EQ(tile.x, 0);
+    EXPECT_EQ(tile.w, 64);
+    ASSERT_TRUE(tiles->next(0, tile));
+    EXPECT_EQ(tile.x, 64);
+    EXPECT_EQ(tile.w, 36);
+    EXPECT_EQ(tile.h, 64);
 }
 
 // テスト14: pull_next_block が順番にブロックを返す
 TEST_F(BlockUtilsTest, PullNextBlockReturnsBlocksInOrder) {
-    lua.new_usertype<AppData>("MockAppData",
+    auto mock_type = lua.new_usertype<AppData>("MockAppData",
         "set_string", &AppData::set_string,
         "get_string", &AppData::get_string,
         "pop_next_index", &AppData::pop_next_index
     );
+    bind_shared_store(lua, mock_type);
+    bind_tile_scheduler(lua, mock_type);
     
     AppData data(100, 100);
     lua["app_data"] = &data;
@@ -346,12 +354,12 @@ TEST_F(BlockUtilsTest, PullNextBlockReturnsBlocksInOrder) {
             {x = 0, y = 64, w = 64, h = 36}
         }
         
-        BlockUtils.setup_shared_queue(app_data, blocks, "queue", "queue_idx")
+        BlockUtils.setup_shared_queue(app_data, blocks, "queue")
         
         -- 順番にpull
-        block1 = BlockUtils.pull_next_block(app_data, "queue", "queue_idx")
-        block2 = BlockUtils.pull_next_block(app_data, "queue", "queue_idx")
-        block3 = BlockUtils.pull_next_block(app_data, "queue", "queue_idx")
+        block1 = BlockUtils.pull_next_block(app_data, "queue", 0)
+        block2 = BlockUtils.pull_next_block(app_data, "queue", 0)
+        block3 = BlockUtils.pull_next_block(app_data, "queue", 0)
     )");
     
     sol::table block1 = lua["block1"];
@@ -366,11 +374,13 @@ TEST_F(BlockUtilsTest, PullNextBlockReturnsBlocksInOrder) {
 
 // テスト15: pull_next_block がキュー末尾でnilを返す
 TEST_F(BlockUtilsTest, PullNextBlockReturnsNilWhenEmpty) {
-    lua.new_usertype<AppData>("MockAppData",
+    auto mock_type = lua.new_usertype<AppData>("MockAppData",
         "set_string", &AppData::set_string,
         "get_string", &AppData::get_string,
         "pop_next_index", &AppData::pop_next_index
     );
+    bind_shared_store(lua, mock_type);
+    bind_tile_scheduler(lua, mock_type);
     
     AppData data(100, 100);
     lua["app_data"] = &data;
@@ -382,12 +392,12 @@ TEST_F(BlockUtilsTest, PullNextBlockReturnsNilWhenEmpty) {
             {x = 0, y = 0, w = 64, h = 64}
         }
         
-        BlockUtils.setup_shared_queue(app_data, blocks, "queue2", "queue2_idx")
+        BlockUtils.setup_shared_queue(app_data, blocks, "queue2")
         
         -- 1つ目は取得できる
-        block1 = BlockUtils.pull_next_block(app_data, "queue2", "queue2_idx")
+        block1 = BlockUtils.pull_next_block(app_data, "queue2", 0)
         -- 2つ目はnil
-        block2 = BlockUtils.pull_next_block(app_data, "queue2", "queue2_idx")
+        block2 = BlockUtils.pull_next_block(app_data, "queue2", 0)
         
         is_block1_valid = block1 ~= nil
         is_block2_nil = block2 == nil
@@ -0,0 +1,100 @@
+// bytecode_cache_test.cpp
+// BytecodeCache（Luaモジュールのバイトコードキャッシュ）のテスト
+
+#include <gtest/gtest.h>
+#include <sol/sol.hpp>
+#include "../src/bytecode_cache.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+
+void write_module(const std::string& path, int value) {
+    std::ofstream file(path);
+    file << "return { value = " << value << " }\n";
+}
+
+// キャッシュ経由の require を持つステートを作成する
+void open_state(sol::state& lua) {
+    lua.open_libraries(sol::lib::base, sol::lib::package);
+    BytecodeCache::install_searcher(lua.lua_state());
+    lua.script("package.path = './?.lua;' .. package.path");
+}
+
+} // namespace
+
+class BytecodeCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        BytecodeCache::instance().invalidate();
+        write_module(path, 1);
+    }
+    void TearDown() override {
+        std::remove(path.c_str());
+        BytecodeCache::instance().invalidate();
+    }
+
+    std::string path = "bytecode_cache_test_module.lua";
+};
+
+// 2つ目のステートはコンパイルせずバイトコードから読み込む
+TEST_F(BytecodeCacheTest, SecondStateLoadsFromCache) {
+    auto& cache = BytecodeCache::instance();
+    size_t misses = cache.misses();
+    size_t hits = cache.hits();
+
+    sol::state first;
+    open_state(first);
+    EXPECT_EQ(first.script("return require('bytecode_cache_test_module').value").get<int>(), 1);
+    EXPECT_EQ(cache.misses(), misses + 1);
+
+    sol::state second;
+    open_state(second);
+    EXPECT_EQ(second.script("return require('bytecode_cache_test_module').value").get<int>(), 1);
+    EXPECT_EQ(cache.misses(), misses + 1);
+    EXPECT_EQ(cache.hits(), hits + 1);
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+// 更新時刻が変わったファイルはコンパイルし直す
+TEST_F(BytecodeCacheTest, ModifiedFileIsRecompiled) {
+    sol::state first;
+    open_state(first);
+    first.script("require('bytecode_cache_test_module')");
+
+    write_module(path, 2);
+    std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::seconds(2));
+
+    sol::state second;
+    open_state(second);
+    EXPECT_EQ(second.script("return require('bytecode_cache_test_module').value").get<int>(), 2);
+}
+
+// invalidate() 後は全エントリを破棄する
+TEST_F(BytecodeCacheTest, InvalidateClearsEntries) {
+    sol::state lua;
+    open_state(lua);
+    lua.script("require('bytecode_cache_test_module')");
+    EXPECT_EQ(BytecodeCache::instance().size(), 1u);
+
+    BytecodeCache::instance().invalidate();
+    EXPECT_EQ(BytecodeCache::instance().size(), 0u);
+}
+
+// 構文エラーは require のエラーとして報告され、見つからないモジュールは標準の検索関数に任せる
+TEST_F(BytecodeCacheTest, ErrorsAreReportedThroughRequire) {
+    {
+        std::ofstream file(path);
+        file << "return {";
+    }
+    sol::state lua;
+    open_state(lua);
+    auto broken = lua.safe_script("return require('bytecode_cache_test_module')", sol::script_pass_on_error);
+    EXPECT_FALSE(broken.valid());
+    auto missing = lua.safe_script("return require('bytecode_cache_no_such_module')", sol::script_pass_on_error);
+    ASSERT_FALSE(missing.valid());
+    EXPECT_NE(std::string(missing.get<sol::error>().what()).find("no field package.preload"), std::string::npos);
+}
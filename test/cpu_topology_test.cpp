@@ -0,0 +1,105 @@
+// cpu_topology_test.cpp
+// CpuTopology（/sys の読み取りとピン留め順）のテスト
+
+#include <gtest/gtest.h>
+#include "../src/cpu_topology.h"
+#include <cstdio>
+#include <fstream>
+#include <sys/stat.h>
+
+namespace {
+
+void make_dirs(const std::string& path) {
+    for (size_t pos = 1; (pos = path.find('/', pos)) != std::string::npos; ++pos) {
+        mkdir(path.substr(0, pos).c_str(), 0755);
+    }
+    mkdir(path.c_str(), 0755);
+}
+
+void write_file(const std::string& path, const std::string& text) {
+    make_dirs(path.substr(0, path.rfind('/')));
+    std::ofstream file(path);
+    file << text << "\n";
+}
+
+} // namespace
+
+// CPUリスト表記を展開できる
+TEST(CpuTopologyTest, ParseCpuList) {
+    EXPECT_EQ(CpuTopology::parse_cpu_list("0-3,8,10-11"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(CpuTopology::parse_cpu_list("5"), (std::vector<int>{5}));
+    EXPECT_TRUE(CpuTopology::parse_cpu_list("").empty());
+    EXPECT_TRUE(CpuTopology::parse_cpu_list("garbage").empty());
+}
+
+// 2ソケット・各2コア・SMT2 の構成では、物理コアを両ノード交互に埋めてからSMTの兄弟を使う
+TEST(CpuTopologyTest, PinOrderSpreadsCoresAcrossNodesBeforeSiblings) {
+    // 論理CPU 0-3 がノード0、4-7 がノード1。n と n+2 が同じ物理コアの兄弟
+    CpuTopology topology = CpuTopology::from_cpus({
+        {0, 0, 0}, {1, 1, 0}, {2, 0, 0}, {3, 1, 0},
+        {4, 65536, 1}, {5, 65537, 1}, {6, 65536, 1}, {7, 65537, 1},
+    });
+
+    EXPECT_EQ(topology.logical_count(), 8);
+    EXPECT_EQ(topology.physical_core_count(), 4);
+    EXPECT_EQ(topology.numa_node_count(), 2);
+    EXPECT_EQ(topology.pin_order(), (std::vector<int>{0, 4, 1, 5, 2, 6, 3, 7}));
+    EXPECT_EQ(topology.node_of(5), 1);
+}
+
+// sysfs のディレクトリ構成からトポロジを読み取れる
+TEST(CpuTopologyTest, DetectReadsSysfsTree) {
+    std::string root = testing::TempDir() + "cpu_topology_sysfs";
+    write_file(root + "/cpu/online", "0-3");
+    for (int cpu = 0; cpu < 4; ++cpu) {
+        std::string base = root + "/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        write_file(base + "physical_package_id", std::to_string(cpu / 2));
+        write_file(base + "core_id", "0");
+    }
+    write_file(root + "/node/node0/cpulist", "0-1");
+    write_file(root + "/node/node1/cpulist", "2-3");
+
+    // アフィニティマスクで絞り込まない
+    CpuTopology topology = CpuTopology::detect(root, {});
+    EXPECT_EQ(topology.logical_count(), 4);
+    EXPECT_EQ(topology.physical_core_count(), 2);
+    EXPECT_EQ(topology.numa_node_count(), 2);
+    EXPECT_EQ(topology.pin_order(), (std::vector<int>{0, 2, 1, 3}));
+}
+
+// アフィニティマスクで許可されたCPUだけを使う
+TEST(CpuTopologyTest, DetectRestrictsToAllowedCpus) {
+    std::string root = testing::TempDir() + "cpu_topology_affinity";
+    write_file(root + "/cpu/online", "0-3");
+    for (int cpu = 0; cpu < 4; ++cpu) {
+        std::string base = root + "/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        write_file(base + "physical_package_id", "0");
+        write_file(base + "core_id", std::to_string(cpu));
+    }
+
+    CpuTopology topology = CpuTopology::detect(root, {1, 3, 8});
+    EXPECT_EQ(topology.logical_count(), 2);
+    EXPECT_EQ(topology.pin_order(), (std::vector<int>{1, 3}));
+
+    // 共通部分が無いマスクは無視する
+    EXPECT_EQ(CpuTopology::detect(root, {8, 9}).logical_count(), 4);
+}
+
+// 現在のプロセスのアフィニティマスクは少なくとも1CPUを含み、既定の検出結果はその範囲に収まる
+TEST(CpuTopologyTest, DetectDefaultsToProcessAffinity) {
+    std::vector<int> allowed = CpuTopology::process_affinity();
+#if defined(__linux__)
+    ASSERT_FALSE(allowed.empty());
+#endif
+    if (allowed.empty()) return;
+    CpuTopology topology = CpuTopology::detect();
+    EXPECT_LE(topology.logical_count(), static_cast<int>(allowed.size()));
+}
+
+// sysfs が無い環境でも hardware_concurrency から少なくとも1CPUを返す
+TEST(CpuTopologyTest, DetectFallsBackWithoutSysfs) {
+    CpuTopology topology = CpuTopology::detect(testing::TempDir() + "cpu_topology_missing");
+    EXPECT_GE(topology.logical_count(), 1);
+    EXPECT_EQ(topology.numa_node_count(), 1);
+    EXPECT_EQ(static_cast<int>(topology.pin_order().size()), topology.logical_count());
+}
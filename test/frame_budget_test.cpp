@@ -0,0 +1,73 @@
+// テスト: FrameBudgetモジュール（シングルスレッド描画のフレーム予算）
+
+#include <gtest/gtest.h>
+#include "../src/lua_binding.h"
+#include <sol/sol.hpp>
+
+class FrameBudgetTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        AppContext ctx;
+        bind_lua(lua, ctx);
+        lua.script("package.path = package.path .. ';./lib/?.lua;../../?.lua'");
+    }
+
+    sol::state lua;
+};
+
+// 締め切りは begin_frame からの予算分で判定し、フレーム外では常に期限切れ
+TEST_F(FrameBudgetTest, ExpiresAfterBudget) {
+    auto result = lua.safe_script(R"(
+        local FrameBudget = require('lib.FrameBudget')
+        local now = 0
+        local budget = FrameBudget.new(12, function() return now end)
+
+        local outside = budget:expired()
+        budget:begin_frame()
+        now = 11 * 1000000
+        local before = budget:expired()
+        now = 12 * 1000000
+        local after = budget:expired()
+        budget:end_frame()
+        return outside, before, after
+    )");
+
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+    std::tuple<bool, bool, bool> res = result;
+    EXPECT_TRUE(std::get<0>(res));
+    EXPECT_FALSE(std::get<1>(res));
+    EXPECT_TRUE(std::get<2>(res));
+}
+
+// 予算は範囲内に丸められる
+TEST_F(FrameBudgetTest, ClampsBudget) {
+    auto result = lua.safe_script(R"(
+        local FrameBudget = require('lib.FrameBudget')
+        local budget = FrameBudget.new()
+        local default_ms = budget.budget_ms
+        budget:set_budget_ms(0)
+        local low = budget.budget_ms
+        budget:set_budget_ms(100000)
+        return default_ms, low, budget.budget_ms
+    )");
+
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+    std::tuple<int, int, int> res = result;
+    EXPECT_EQ(std::get<0>(res), 12);
+    EXPECT_EQ(std::get<1>(res), 1);
+    EXPECT_EQ(std::get<2>(res), 100);
+}
+
+// 高分解能クロックは単調増加する整数のナノ秒
+TEST_F(FrameBudgetTest, NativeClockIsMonotonicNanoseconds) {
+    auto result = lua.safe_script(R"(
+        local a = app.get_ticks_ns()
+        local b = app.get_ticks_ns()
+        return math.type(a), b >= a
+    )");
+
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+    std::tuple<std::string, bool> res = result;
+    EXPECT_EQ(std::get<0>(res), "integer");
+    EXPECT_TRUE(std::get<1>(res));
+}
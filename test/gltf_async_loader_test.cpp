@@ -0,0 +1,127 @@
+// gltf_async_loader_test.cpp
+// glTF の非同期読み込みとテクスチャの並列デコード（src/gltf_async_loader.h、AppData::load_gltf_async）のテスト
+
+#include <gtest/gtest.h>
+#include "../src/app_data.h"
+#include "../src/lua_binding.h"
+#include <sol/sol.hpp>
+#include <fstream>
+
+namespace {
+
+// 2x2 の PNG（左上が赤）を参照するテクスチャを count 個持つ glTF（画像はバッファビューに埋め込み）
+std::string write_textured_gltf(int count) {
+    std::string path = testing::TempDir() + "gltf_async_loader_test.gltf";
+    std::ofstream file(path);
+    file << R"({"asset": {"version": "2.0"},)"
+         << R"("buffers": [{"byteLength": 75, "uri": "data:application/octet-stream;base64,)"
+         << R"(iVBORw0KGgoAAAANSUhEUgAAAAIAAAACCAIAAAD91JpzAAAAEklEQVR4nGP4z8DAAMIM/4EAAB/uBfsL2WiLAAAAAElFTkSuQmCC"}],)"
+         << R"("bufferViews": [{"buffer": 0, "byteLength": 75}],)"
+         << R"("images": [{"bufferView": 0, "mimeType": "image/png"}],)"
+         << R"("textures": [)";
+    for (int i = 0; i < count; ++i) {
+        file << (i > 0 ? "," : "") << R"({"source": 0})";
+    }
+    file << "]}";
+    return path;
+}
+
+} // namespace
+
+// テクスチャをすべて並列にデコードし、番号どおりに結果を返す
+TEST(GltfAsyncLoaderTest, DecodesTexturesInParallel) {
+    GltfLoadJob job(write_textured_gltf(8), 4);
+    int completions = 0;
+    job.start([&](GltfLoadJob& loaded) {
+        ++completions;
+        EXPECT_TRUE(loaded.gltf());
+    });
+    ASSERT_TRUE(job.wait(10000));
+    EXPECT_EQ(job.status(), GltfLoadJob::Status::Done);
+    EXPECT_EQ(completions, 1);
+    EXPECT_EQ(job.textures_total(), 8u);
+    EXPECT_EQ(job.textures_decoded(), 8u);
+    ASSERT_EQ(job.textures().size(), 8u);
+    for (const auto& image : job.textures()) {
+        ASSERT_TRUE(image);
+        EXPECT_EQ(image->width, 2);
+        EXPECT_EQ(image->height, 2);
+        EXPECT_EQ(image->pixels[0], 255);
+        EXPECT_EQ(image->pixels[1], 0);
+    }
+}
+
+// 読み込んだ glTF とテクスチャを AppData のキャッシュに登録する
+TEST(GltfAsyncLoaderTest, RegistersResultsInAppData) {
+    AppData data(4, 4);
+    auto job = data.load_gltf_async("box", "assets/BoxTextured.glb");
+    ASSERT_TRUE(job->wait(10000));
+    EXPECT_EQ(job->status(), GltfLoadJob::Status::Done) << job->error();
+    EXPECT_EQ(job->textures_decoded(), 1u);
+
+    auto gltf = data.get_gltf("box");
+    ASSERT_TRUE(gltf);
+    EXPECT_EQ(gltf, job->gltf());
+    auto image = data.get_texture_image(AppData::texture_cache_name("box", 0));
+    ASSERT_TRUE(image);
+    EXPECT_GT(image->width, 0);
+    // 同じ名前の load_texture_image はキャッシュを使う
+    EXPECT_TRUE(data.load_texture_image("box_tex0", "box", 0));
+    EXPECT_EQ(data.get_texture_image("box_tex0"), image);
+
+    // ロード済みの名前は完了済みのジョブが返る
+    auto again = data.load_gltf_async("box", "assets/BoxTextured.glb");
+    EXPECT_TRUE(again->done());
+    EXPECT_EQ(again->gltf(), gltf);
+}
+
+// 読み込みに失敗した場合は理由を返し、キャッシュには何も登録しない
+TEST(GltfAsyncLoaderTest, FailureLeavesCacheEmpty) {
+    AppData data(4, 4);
+    auto job = data.load_gltf_async("missing", "nonexistent/file.glb");
+    ASSERT_TRUE(job->wait(10000));
+    EXPECT_EQ(job->status(), GltfLoadJob::Status::Failed);
+    EXPECT_NE(job->error().find("nonexistent/file.glb"), std::string::npos);
+    EXPECT_EQ(data.get_gltf("missing"), nullptr);
+}
+
+// 読み込み中に AppData を破棄しても、完了を待ってから解放される
+TEST(GltfAsyncLoaderTest, AppDataWaitsForPendingLoads) {
+    std::shared_ptr<GltfLoadJob> job;
+    {
+        AppData data(4, 4);
+        job = data.load_gltf_async("box", "assets/BoxTextured.glb");
+    }
+    EXPECT_TRUE(job->done());
+}
+
+class GltfAsyncLoaderLuaTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        AppContext ctx;
+        bind_lua(lua, ctx);
+    }
+
+    sol::state lua;
+};
+
+// Lua からハンドルで進捗と完了を参照できる
+TEST_F(GltfAsyncLoaderLuaTest, HandleReportsProgress) {
+    auto result = lua.safe_script(R"(
+        local data = AppData.new(4, 4)
+        local handle = data:load_gltf_async("box", "assets/BoxTextured.glb", 2)
+        local ok, err = handle:wait()
+        assert(ok and err == nil, err)
+        assert(handle:done() and handle:status() == "done")
+        local decoded, total = handle:progress()
+        assert(decoded == 1 and total == 1)
+        assert(data:get_gltf_mesh_count("box") == 1)
+        assert(data:get_texture_image("box_tex0"))
+
+        local bad = data:load_gltf_async("bad", "nonexistent/file.glb")
+        ok, err = bad:wait(10000)
+        assert(not ok and err:find("nonexistent", 1, true), err)
+        assert(bad:status() == "failed")
+    )");
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+}
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include "gltf_loader.h"
 #include "embree_wrapper.h"
+#include <cmath>
+#include <fstream>
 
 // =============================================================
 // テストリスト (TDD):
@@ -16,6 +18,9 @@
 // 10. [ ] BoxTextured.glb からテクスチャ画像を取得できる
 // 11. [ ] Box.glb（テクスチャなし）からは UV 座標が空
 // 12. [ ] intersect の戻り値にバリセントリック座標が含まれる
+// 13. [x] ノード階層を辿ってワールド変換付きのメッシュ配置を列挙できる
+// 14. [x] 共有メッシュはインスタンス、単独のメッシュは変換を焼き込んで全プリミティブを追加できる
+// 15. [x] Box.glb のノード階層をシーンに追加してレイが交差する
 // =============================================================
 
 // --- テスト1: assets/Box.glb をパースできる ---
@@ -160,3 +165,134 @@ TEST(GltfLoaderTest, NoTextureReturnsEmptyImage) {
     EXPECT_EQ(image.height, 0);
     EXPECT_TRUE(image.pixels.empty());
 }
+
+// 2ノードが共有するメッシュ0（プリミティブ2つ、インデックスあり・なし）と、1ノードだけのメッシュ1を持つ glTF
+// ノード: 0 = ルート（子 1, 2）、1 = メッシュ0 を y+10 に平行移動、2 = メッシュ0 を Y軸まわり90度回転して y-10、
+//         3 = メッシュ1 を2倍に拡大して z-5
+// 三角形: プリミティブ0 = (-1,-1,0) (1,-1,0) (0,1,0)、プリミティブ1 = (2,-1,0) (4,-1,0) (3,1,0)
+static std::string write_hierarchy_gltf() {
+    std::string path = testing::TempDir() + "gltf_hierarchy_test.gltf";
+    std::ofstream file(path);
+    file << R"({
+        "asset": {"version": "2.0"},
+        "scene": 0,
+        "scenes": [{"nodes": [0, 3]}],
+        "nodes": [
+            {"children": [1, 2]},
+            {"mesh": 0, "translation": [0, 10, 0]},
+            {"mesh": 0, "translation": [0, -10, 0], "rotation": [0, 0.70710678, 0, 0.70710678]},
+            {"mesh": 1, "translation": [0, 0, -5], "scale": [2, 2, 2]}
+        ],
+        "meshes": [
+            {"primitives": [{"attributes": {"POSITION": 0}, "indices": 2}, {"attributes": {"POSITION": 1}}]},
+            {"primitives": [{"attributes": {"POSITION": 0}, "indices": 2}]}
+        ],
+        "accessors": [
+            {"bufferView": 0, "byteOffset": 0, "componentType": 5126, "count": 3, "type": "VEC3", "min": [-1, -1, 0], "max": [1, 1, 0]},
+            {"bufferView": 0, "byteOffset": 36, "componentType": 5126, "count": 3, "type": "VEC3", "min": [2, -1, 0], "max": [4, 1, 0]},
+            {"bufferView": 1, "componentType": 5123, "count": 3, "type": "SCALAR"}
+        ],
+        "bufferViews": [
+            {"buffer": 0, "byteOffset": 0, "byteLength": 72},
+            {"buffer": 0, "byteOffset": 72, "byteLength": 6}
+        ],
+        "buffers": [{"byteLength": 78, "uri": "data:application/octet-stream;base64,AACAvwAAgL8AAAAAAACAPwAAgL8AAAAAAAAAAAAAgD8AAAAAAAAAQAAAgL8AAAAAAACAQAAAgL8AAAAAAABAQAAAgD8AAAAAAAABAAIA"}]
+    })";
+    return path;
+}
+
+// --- テスト13: ノード階層を辿ってワールド変換付きのメッシュ配置を列挙できる ---
+TEST(GltfLoaderTest, EnumeratesMeshInstancesWithWorldTransforms) {
+    GltfData data;
+    ASSERT_TRUE(data.load(write_hierarchy_gltf()));
+    EXPECT_EQ(data.getMeshCount(), 2u);
+    EXPECT_EQ(data.getPrimitiveCount(0), 2u);
+    EXPECT_EQ(data.getPrimitiveCount(1), 1u);
+
+    auto instances = data.getMeshInstances();
+    ASSERT_EQ(instances.size(), 3u);
+    // ルートから深さ優先の順
+    EXPECT_EQ(instances[0].node, 1u);
+    EXPECT_EQ(instances[0].mesh, 0u);
+    EXPECT_FLOAT_EQ(instances[0].world[13], 10.0f);
+    EXPECT_EQ(instances[1].node, 2u);
+    EXPECT_FLOAT_EQ(instances[1].world[13], -10.0f);
+    EXPECT_EQ(instances[2].node, 3u);
+    EXPECT_EQ(instances[2].mesh, 1u);
+    EXPECT_FLOAT_EQ(instances[2].world[0], 2.0f);
+    EXPECT_FLOAT_EQ(instances[2].world[14], -5.0f);
+}
+
+// --- テスト14: 共有メッシュはインスタンス、単独のメッシュは変換を焼き込んで全プリミティブを追加できる ---
+TEST(GltfLoaderTest, InstantiatesHierarchyWithInstances) {
+    GltfData data;
+    ASSERT_TRUE(data.load(write_hierarchy_gltf()));
+
+    EmbreeDevice device;
+    EmbreeScene scene(device);
+    auto geometries = data.instantiate(scene);
+    scene.commit();
+
+    // メッシュ0 × 2ノード × 2プリミティブ + メッシュ1
+    ASSERT_EQ(geometries.size(), 5u);
+    auto find = [&](size_t node, size_t primitive) -> const GltfGeometry* {
+        for (const auto& geometry : geometries) {
+            if (geometry.node == node && geometry.primitive == primitive) return &geometry;
+        }
+        return nullptr;
+    };
+    const GltfGeometry* moved = find(1, 0);
+    const GltfGeometry* moved_second = find(1, 1);
+    const GltfGeometry* rotated = find(2, 0);
+    const GltfGeometry* scaled = find(3, 0);
+    ASSERT_TRUE(moved && moved_second && rotated && scaled);
+    EXPECT_TRUE(moved->instanced);
+    EXPECT_TRUE(rotated->instanced);
+    EXPECT_FALSE(scaled->instanced);
+    EXPECT_EQ(scaled->mesh, 1u);
+    EXPECT_EQ(scaled->material, -1);
+
+    // 平行移動したインスタンス（geomID はインスタンスのもの）
+    auto [hit, t, nx, ny, nz, geomID, primID, baryU, baryV] = scene.intersect(0.0f, 10.0f, 5.0f, 0.0f, 0.0f, -1.0f);
+    EXPECT_TRUE(hit);
+    EXPECT_NEAR(t, 5.0f, 1e-4f);
+    EXPECT_EQ(geomID, moved->geomID);
+    EXPECT_EQ(primID, 0u);
+    EXPECT_NEAR(std::fabs(nz), 1.0f, 1e-4f);
+
+    // インデックスのないプリミティブ
+    auto second = scene.intersect(3.0f, 10.0f, 5.0f, 0.0f, 0.0f, -1.0f);
+    EXPECT_TRUE(std::get<0>(second));
+    EXPECT_EQ(std::get<5>(second), moved_second->geomID);
+
+    // 回転したインスタンス: 法線はワールド空間（X軸向き）で返る
+    auto [rhit, rt, rnx, rny, rnz, rgeomID, rprimID, ru, rv] = scene.intersect(5.0f, -10.0f, 0.0f, -1.0f, 0.0f, 0.0f);
+    EXPECT_TRUE(rhit);
+    EXPECT_NEAR(rt, 5.0f, 1e-4f);
+    EXPECT_EQ(rgeomID, rotated->geomID);
+    EXPECT_NEAR(std::fabs(rnx), 1.0f, 1e-4f);
+    EXPECT_NEAR(rnz, 0.0f, 1e-4f);
+
+    // 焼き込んだ拡大: 元の大きさでは外れる位置に当たる
+    auto [shit, st, snx, sny, snz, sgeomID, sprimID, su, sv] = scene.intersect(1.5f, -1.5f, 5.0f, 0.0f, 0.0f, -1.0f);
+    EXPECT_TRUE(shit);
+    EXPECT_NEAR(st, 10.0f, 1e-4f);
+    EXPECT_EQ(sgeomID, scaled->geomID);
+}
+
+// --- テスト15: Box.glb のノード階層をシーンに追加してレイが交差する ---
+TEST(GltfLoaderTest, InstantiatesBoxGlb) {
+    GltfData data;
+    ASSERT_TRUE(data.load("assets/Box.glb"));
+
+    EmbreeDevice device;
+    EmbreeScene scene(device);
+    auto geometries = data.instantiate(scene);
+    scene.commit();
+
+    ASSERT_EQ(geometries.size(), 1u);
+    EXPECT_FALSE(geometries[0].instanced);
+    auto [hit, t, nx, ny, nz, geomID, primID, baryU, baryV] = scene.intersect(0.0f, 0.0f, 5.0f, 0.0f, 0.0f, -1.0f);
+    EXPECT_TRUE(hit);
+    EXPECT_EQ(geomID, geometries[0].geomID);
+}
@@ -0,0 +1,126 @@
+// image_writer_test.cpp
+// ImageWriter（バックグラウンド画像書き出し）のテスト
+
+#include <gtest/gtest.h>
+#include "../src/image_writer.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+float read_f32(const std::string& bytes, size_t offset) {
+    float f;
+    std::memcpy(&f, bytes.data() + offset, sizeof(f));
+    return f;
+}
+
+// 2x2 画像: 上段 赤・緑、下段 青・白
+std::vector<uint32_t> make_pixels() {
+    return {0xFF0000FF, 0xFF00FF00, 0xFFFF0000, 0xFFFFFFFF};
+}
+
+} // namespace
+
+class ImageWriterTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        for (const auto& path : paths) {
+            std::remove(path.c_str());
+        }
+    }
+
+    std::string temp_path(const std::string& name) {
+        std::string path = testing::TempDir() + name;
+        paths.push_back(path);
+        return path;
+    }
+
+    std::vector<std::string> paths;
+};
+
+TEST_F(ImageWriterTest, ParseFormatFromNameOrExtension) {
+    ImageWriter::Format format;
+    ASSERT_TRUE(ImageWriter::parse_format("exr", "out.png", format));
+    EXPECT_EQ(format, ImageWriter::Format::EXR);
+    ASSERT_TRUE(ImageWriter::parse_format("", "dir/out.PNG", format));
+    EXPECT_EQ(format, ImageWriter::Format::PNG);
+    EXPECT_FALSE(ImageWriter::parse_format("", "out", format));
+    EXPECT_FALSE(ImageWriter::parse_format("bmp", "out.bmp", format));
+}
+
+// PFM は下の行から格納される
+TEST_F(ImageWriterTest, WritePfmStoresRowsBottomUp) {
+    std::string path = temp_path("image_writer_test.pfm");
+    std::string error;
+    ASSERT_TRUE(ImageWriter::write_pfm(path, 2, 2, make_pixels(), error)) << error;
+
+    std::string bytes = read_file(path);
+    const std::string header = "PF\n2 2\n-1.0\n";
+    ASSERT_EQ(bytes.size(), header.size() + 2 * 2 * 3 * 4);
+    EXPECT_EQ(bytes.substr(0, header.size()), header);
+
+    // 最初の画素は下段左の青
+    EXPECT_FLOAT_EQ(read_f32(bytes, header.size() + 0), 0.0f);
+    EXPECT_FLOAT_EQ(read_f32(bytes, header.size() + 8), 1.0f);
+}
+
+TEST_F(ImageWriterTest, WriteExrProducesScanlineFile) {
+    std::string path = temp_path("image_writer_test.exr");
+    std::string error;
+    ASSERT_TRUE(ImageWriter::write_exr(path, 2, 2, make_pixels(), error)) << error;
+
+    std::string bytes = read_file(path);
+    ASSERT_GE(bytes.size(), 8u);
+    EXPECT_EQ(static_cast<unsigned char>(bytes[0]), 0x76);
+    EXPECT_EQ(static_cast<unsigned char>(bytes[1]), 0x2f);
+    EXPECT_EQ(static_cast<unsigned char>(bytes[2]), 0x31);
+    EXPECT_EQ(static_cast<unsigned char>(bytes[3]), 0x01);
+
+    // 末尾の行ブロック: y=1, サイズ, B行, G行, R行（下段右の白は全チャンネル1.0）
+    size_t last_block = bytes.size() - (8 + 2 * 3 * 4);
+    EXPECT_FLOAT_EQ(read_f32(bytes, last_block + 8), 1.0f);  // B: 下段左の青
+    EXPECT_FLOAT_EQ(read_f32(bytes, last_block + 16), 0.0f); // G: 下段左の青
+    EXPECT_FLOAT_EQ(read_f32(bytes, last_block + 28), 1.0f); // R: 下段右の白
+}
+
+TEST_F(ImageWriterTest, RejectsMismatchedPixelCount) {
+    std::string error;
+    EXPECT_FALSE(ImageWriter::write_pfm(temp_path("bad.pfm"), 4, 4, make_pixels(), error));
+    EXPECT_FALSE(error.empty());
+}
+
+// 非同期ジョブは依頼元ごとに完了結果を返す
+TEST_F(ImageWriterTest, SubmitCompletesPerOwner) {
+    ImageWriter writer;
+    int owner_a = 0;
+    int owner_b = 0;
+
+    uint64_t id_a = writer.submit(&owner_a, temp_path("async_a.png"), ImageWriter::Format::PNG, 2, 2, make_pixels());
+    uint64_t id_b = writer.submit(&owner_b, temp_path("async_b.pfm"), ImageWriter::Format::PFM, 2, 2, make_pixels());
+    EXPECT_NE(id_a, id_b);
+
+    writer.wait_idle();
+    EXPECT_EQ(writer.pending(), 0u);
+
+    auto results_a = writer.take_completed(&owner_a);
+    ASSERT_EQ(results_a.size(), 1u);
+    EXPECT_EQ(results_a[0].id, id_a);
+    EXPECT_TRUE(results_a[0].success) << results_a[0].error;
+    EXPECT_FALSE(read_file(results_a[0].path).empty());
+
+    auto results_b = writer.take_completed(&owner_b);
+    ASSERT_EQ(results_b.size(), 1u);
+    EXPECT_EQ(results_b[0].id, id_b);
+
+    // 回収済みの結果は再度返されない
+    EXPECT_TRUE(writer.take_completed(&owner_a).empty());
+}
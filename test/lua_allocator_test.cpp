@@ -0,0 +1,92 @@
+// lua_allocator_test.cpp
+// LuaPoolAllocator（ワーカー用のプールアロケータ）のテスト
+
+#include <gtest/gtest.h>
+#include <sol/sol.hpp>
+#include "../src/lua_allocator.h"
+#include <cstring>
+
+// 小さなブロックは解放後に同じサイズクラスで再利用される
+TEST(LuaPoolAllocatorTest, ReusesFreedSmallBlocks) {
+    LuaPoolAllocator allocator;
+    void* a = LuaPoolAllocator::alloc(&allocator, nullptr, 5, 40);
+    ASSERT_NE(a, nullptr);
+    LuaPoolAllocator::alloc(&allocator, a, 40, 0);
+    void* b = LuaPoolAllocator::alloc(&allocator, nullptr, 5, 48);
+    EXPECT_EQ(a, b);
+
+    auto stats = allocator.stats();
+    EXPECT_EQ(stats.allocations, 2u);
+    EXPECT_EQ(stats.frees, 1u);
+    EXPECT_EQ(stats.pooled, 2u);
+    EXPECT_EQ(stats.bytes_in_use, 48u);
+    EXPECT_EQ(stats.arena_bytes, LuaPoolAllocator::CHUNK_SIZE);
+    LuaPoolAllocator::alloc(&allocator, b, 48, 0);
+}
+
+// サイズクラスをまたぐ realloc と大きなブロックでも内容が保たれる
+TEST(LuaPoolAllocatorTest, ReallocPreservesContents) {
+    LuaPoolAllocator allocator;
+    char* p = static_cast<char*>(LuaPoolAllocator::alloc(&allocator, nullptr, 0, 16));
+    std::memcpy(p, "lua-ray-allocator", 16);
+    p = static_cast<char*>(LuaPoolAllocator::alloc(&allocator, p, 16, 200));
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(std::memcmp(p, "lua-ray-allocator", 16), 0);
+    p = static_cast<char*>(LuaPoolAllocator::alloc(&allocator, p, 200, 4096));
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(std::memcmp(p, "lua-ray-allocator", 16), 0);
+    p = static_cast<char*>(LuaPoolAllocator::alloc(&allocator, p, 4096, 24));
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(std::memcmp(p, "lua-ray-allocator", 16), 0);
+    EXPECT_EQ(allocator.stats().bytes_in_use, 24u);
+    EXPECT_EQ(allocator.stats().peak_bytes, 4096u);
+
+    LuaPoolAllocator::alloc(&allocator, p, 24, 0);
+    EXPECT_EQ(allocator.stats().bytes_in_use, 0u);
+}
+
+// 使用中のブロックがある間はアリーナを返さない
+TEST(LuaPoolAllocatorTest, TrimOnlyWhenEmpty) {
+    LuaPoolAllocator allocator;
+    void* p = LuaPoolAllocator::alloc(&allocator, nullptr, 0, 64);
+    EXPECT_FALSE(allocator.trim());
+    EXPECT_GT(allocator.stats().arena_bytes, 0u);
+
+    LuaPoolAllocator::alloc(&allocator, p, 64, 0);
+    EXPECT_TRUE(allocator.trim());
+    EXPECT_EQ(allocator.stats().arena_bytes, 0u);
+}
+
+// Lua State のアロケータとして使え、State を閉じると全ブロックが返る
+TEST(LuaPoolAllocatorTest, BacksLuaState) {
+    LuaPoolAllocator allocator;
+    {
+        sol::state lua(sol::default_at_panic, &LuaPoolAllocator::alloc, &allocator);
+        lua.open_libraries(sol::lib::base, sol::lib::table, sol::lib::string);
+        auto result = lua.safe_script(R"(
+            local items = {}
+            for i = 1, 10000 do
+                items[i] = { x = i, y = i * 2, name = "item" .. i }
+            end
+            items = nil
+            collectgarbage()
+            local sum = 0
+            for i = 1, 1000 do
+                local t = { value = i }
+                sum = sum + t.value
+            end
+            return sum
+        )");
+        ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+        EXPECT_EQ(result.get<int>(), 500500);
+
+        auto stats = allocator.stats();
+        EXPECT_GT(stats.allocations, 10000u);
+        EXPECT_GT(stats.frees, 0u);
+        EXPECT_GT(stats.bytes_in_use, 0u);
+        EXPECT_GE(stats.peak_bytes, stats.bytes_in_use);
+    }
+    auto stats = allocator.stats();
+    EXPECT_EQ(stats.bytes_in_use, 0u);
+    EXPECT_TRUE(allocator.trim());
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "../src/lua_binding.h"
+#include "../src/image_writer.h"
+#include <cstdio>
 #include <sol/sol.hpp>
 
 class LuaBindingTest : public ::testing::Test {
@@ -51,6 +53,31 @@ TEST_F(LuaBindingTest, EmbreeSceneOperations) {
     ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
 }
 
+// glTF のノード階層を1回の呼び出しでシーンに追加し、ジオメトリの一覧を app_data から参照できる
+TEST_F(LuaBindingTest, InstantiateGltf) {
+    auto result = lua.safe_script(R"(
+        local device = EmbreeDevice.new()
+        local scene = device:create_scene()
+        local data = AppData.new(4, 4)
+        assert(data:instantiate_gltf(scene, "box") == nil)
+        assert(#data:get_gltf_geometries("box") == 0)
+
+        assert(data:load_gltf("box", "assets/BoxTextured.glb"))
+        assert(data:get_gltf_primitive_count("box", 0) == 1)
+        local geometries = data:instantiate_gltf(scene, "box")
+        assert(#geometries == 1)
+        local geometry = geometries[1]
+        assert(geometry.mesh == 0 and geometry.primitive == 0 and geometry.instanced == false)
+        assert(geometry.material == 0 and geometry.texture == 0)
+        assert(data:get_gltf_geometries("box")[1].geom_id == geometry.geom_id)
+
+        scene:commit()
+        local hit, t, nx, ny, nz, g_id = scene:intersect(0, 0, 5, 0, 0, -1)
+        assert(hit and g_id == geometry.geom_id)
+    )");
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+}
+
 TEST_F(LuaBindingTest, AddTriangle) {
     auto result = lua.safe_script(R"(
         local device = EmbreeDevice.new()
@@ -148,3 +175,72 @@ TEST_F(LuaBindingTest, ClearBackBufferFromLua) {
     )");
     ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
 }
+
+TEST_F(LuaBindingTest, SharedStoreRoundTripFromLua) {
+    auto result = lua.safe_script(R"(
+        local data = AppData.new(10, 10)
+
+        data:store_number("exposure", 1.5)
+        data:store_floats("weights", {0.25, 0.5, 0.75})
+        data:store_ints("ids", {3, 1, 4})
+        data:store_blob("raw", "AB")
+
+        assert(data:store_get("exposure") == 1.5)
+        assert(data:store_get("missing") == nil)
+
+        local weights = data:store_get("weights")
+        assert(weights:type() == "floats")
+        assert(#weights == 3)
+        assert(weights[2] == 0.5)
+        assert(weights[4] == nil)
+
+        -- スロット番号でも取得できる
+        local ids = data:store_get(data:store_slot("ids"))
+        assert(ids:type() == "ints")
+        assert(ids:get(3) == 4)
+        assert(math.type(ids[1]) == "integer")
+
+        local raw = data:store_get("raw")
+        assert(raw:to_string() == "AB")
+        assert(raw[1] == 65)
+
+        -- 取得済みのビューは上書き後も元のスナップショットを参照し続ける
+        data:store_floats("weights", {9})
+        assert(#weights == 3)
+        assert(#data:store_get("weights") == 1)
+
+        data:store_remove("weights")
+        assert(data:store_get("weights") == nil)
+    )");
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+}
+
+TEST_F(LuaBindingTest, SaveAsyncInvokesCallbackFromPoll) {
+    std::string path = testing::TempDir() + "lua_binding_save_async.pfm";
+    lua["save_path"] = path;
+
+    auto submit = lua.safe_script(R"(
+        local data = AppData.new(4, 4)
+        saved = nil
+        local id, err = data:save_async(save_path, nil, function(success, saved_path, error_message)
+            saved = { success = success, path = saved_path }
+        end)
+        assert(id, err)
+
+        -- 未対応の形式はエラーを返す
+        local bad_id, bad_err = data:save_async("out.bmp")
+        assert(bad_id == nil and bad_err ~= nil)
+    )");
+    ASSERT_TRUE(submit.valid()) << ((sol::error)submit).what();
+
+    ImageWriter::instance().wait_idle();
+
+    auto poll = lua.safe_script(R"(
+        app.poll_saves()
+        assert(saved ~= nil)
+        assert(saved.success == true)
+        assert(saved.path == save_path)
+    )");
+    ASSERT_TRUE(poll.valid()) << ((sol::error)poll).what();
+    std::remove(path.c_str());
+}
@@ -0,0 +1,80 @@
+// lua_gc_test.cpp
+// Lua State のGC設定と統計（src/lua_gc.h）のテスト
+
+#include <gtest/gtest.h>
+#include <sol/sol.hpp>
+#include "../src/lua_gc.h"
+#include <string>
+
+class LuaGcTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        lua.open_libraries(sol::lib::base);
+    }
+
+    sol::state lua;
+};
+
+TEST_F(LuaGcTest, ParsesModeNames) {
+    LuaGcSettings::Mode mode = LuaGcSettings::Mode::Incremental;
+    EXPECT_TRUE(LuaGcSettings::parse_mode("generational", mode));
+    EXPECT_EQ(mode, LuaGcSettings::Mode::Generational);
+    EXPECT_TRUE(LuaGcSettings::parse_mode("incremental", mode));
+    EXPECT_EQ(mode, LuaGcSettings::Mode::Incremental);
+    EXPECT_FALSE(LuaGcSettings::parse_mode("manual", mode));
+    EXPECT_STREQ(LuaGcSettings::mode_name(LuaGcSettings::Mode::Generational), "generational");
+}
+
+// 設定したモードは collectgarbage からも確認できる（切り替え時に直前のモードを返す）
+TEST_F(LuaGcTest, AppliesMode) {
+    LuaGcSettings settings;
+    settings.mode = LuaGcSettings::Mode::Generational;
+    apply_gc_settings(lua.lua_state(), settings);
+    std::string previous = lua.safe_script("return collectgarbage('incremental')").get<std::string>();
+    EXPECT_EQ(previous, "generational");
+
+    settings.mode = LuaGcSettings::Mode::Incremental;
+    settings.pause = 150;
+    apply_gc_settings(lua.lua_state(), settings);
+    previous = lua.safe_script("return collectgarbage('incremental')").get<std::string>();
+    EXPECT_EQ(previous, "incremental");
+}
+
+// 番兵のファイナライザで完了したGCサイクルを数える
+TEST_F(LuaGcTest, CountsCollections) {
+    LuaGcStats stats;
+    install_gc_counter(lua.lua_state(), &stats);
+    EXPECT_EQ(stats.collections.load(), 0u);
+
+    lua.safe_script("collectgarbage(); collectgarbage(); collectgarbage()");
+    EXPECT_GE(stats.collections.load(), 2u);
+
+    stats.reset();
+    EXPECT_EQ(stats.collections.load(), 0u);
+    lua.safe_script("collectgarbage()");
+    EXPECT_GE(stats.collections.load(), 1u);
+}
+
+// 自動GCを止めていても、タイル境界のステップでゴミが回収され、回数と時間が記録される
+TEST_F(LuaGcTest, TileStepsCollectWhileStopped) {
+    lua_State* L = lua.lua_state();
+    LuaGcStats stats;
+    install_gc_counter(L, &stats);
+    lua_gc(L, LUA_GCSTOP);
+    int last_kb = lua_gc(L, LUA_GCCOUNT);
+
+    int peak_kb = 0;
+    for (int tile = 0; tile < 50; ++tile) {
+        lua.safe_script("for i = 1, 2000 do local t = { i, i * 2, tostring(i) } end");
+        step_gc(L, 64, last_kb, stats);
+        int kb = lua_gc(L, LUA_GCCOUNT);
+        if (kb > peak_kb) peak_kb = kb;
+    }
+    lua_gc(L, LUA_GCRESTART);
+
+    EXPECT_EQ(stats.steps.load(), 50u);
+    EXPECT_GT(stats.step_ns.load(), 0u);
+    EXPECT_GE(stats.collections.load(), 1u);
+    // 1タイルあたり数百KBのゴミが出るが、ヒープは蓄積しない
+    EXPECT_LT(peak_kb, 4096);
+}
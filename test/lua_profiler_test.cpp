@@ -0,0 +1,156 @@
+// lua_profiler_test.cpp
+// サンプリングプロファイラ（src/lua_profiler.h）と集計モジュール（lib/Profiler.lua）のテスト
+
+#include <gtest/gtest.h>
+#include "../src/lua_profiler.h"
+#include "../src/lua_binding.h"
+#include <sol/sol.hpp>
+#include <string>
+
+namespace {
+
+// 折りたたみスタックのうち needle を含むもののサンプル数
+uint64_t samples_containing(const LuaProfiler::Stacks& stacks, const std::string& needle) {
+    uint64_t samples = 0;
+    for (const auto& [stack, entry] : stacks) {
+        if (stack.find(needle) != std::string::npos) {
+            samples += entry.samples;
+        }
+    }
+    return samples;
+}
+
+} // namespace
+
+class LuaProfilerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        lua.open_libraries(sol::lib::base, sol::lib::coroutine);
+        lua.safe_script(R"(
+            local function inner()
+                local s = 0
+                for i = 1, 200000 do
+                    s = s + i
+                end
+                return s
+            end
+            function outer()
+                return inner() + 1
+            end
+        )");
+    }
+
+    sol::state lua;
+};
+
+// 根から葉の順に ';' で連結したスタックを記録し、停止後はフックを外す
+TEST_F(LuaProfilerTest, RecordsFoldedStacks) {
+    LuaProfiler profiler;
+    profiler.start(lua.lua_state(), 100);
+    auto result = lua.safe_script("outer()");
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+    profiler.stop(lua.lua_state());
+    EXPECT_EQ(lua_gethook(lua.lua_state()), nullptr);
+
+    auto stacks = profiler.take();
+    ASSERT_FALSE(stacks.empty());
+    EXPECT_GT(samples_containing(stacks, "outer@"), 0u);
+    bool nested = false;
+    for (const auto& [stack, entry] : stacks) {
+        size_t outer = stack.find("outer@");
+        size_t inner = stack.find("inner@");
+        if (outer != std::string::npos && inner != std::string::npos) {
+            EXPECT_LT(outer, inner);
+            EXPECT_GT(entry.ns, 0u);
+            nested = true;
+        }
+    }
+    EXPECT_TRUE(nested);
+
+    // 取り出した集計は空になり、停止後は記録されない
+    EXPECT_TRUE(profiler.take().empty());
+    lua.safe_script("outer()");
+    EXPECT_TRUE(profiler.take().empty());
+}
+
+// 計測中に作られたコルーチンもフックを引き継ぐ
+TEST_F(LuaProfilerTest, SamplesCoroutines) {
+    LuaProfiler profiler;
+    profiler.start(lua.lua_state(), 100);
+    auto result = lua.safe_script(R"(
+        local co = coroutine.wrap(function()
+            outer()
+        end)
+        co()
+    )");
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+    profiler.stop(lua.lua_state());
+    EXPECT_GT(samples_containing(profiler.take(), "inner@"), 0u);
+}
+
+class ProfilerModuleTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        AppContext ctx;
+        bind_lua(lua, ctx);
+        lua.script("package.path = package.path .. ';./lib/?.lua;../../?.lua'");
+    }
+
+    sol::state lua;
+};
+
+// 集計の結合、折りたたみスタック（重みはマイクロ秒）とレポート
+TEST_F(ProfilerModuleTest, MergesAndFormats) {
+    auto result = lua.safe_script(R"(
+        local Profiler = require('lib.Profiler')
+        local merged = {}
+        Profiler.merge(merged, {
+            ["shade@a.lua:1;scatter@b.lua:2"] = { samples = 3, ns = 3000000 },
+            ["shade@a.lua:1"] = { samples = 1, ns = 500 },
+        }, "worker")
+        Profiler.merge(merged, {
+            ["shade@a.lua:1;scatter@b.lua:2"] = { samples = 2, ns = 2000000 },
+        }, "worker")
+
+        local entry = merged["worker;shade@a.lua:1;scatter@b.lua:2"]
+        assert(entry.samples == 5 and entry.ns == 5000000)
+
+        local folded = Profiler.folded(merged)
+        assert(folded == "worker;shade@a.lua:1 1\nworker;shade@a.lua:1;scatter@b.lua:2 5000\n", folded)
+
+        local report = Profiler.report(merged)
+        assert(report:find("6 samples", 1, true), report)
+        -- 自己時間の先頭は葉の scatter
+        local self_section = report:match("self:\n([^\n]*)")
+        assert(self_section:find("scatter@b.lua:2", 1, true), report)
+        assert(Profiler.is_empty({}) and not Profiler.is_empty(merged))
+    )");
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+}
+
+// メインステートのプロファイラを app から切り替え、集計を取り出せる
+TEST_F(ProfilerModuleTest, ProfilesMainState) {
+    auto result = lua.safe_script(R"(
+        local Profiler = require('lib.Profiler')
+        app.take_profile()
+        app.set_profiling(100)
+        local function busy()
+            local s = 0
+            for i = 1, 200000 do
+                s = s + i
+            end
+            return s
+        end
+        busy()
+        app.set_profiling(0)
+        local merged = Profiler.merge({}, app.take_profile(), "main")
+        local found = false
+        for stack, entry in pairs(merged) do
+            if stack:find("^main;") and stack:find("busy@", 1, true) then
+                found = entry.samples > 0
+            end
+        end
+        assert(found, Profiler.folded(merged))
+    )");
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+}
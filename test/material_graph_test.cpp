@@ -0,0 +1,225 @@
+// material_graph_test.cpp
+// ネイティブのマテリアルグラフ（src/material_graph.h）と Lua からのコンパイル・評価のテスト
+
+#include <gtest/gtest.h>
+#include "../src/material_graph.h"
+#include "../src/lua_binding.h"
+#include <sol/sol.hpp>
+#include <cmath>
+
+namespace {
+
+using Node = MaterialProgram::Node;
+
+Node constant(float r, float g, float b) {
+    Node node;
+    node.op = "constant";
+    node.value[0] = r;
+    node.value[1] = g;
+    node.value[2] = b;
+    return node;
+}
+
+Node op(const char* name, std::vector<int> inputs) {
+    Node node;
+    node.op = name;
+    node.inputs = std::move(inputs);
+    return node;
+}
+
+std::shared_ptr<MaterialProgram> compile(const std::vector<Node>& nodes, int output, std::string& error,
+                                         MaterialProgram::TextureLookup lookup = nullptr) {
+    return MaterialProgram::compile(nodes, output, lookup, error);
+}
+
+// 法線 +Z、視線 +Z の入力（光源方向は引数）
+ShadingInput facing_input(float lx, float ly, float lz) {
+    float len = std::sqrt(lx * lx + ly * ly + lz * lz);
+    return ShadingInput{0, 0, 1, 0, 0, 1, lx / len, ly / len, lz / len, 0, 0};
+}
+
+} // namespace
+
+// Lambert は albedo × n·l、背面からの光は 0
+TEST(MaterialGraphTest, LambertScalesAlbedoByCosine) {
+    std::string error;
+    auto program = compile({constant(0.5f, 0.25f, 1.0f), op("lambert", {0})}, 1, error);
+    ASSERT_TRUE(program) << error;
+    EXPECT_EQ(program->instruction_count(), 2u);
+
+    float r, g, b;
+    program->evaluate(facing_input(0, 1, 1), r, g, b);
+    EXPECT_NEAR(r, 0.5f * std::sqrt(0.5f), 1e-5f);
+    EXPECT_NEAR(g, 0.25f * std::sqrt(0.5f), 1e-5f);
+    EXPECT_NEAR(b, 1.0f * std::sqrt(0.5f), 1e-5f);
+
+    program->evaluate(facing_input(0, 0, -1), r, g, b);
+    EXPECT_FLOAT_EQ(r, 0.0f);
+}
+
+// mix は t（R 成分）で線形補間し、add / mul は成分ごと
+TEST(MaterialGraphTest, MixAddMul) {
+    std::string error;
+    auto program = compile({
+        constant(0, 0, 0),
+        constant(1, 2, 4),
+        constant(0.25f, 0.9f, 0.9f),
+        op("mix", {0, 1, 2}),
+        op("mul", {3, 1}),
+        op("add", {4, 2}),
+    }, 5, error);
+    ASSERT_TRUE(program) << error;
+    float r, g, b;
+    program->evaluate(facing_input(0, 0, 1), r, g, b);
+    EXPECT_FLOAT_EQ(r, 0.25f * 1 * 1 + 0.25f);
+    EXPECT_FLOAT_EQ(g, 0.5f * 2 + 0.9f);
+    EXPECT_FLOAT_EQ(b, 1.0f * 4 + 0.9f);
+}
+
+// Fresnel は正面で f0、すれすれの角度で 1 に近づく
+TEST(MaterialGraphTest, FresnelFollowsSchlick) {
+    std::string error;
+    auto program = compile({constant(0.04f, 0.04f, 0.04f), op("fresnel", {0})}, 1, error);
+    ASSERT_TRUE(program) << error;
+    float r, g, b;
+    program->evaluate(facing_input(0, 0, 1), r, g, b);
+    EXPECT_NEAR(r, 0.04f, 1e-6f);
+
+    ShadingInput grazing{0, 0, 1, 0, std::sqrt(1.0f - 0.01f * 0.01f), 0.01f, 0, 0, 1, 0, 0};
+    program->evaluate(grazing, r, g, b);
+    EXPECT_GT(r, 0.9f);
+}
+
+// GGX: 鏡面反射方向で最大、粗いほどピークが低く、光源が裏側なら 0
+TEST(MaterialGraphTest, GgxHighlight) {
+    std::string error;
+    auto smooth = compile({constant(0.5f, 0.5f, 0.5f), constant(0.2f, 0.2f, 0.2f), op("ggx", {0, 1})}, 2, error);
+    auto rough = compile({constant(0.5f, 0.5f, 0.5f), constant(0.8f, 0.8f, 0.8f), op("ggx", {0, 1})}, 2, error);
+    ASSERT_TRUE(smooth && rough) << error;
+
+    float peak, off, rough_peak, g, b;
+    smooth->evaluate(facing_input(0, 0, 1), peak, g, b);
+    smooth->evaluate(facing_input(0, 1, 1), off, g, b);
+    rough->evaluate(facing_input(0, 0, 1), rough_peak, g, b);
+    EXPECT_GT(peak, off);
+    EXPECT_GT(peak, rough_peak);
+    EXPECT_GT(off, 0.0f);
+
+    smooth->evaluate(facing_input(0, 0, -1), peak, g, b);
+    EXPECT_FLOAT_EQ(peak, 0.0f);
+}
+
+// テクスチャは最近傍・リピートでサンプリングし、0-1 に正規化する
+TEST(MaterialGraphTest, SamplesTextures) {
+    auto image = std::make_shared<TextureImage>();
+    image->width = 2;
+    image->height = 1;
+    image->channels = 4;
+    image->pixels = {255, 0, 0, 255, 0, 51, 102, 255};
+    auto lookup = [&](const std::string& name) { return name == "checker" ? image : nullptr; };
+
+    Node tex;
+    tex.op = "texture";
+    tex.texture = "checker";
+    std::string error;
+    auto program = compile({tex}, 0, error, lookup);
+    ASSERT_TRUE(program) << error;
+
+    ShadingInput input = facing_input(0, 0, 1);
+    float r, g, b;
+    input.u = 0.25f;
+    program->evaluate(input, r, g, b);
+    EXPECT_FLOAT_EQ(r, 1.0f);
+    input.u = 1.75f;
+    program->evaluate(input, r, g, b);
+    EXPECT_FLOAT_EQ(r, 0.0f);
+    EXPECT_FLOAT_EQ(g, 0.2f);
+    EXPECT_FLOAT_EQ(b, 0.4f);
+
+    tex.texture = "missing";
+    EXPECT_FALSE(compile({tex}, 0, error, lookup));
+    EXPECT_NE(error.find("missing"), std::string::npos);
+}
+
+// 前のノードしか参照できず、未知の演算・入力数の誤り・存在しない出力はコンパイルエラー
+TEST(MaterialGraphTest, RejectsInvalidGraphs) {
+    std::string error;
+    EXPECT_FALSE(compile({op("lambert", {0})}, 0, error));
+    EXPECT_FALSE(compile({constant(1, 1, 1), op("lambert", {1})}, 1, error));
+    EXPECT_FALSE(compile({constant(1, 1, 1), op("phong", {0})}, 1, error));
+    EXPECT_NE(error.find("phong"), std::string::npos);
+    EXPECT_FALSE(compile({constant(1, 1, 1), op("mix", {0, 0})}, 1, error));
+    EXPECT_FALSE(compile({constant(1, 1, 1)}, 1, error));
+    EXPECT_FALSE(compile({}, 0, error));
+}
+
+// まとめて評価しても1ヒットずつの評価と同じ結果（レーン数をまたぐ個数）
+TEST(MaterialGraphTest, BatchMatchesSingle) {
+    std::string error;
+    auto program = compile({
+        constant(0.8f, 0.3f, 0.1f),
+        op("lambert", {0}),
+        constant(0.04f, 0.04f, 0.04f),
+        constant(0.3f, 0.3f, 0.3f),
+        op("ggx", {2, 3}),
+        op("add", {1, 4}),
+    }, 5, error);
+    ASSERT_TRUE(program) << error;
+
+    std::vector<ShadingInput> inputs;
+    for (int i = 0; i < 19; ++i) {
+        float angle = 0.1f * i;
+        inputs.push_back(facing_input(std::sin(angle), 0.2f, std::cos(angle)));
+    }
+    std::vector<float> out(inputs.size() * 3);
+    program->evaluate(inputs.data(), static_cast<int>(inputs.size()), out.data());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        float r, g, b;
+        program->evaluate(inputs[i], r, g, b);
+        EXPECT_FLOAT_EQ(out[i * 3 + 0], r) << i;
+        EXPECT_FLOAT_EQ(out[i * 3 + 1], g) << i;
+        EXPECT_FLOAT_EQ(out[i * 3 + 2], b) << i;
+    }
+}
+
+class MaterialGraphLuaTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        AppContext ctx;
+        bind_lua(lua, ctx);
+        lua.script("package.path = package.path .. ';./lib/?.lua;../../?.lua'");
+    }
+
+    sol::state lua;
+};
+
+// lib/MaterialGraph.lua で記述したグラフを AppData に登録し、別の参照から評価できる
+TEST_F(MaterialGraphLuaTest, CompilesAndEvaluatesFromLua) {
+    auto result = lua.safe_script(R"(
+        local MaterialGraph = require('lib.MaterialGraph')
+        local data = AppData.new(4, 4)
+
+        local graph = MaterialGraph.new()
+        local albedo = graph:constant(0.5, 0.25, 1.0)
+        local ambient = graph:mul(albedo, graph:constant(0.2))
+        local color = graph:add(ambient, graph:mul(graph:lambert(albedo), graph:constant(0.8)))
+        assert(graph:compile(data, "test_material", color))
+
+        local material = data:get_material("test_material")
+        assert(material)
+        local r, g, b = material:eval(0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0)
+        assert(math.abs(r - 0.5) < 1e-5 and math.abs(g - 0.25) < 1e-5 and math.abs(b - 1.0) < 1e-5)
+        r = material:eval(0, 0, 1, 0, 0, 1, 0, 0, -1, 0, 0)
+        assert(math.abs(r - 0.1) < 1e-5)
+
+        assert(data:get_material("unknown") == nil)
+
+        -- コンパイルエラーは false とメッセージ
+        local bad = MaterialGraph.new()
+        bad:texture("no_such_texture")
+        local ok, err = bad:compile(data, "bad_material", 1)
+        assert(ok == false and err:find("no_such_texture", 1, true), err)
+        assert(data:get_material("bad_material") == nil)
+    )");
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+}
@@ -157,6 +157,38 @@ TEST_F(PathTracerTest, RadianceReturnsEmissionForLight) {
     ASSERT_EQ(z, 10.0);
 }
 
+TEST_F(PathTracerTest, RadianceXyzReturnsFirstHitForAovs) {
+    // 放射輝度に続けて、最初の交差（距離・レイの反対側を向いた法線・geomID）を返す
+    auto result = lua.safe_script(R"(
+        local Vec3 = require('lib.Vec3')
+        local Material = require('lib.Material')
+        local PathTracer = require('lib.PathTracer')
+        
+        -- 裏側から当たるよう、法線はレイと同じ向きで返す
+        local mock_scene = {
+            intersect = function(self, ox, oy, oz, dx, dy, dz)
+                return true, 2.0, 0, -1, 0, 3, 0
+            end
+        }
+        local materials = {
+            [3] = Material.DiffuseLight(Vec3.new(1.0, 1.0, 1.0))
+        }
+        
+        local _, _, _, t, nx, ny, nz, geomID = PathTracer.radiance_xyz(0, 2, 0, 0, -1, 0, mock_scene, materials, 5)
+        assert(t == 2.0 and nx == 0 and ny == 1 and nz == 0 and geomID == 3)
+        
+        -- 最初のレイが当たらない場合は nil
+        local miss_scene = {
+            intersect = function(self, ox, oy, oz, dx, dy, dz)
+                return false, 0, 0, 0, 0, -1, -1
+            end
+        }
+        local _, _, _, miss_t = PathTracer.radiance_xyz(0, 0, 0, 0, 0, 1, miss_scene, materials, 5)
+        assert(miss_t == nil)
+    )");
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+}
+
 TEST_F(PathTracerTest, RadianceReturnsZeroAtMaxDepth) {
     // 深度0の場合、即座に黒を返す
     auto result = lua.safe_script(R"(
@@ -0,0 +1,134 @@
+// raw_bindings_test.cpp
+// ホットパス用の手書き lua_CFunction（src/raw_bindings.h）のテスト
+// 結果が sol2 のバインディングと一致することを確認する
+// 呼び出しコストの比較（マイクロベンチマーク）は通常の実行では無効化している
+// （--gtest_also_run_disabled_tests --gtest_filter=*Microbenchmark で実行する）
+
+#include <gtest/gtest.h>
+#include "../src/lua_binding.h"
+#include <sol/sol.hpp>
+#include <chrono>
+#include <cstdio>
+
+class RawBindingsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        AppContext ctx;
+        bind_lua(lua, ctx);
+    }
+
+    // script を実行し、かかった時間（ミリ秒）を返す
+    double time_script(const char* script) {
+        auto start = std::chrono::steady_clock::now();
+        auto result = lua.safe_script(script);
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        EXPECT_TRUE(result.valid()) << ((sol::error)result).what();
+        return elapsed;
+    }
+
+    sol::state lua;
+};
+
+TEST_F(RawBindingsTest, PixelAccessMatchesSolBinding) {
+    auto result = lua.safe_script(R"(
+        local data = AppData.new(8, 8)
+        local set_pixel = data:raw_set_pixel()
+        local get_pixel = data:raw_get_pixel()
+
+        -- set_pixel はバックバッファに書き込み、get_pixel はフロントバッファから読むため swap を挟む
+        set_pixel(data, 1, 2, 10, 20, 30)
+        data:set_pixel(3, 4, 40, 50, 60)
+        -- 浮動小数点の座標・色は sol2 と同じく整数に丸める
+        set_pixel(data, 5.0, 6.0, 70.0, 80.0, 90.0)
+        -- 第1引数は無視され、取得元のオブジェクトに書き込む
+        local other = AppData.new(8, 8)
+        set_pixel(other, 0, 0, 1, 2, 3)
+        data:swap()
+        other:swap()
+
+        local r, g, b = data:get_pixel(1, 2)
+        assert(r == 10 and g == 20 and b == 30)
+        r, g, b = get_pixel(data, 3, 4)
+        assert(r == 40 and g == 50 and b == 60)
+        assert(math.type(r) == "integer")
+        r, g, b = data:get_pixel(5, 6)
+        assert(r == 70 and g == 80 and b == 90)
+        r, g, b = data:get_pixel(0, 0)
+        assert(r == 1 and g == 2 and b == 3)
+        r, g, b = other:get_pixel(0, 0)
+        assert(r == 0 and g == 0 and b == 0)
+
+        -- 範囲外は sol2 と同じく 0
+        r, g, b = get_pixel(data, -1, 100)
+        assert(r == 0 and g == 0 and b == 0)
+    )");
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+}
+
+TEST_F(RawBindingsTest, IntersectMatchesSolBinding) {
+    auto result = lua.safe_script(R"(
+        local device = EmbreeDevice.new()
+        local scene = device:create_scene()
+        scene:add_sphere(0, 0, 0, 1.0)
+        scene:commit()
+        local intersect = scene:raw_intersect()
+
+        local rays = {
+            {0, 0, 5, 0, 0, -1},
+            {0.3, 0.2, 5, 0, 0, -1},
+            {0, 0, 5, 0, 0, 1},
+            {5, 5, 5, 0, 0, -1},
+        }
+        for _, ray in ipairs(rays) do
+            local expected = {scene:intersect(table.unpack(ray))}
+            local actual = {intersect(scene, table.unpack(ray))}
+            assert(#actual == 9, "intersect should return 9 values")
+            for i = 1, 9 do
+                assert(expected[i] == actual[i], "value " .. i .. " differs")
+            end
+        end
+        assert(intersect(scene, 0, 0, 5, 0, 0, -1) == true)
+        assert(intersect(scene, 5, 5, 5, 0, 0, -1) == false)
+    )");
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+}
+
+// sol2 のメソッド呼び出しと高速パスの呼び出しコストを比較する（時間は環境依存のため表示のみ）
+// 検証を行わず時間がかかるため、明示的に指定したときだけ実行する
+TEST_F(RawBindingsTest, DISABLED_Microbenchmark) {
+    auto setup = lua.safe_script(R"(
+        N = 200000
+        data = AppData.new(64, 64)
+        raw_set_pixel = data:raw_set_pixel()
+        raw_get_pixel = data:raw_get_pixel()
+        device = EmbreeDevice.new()
+        scene = device:create_scene()
+        scene:add_sphere(0, 0, 0, 1.0)
+        scene:commit()
+        raw_intersect = scene:raw_intersect()
+    )");
+    ASSERT_TRUE(setup.valid()) << ((sol::error)setup).what();
+
+    struct Case {
+        const char* name;
+        const char* sol_script;
+        const char* raw_script;
+    };
+    const Case cases[] = {
+        {"set_pixel",
+         "for i = 1, N do data:set_pixel(i % 64, 7, 1, 2, 3) end",
+         "local f = raw_set_pixel for i = 1, N do f(data, i % 64, 7, 1, 2, 3) end"},
+        {"get_pixel",
+         "local s = 0 for i = 1, N do local r = data:get_pixel(i % 64, 7) s = s + r end",
+         "local f, s = raw_get_pixel, 0 for i = 1, N do local r = f(data, i % 64, 7) s = s + r end"},
+        {"intersect",
+         "for i = 1, N do scene:intersect(0, 0, 5, 0, 0, -1) end",
+         "local f = raw_intersect for i = 1, N do f(scene, 0, 0, 5, 0, 0, -1) end"},
+    };
+    for (const auto& c : cases) {
+        double sol_ms = time_script(c.sol_script);
+        double raw_ms = time_script(c.raw_script);
+        std::printf("[ raw bench ] %-10s sol2 %8.2f ms  raw %8.2f ms  (x%.2f)\n",
+                    c.name, sol_ms, raw_ms, raw_ms > 0.0 ? sol_ms / raw_ms : 0.0);
+    }
+}
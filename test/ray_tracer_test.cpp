@@ -84,7 +84,7 @@ TEST_F(RayTracerTest, CancelRendering) {
         
         -- Simulate rendering state
         rt.render_coroutine = coroutine.create(function() end)
-        rt.workers = { { terminate = function() end } } -- Mock worker
+        rt.workers = { { cancel = function() end, terminate = function() end } } -- Mock worker
         
         if rt.cancel then
             rt:cancel()
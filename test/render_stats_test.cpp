@@ -0,0 +1,93 @@
+// render_stats_test.cpp
+// RenderStats（ワーカーごとの進捗・スループット統計）のテスト
+
+#include <gtest/gtest.h>
+#include "../src/render_stats.h"
+#include <thread>
+#include <vector>
+
+TEST(RenderStatsTest, RecordsPerWorkerCounters) {
+    RenderStats stats(2, 100, 4);
+    stats.record_tile(0, 10, 80);
+    stats.record_tile(1, 20, 100);
+    stats.record_tile(1, 5, 0);
+
+    RenderStats::Counters first = stats.worker(0);
+    EXPECT_EQ(first.tiles, 1u);
+    EXPECT_EQ(first.pixels, 10u);
+    EXPECT_EQ(first.samples, 40u);
+    EXPECT_EQ(first.rays, 80u);
+
+    RenderStats::Counters total = stats.total();
+    EXPECT_EQ(total.tiles, 3u);
+    EXPECT_EQ(total.pixels, 35u);
+    EXPECT_EQ(total.samples, 140u);
+    EXPECT_EQ(total.rays, 180u);
+    EXPECT_DOUBLE_EQ(stats.progress(), 0.35);
+
+    // ワーカー番号はスロット数の剰余で割り当てる
+    stats.record_tile(2, 1, 0);
+    EXPECT_EQ(stats.worker(0).pixels, 11u);
+}
+
+// ETAはまだ報告が無ければ負、完了後は0
+TEST(RenderStatsTest, EtaFromAverageThroughput) {
+    RenderStats stats(1, 100, 1);
+    EXPECT_LT(stats.eta_seconds(), 0.0);
+
+    stats.record_tile(0, 50, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    double eta = stats.eta_seconds();
+    EXPECT_GT(eta, 0.0);
+    // 半分終わっているので残り時間は経過時間とほぼ同じ
+    EXPECT_NEAR(eta, stats.elapsed_seconds(), stats.elapsed_seconds() * 0.5);
+
+    stats.record_tile(0, 50, 0);
+    EXPECT_DOUBLE_EQ(stats.eta_seconds(), 0.0);
+    EXPECT_DOUBLE_EQ(stats.progress(), 1.0);
+}
+
+// finish() 後は経過時間が固定される
+TEST(RenderStatsTest, FinishFreezesElapsedTime) {
+    RenderStats stats(1, 10, 1);
+    EXPECT_FALSE(stats.finished());
+    stats.finish();
+    EXPECT_TRUE(stats.finished());
+    double elapsed = stats.elapsed_seconds();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_DOUBLE_EQ(stats.elapsed_seconds(), elapsed);
+}
+
+// 複数スレッドからの同時報告でも件数が失われない
+TEST(RenderStatsTest, ConcurrentRecording) {
+    RenderStats stats(4, 4000, 1);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&stats, t] {
+            for (int i = 0; i < 1000; ++i) stats.record_tile(t, 1, 2);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(stats.total().pixels, 4000u);
+    EXPECT_EQ(stats.total().rays, 8000u);
+    EXPECT_EQ(stats.worker(3).tiles, 1000u);
+}
+
+// レイ数は begin() の時点のスレッドの累積値からの差分で数え、前回のレンダーの分は含めない
+TEST(RenderStatsTest, RaysCountFromBeginMark) {
+    RenderStats previous(1, 100, 1);
+    previous.begin(0, 0);
+    previous.record_tile_at(0, 10, 500);
+
+    RenderStats stats(2, 100, 1);
+    stats.begin(0, 500);
+    stats.begin(1, 20);
+    stats.record_tile_at(0, 10, 530);
+    stats.record_tile_at(0, 10, 600);
+    stats.record_tile_at(1, 5, 25);
+
+    EXPECT_EQ(previous.worker(0).rays, 500u);
+    EXPECT_EQ(stats.worker(0).rays, 100u);
+    EXPECT_EQ(stats.worker(1).rays, 5u);
+    EXPECT_EQ(stats.total().pixels, 25u);
+}
@@ -0,0 +1,124 @@
+// shared_store_test.cpp
+// SharedStore（型付き共有ストア）のテスト
+
+#include <gtest/gtest.h>
+#include "../src/shared_store.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+class SharedStoreTest : public ::testing::Test {
+protected:
+    SharedStore store;
+};
+
+TEST_F(SharedStoreTest, MissingValueReturnsNull) {
+    EXPECT_EQ(store.get("missing"), nullptr);
+    EXPECT_EQ(store.snapshot(-1), nullptr);
+    EXPECT_EQ(store.snapshot(SharedStore::MAX_SLOTS), nullptr);
+}
+
+TEST_F(SharedStoreTest, StoresTypedValues) {
+    store.set_number("n", 2.5);
+    store.set_floats("f", {1.0f, 2.0f});
+    store.set_ints("i", {7, 8, 9});
+    store.set_blob("b", std::string("\x01\x02", 2));
+
+    auto n = store.get("n");
+    ASSERT_NE(n, nullptr);
+    EXPECT_EQ(n->type, SharedValue::Type::Number);
+    EXPECT_DOUBLE_EQ(n->number, 2.5);
+
+    auto f = store.get("f");
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(f->type, SharedValue::Type::FloatArray);
+    EXPECT_EQ(f->size(), 2u);
+
+    auto i = store.get("i");
+    ASSERT_NE(i, nullptr);
+    EXPECT_EQ(i->ints, (std::vector<int32_t>{7, 8, 9}));
+
+    auto b = store.get("b");
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(b->size(), 2u);
+}
+
+// 名前とスロット番号は同じ値を指す
+TEST_F(SharedStoreTest, SlotLookupMatchesName) {
+    int slot = store.slot("value");
+    store.set_number("value", 4.0);
+
+    EXPECT_EQ(store.slot("value"), slot);
+    EXPECT_EQ(store.snapshot(slot), store.get("value"));
+}
+
+// 取得済みのスナップショットは上書き・削除の影響を受けない
+TEST_F(SharedStoreTest, SnapshotIsImmutableAcrossUpdates) {
+    store.set_ints("queue", {1, 2, 3});
+    auto before = store.get("queue");
+
+    store.set_ints("queue", {4});
+    store.remove("queue");
+
+    ASSERT_NE(before, nullptr);
+    EXPECT_EQ(before->ints, (std::vector<int32_t>{1, 2, 3}));
+    EXPECT_EQ(store.get("queue"), nullptr);
+}
+
+// 書き込み中に並行して読み取っても常に完全なスナップショットが見える
+TEST_F(SharedStoreTest, ConcurrentReadersSeeCompleteSnapshots) {
+    int slot = store.slot("data");
+    store.set_ints("data", std::vector<int32_t>(64, 0));
+
+    std::atomic<bool> running{true};
+    std::atomic<int> torn{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&]() {
+            while (running.load()) {
+                auto snap = store.snapshot(slot);
+                for (int32_t v : snap->ints) {
+                    if (v != snap->ints[0]) {
+                        torn.fetch_add(1);
+                        break;
+                    }
+                }
+            }
+        });
+    }
+
+    for (int32_t gen = 1; gen <= 200; ++gen) {
+        store.set_ints("data", std::vector<int32_t>(64, gen));
+    }
+    running.store(false);
+    for (auto& th : readers) th.join();
+
+    EXPECT_EQ(torn.load(), 0);
+}
+
+// 読み手のカウンタ数より多いスレッドが読み取っても、置き換えた値は読み終わるまで解放されない
+TEST_F(SharedStoreTest, ReadersBeyondReaderSlotsKeepSnapshotsValid) {
+    int slot = store.slot("data");
+    store.set_ints("data", std::vector<int32_t>(16, 0));
+
+    std::atomic<int> torn{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < SharedStore::READER_SLOTS + 8; ++t) {
+        readers.emplace_back([&]() {
+            for (int i = 0; i < 1000; ++i) {
+                auto snap = store.snapshot(slot);
+                if (snap->ints.size() != 16 || snap->ints[15] != snap->ints[0]) {
+                    torn.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    for (int32_t gen = 1; gen <= 10; ++gen) {
+        store.set_ints("data", std::vector<int32_t>(16, gen));
+    }
+    for (auto& th : readers) th.join();
+
+    EXPECT_EQ(torn.load(), 0);
+    EXPECT_EQ(store.snapshot(slot)->ints[0], 10);
+}
@@ -0,0 +1,167 @@
+// sync_registry_test.cpp
+// SyncRegistry（名前付きアトミックカウンタ・バリア・ラッチ）のテスト
+
+#include <gtest/gtest.h>
+#include "../src/sync_registry.h"
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class SyncRegistryTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        sync = std::make_unique<SyncRegistry>();
+    }
+
+    std::unique_ptr<SyncRegistry> sync;
+};
+
+// 同じ名前は同じスロットに解決される
+TEST_F(SyncRegistryTest, CounterSlotIsStablePerName) {
+    int a = sync->counter_slot("a");
+    int b = sync->counter_slot("b");
+
+    EXPECT_NE(a, b);
+    EXPECT_EQ(sync->counter_slot("a"), a);
+    EXPECT_EQ(sync->counter_load(a), 0);
+}
+
+TEST_F(SyncRegistryTest, CounterFetchAddReturnsPreviousValue) {
+    int slot = sync->counter_slot("idx");
+    sync->counter_store(slot, 10);
+
+    EXPECT_EQ(sync->counter_fetch_add(slot, 1), 10);
+    EXPECT_EQ(sync->counter_fetch_add(slot, 5), 11);
+    EXPECT_EQ(sync->counter_load(slot), 16);
+}
+
+TEST_F(SyncRegistryTest, CounterCompareExchange) {
+    int slot = sync->counter_slot("cas");
+    sync->counter_store(slot, 3);
+
+    auto [ok, prev] = sync->counter_compare_exchange(slot, 2, 7);
+    EXPECT_FALSE(ok);
+    EXPECT_EQ(prev, 3);
+
+    std::tie(ok, prev) = sync->counter_compare_exchange(slot, 3, 7);
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(prev, 3);
+    EXPECT_EQ(sync->counter_load(slot), 7);
+}
+
+// 複数スレッドからの fetch_add で重複・欠番が出ない
+TEST_F(SyncRegistryTest, CounterFetchAddIsExclusiveAcrossThreads) {
+    const int num_threads = 8;
+    const int per_thread = 1000;
+    int slot = sync->counter_slot("shared");
+    std::vector<std::vector<int64_t>> taken(num_threads);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < per_thread; ++i) {
+                taken[t].push_back(sync->counter_fetch_add(slot, 1));
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    std::vector<bool> seen(num_threads * per_thread, false);
+    for (const auto& list : taken) {
+        for (int64_t v : list) {
+            ASSERT_GE(v, 0);
+            ASSERT_LT(v, num_threads * per_thread);
+            EXPECT_FALSE(seen[v]);
+            seen[v] = true;
+        }
+    }
+    EXPECT_EQ(sync->counter_load(slot), num_threads * per_thread);
+}
+
+// スロットが枯渇した場合は -1 を返し、無効スロットへの操作は無視される
+TEST_F(SyncRegistryTest, CounterSlotExhaustionReturnsInvalid) {
+    for (int i = 0; i < SyncRegistry::MAX_COUNTERS; ++i) {
+        ASSERT_GE(sync->counter_slot("c" + std::to_string(i)), 0);
+    }
+    int overflow = sync->counter_slot("overflow");
+    EXPECT_EQ(overflow, -1);
+
+    sync->counter_store(overflow, 5);
+    EXPECT_EQ(sync->counter_fetch_add(overflow, 1), 0);
+    EXPECT_EQ(sync->counter_load(overflow), 0);
+}
+
+// 全員が到着するまでバリアは解放されず、再利用できる
+TEST_F(SyncRegistryTest, BarrierReleasesWhenAllArriveAndIsReusable) {
+    const int num_threads = 4;
+    int barrier = sync->barrier_slot("pass", num_threads);
+    int counter = sync->counter_slot("arrived");
+
+    std::vector<std::thread> threads;
+    std::vector<int64_t> observed(num_threads * 2, -1);
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int pass = 0; pass < 2; ++pass) {
+                sync->counter_fetch_add(counter, 1);
+                int64_t phase = sync->barrier_arrive(barrier);
+                sync->barrier_wait(barrier, phase, -1);
+                // バリア通過後は同じパスの全スレッドが到着済み
+                observed[pass * num_threads + t] = sync->counter_load(counter);
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    for (int t = 0; t < num_threads; ++t) {
+        EXPECT_GE(observed[t], num_threads);
+        EXPECT_GE(observed[num_threads + t], num_threads * 2);
+    }
+}
+
+TEST_F(SyncRegistryTest, BarrierWaitTimesOut) {
+    int barrier = sync->barrier_slot("never", 2);
+    int64_t phase = sync->barrier_arrive(barrier);
+
+    EXPECT_FALSE(sync->barrier_wait(barrier, phase, 0));
+    EXPECT_FALSE(sync->barrier_wait(barrier, phase, 5));
+
+    // 残りの参加者が到着すれば解放される
+    sync->barrier_arrive(barrier);
+    EXPECT_TRUE(sync->barrier_wait(barrier, phase, 0));
+}
+
+TEST_F(SyncRegistryTest, LatchOpensWhenCountReachesZero) {
+    int latch = sync->latch_slot("done", 3);
+
+    EXPECT_FALSE(sync->latch_try_wait(latch));
+    sync->latch_count_down(latch, 2);
+    EXPECT_FALSE(sync->latch_wait(latch, 1));
+
+    std::thread t([&]() { sync->latch_count_down(latch, 1); });
+    EXPECT_TRUE(sync->latch_wait(latch, -1));
+    t.join();
+
+    // reset で再利用できる
+    sync->latch_reset(latch, 1);
+    EXPECT_FALSE(sync->latch_try_wait(latch));
+}
+
+// interrupt_waiters は待機中のスレッドを起こし、待機は false で終わる
+TEST_F(SyncRegistryTest, InterruptWakesWaiters) {
+    int latch = sync->latch_slot("blocked", 1);
+    std::thread interrupter([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        sync->interrupt_waiters();
+    });
+    EXPECT_FALSE(sync->latch_wait(latch, -1));
+    interrupter.join();
+
+    // 割り込み後の待機は通常どおり到達を待つ
+    std::thread counter([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        sync->latch_count_down(latch, 1);
+    });
+    EXPECT_TRUE(sync->latch_wait(latch, -1));
+    counter.join();
+}
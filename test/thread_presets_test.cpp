@@ -115,3 +115,45 @@ TEST_F(ThreadPresetsTest, FindBlockIndexByValue) {
     ASSERT_GT(std::get<1>(res), 0); // 128のインデックスが見つかる
     ASSERT_TRUE(std::get<2>(res).is<sol::nil_t>()); // 999は見つからない
 }
+
+// テスト7: Auto プリセットはホストの論理CPU数に解決される
+TEST_F(ThreadPresetsTest, ResolveAutoThreadCount) {
+    auto result = lua.safe_script(R"(
+        local ThreadPresets = require('lib.ThreadPresets')
+        local presets = ThreadPresets.get_thread_presets()
+        local auto_index = ThreadPresets.find_thread_index(ThreadPresets.AUTO)
+        return presets[auto_index].name,
+            ThreadPresets.resolve_thread_count(ThreadPresets.AUTO, 24),
+            ThreadPresets.resolve_thread_count(ThreadPresets.AUTO, nil),
+            ThreadPresets.resolve_thread_count(4, 24)
+    )");
+
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+    std::tuple<std::string, int, int, int> res = result;
+    EXPECT_EQ(std::get<0>(res), "Auto");
+    EXPECT_EQ(std::get<1>(res), 24);
+    EXPECT_EQ(std::get<2>(res), 8); // 不明な場合はデフォルトのスレッド数
+    EXPECT_EQ(std::get<3>(res), 4);
+}
+
+// テスト8: Lua GCプリセットはメインステートとワーカーの両方にそのまま渡せる
+TEST_F(ThreadPresetsTest, GcPresetsAreAcceptedByBindings) {
+    auto result = lua.safe_script(R"(
+        local ThreadPresets = require('lib.ThreadPresets')
+        local presets = ThreadPresets.get_gc_presets()
+        local default = presets[ThreadPresets.get_default_gc_index()]
+        local all_ok = true
+        for _, preset in ipairs(presets) do
+            all_ok = all_ok and app.set_gc_settings(preset.value)
+        end
+        app.set_gc_settings(default.value)
+        return #presets, default.value.mode, all_ok, app.set_gc_settings({ mode = "unknown" })
+    )");
+
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+    std::tuple<int, std::string, bool, bool> res = result;
+    EXPECT_GE(std::get<0>(res), 2);
+    EXPECT_EQ(std::get<1>(res), "incremental");
+    EXPECT_TRUE(std::get<2>(res));
+    EXPECT_FALSE(std::get<3>(res));
+}
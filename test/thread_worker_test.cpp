@@ -6,6 +6,8 @@
 #include "../src/app_data.h"
 #include "../src/embree_wrapper.h"
 #include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <thread>
 
 class ThreadWorkerTest : public ::testing::Test {
@@ -63,3 +65,121 @@ TEST_F(ThreadWorkerTest, TerminateBeforeStartIsSafe) {
     ASSERT_TRUE(worker.is_cancel_requested());
     ASSERT_TRUE(worker.is_done()); // 未開始なのでdoneはtrue
 }
+
+// ===========================================
+// 永続スレッドとウォームステートのテスト
+// ===========================================
+
+class ThreadWorkerPoolTest : public ThreadWorkerTest {
+protected:
+    void SetUp() override {
+        ThreadWorkerTest::SetUp();
+        // 実行回数をグローバル変数に数え、AppData に書き出すスクリプト
+        script_path = testing::TempDir() + "thread_worker_count_runs.lua";
+        std::ofstream file(script_path);
+        file << "runs = (runs or 0) + 1\n"
+             << "_app_data:set_string('runs', tostring(runs))\n";
+    }
+
+    void TearDown() override {
+        std::remove(script_path.c_str());
+        ThreadWorkerTest::TearDown();
+    }
+
+    std::string script_path;
+};
+
+// テスト5: 連続したジョブは同じLua Stateで実行される
+TEST_F(ThreadWorkerPoolTest, LuaStateIsReusedAcrossJobs) {
+    ThreadWorker worker(data.get(), scene.get(), {0, 0, 100, 100}, 0);
+
+    worker.start(script_path, "test_lifecycle");
+    worker.join();
+    ASSERT_TRUE(worker.is_done());
+    EXPECT_EQ(data->get_string("runs"), "1");
+
+    worker.start(script_path, "test_lifecycle");
+    worker.join();
+    EXPECT_EQ(data->get_string("runs"), "2");
+}
+
+// テスト6: reset_state() とシーン種別の変更でLua Stateが作り直される
+TEST_F(ThreadWorkerPoolTest, LuaStateIsRebuiltOnResetOrSceneChange) {
+    ThreadWorker worker(data.get(), scene.get(), {0, 0, 100, 100}, 0);
+
+    worker.start(script_path, "test_lifecycle");
+    worker.join();
+    worker.reset_state();
+    worker.start(script_path, "test_lifecycle");
+    worker.join();
+    EXPECT_EQ(data->get_string("runs"), "1");
+
+    worker.start(script_path, "test_lifecycle");
+    worker.join();
+    EXPECT_EQ(data->get_string("runs"), "2");
+
+    worker.start(script_path, "color_pattern");
+    worker.join();
+    EXPECT_EQ(data->get_string("runs"), "1");
+}
+
+// テスト7: shutdown() 後の start() は新しいスレッドで再開する
+TEST_F(ThreadWorkerPoolTest, StartAfterShutdownRestartsThread) {
+    ThreadWorker worker(data.get(), scene.get(), {0, 0, 100, 100}, 0);
+
+    worker.start(script_path, "test_lifecycle");
+    worker.join();
+    worker.shutdown();
+    worker.shutdown(); // 複数回呼んでも安全
+    EXPECT_TRUE(worker.is_done());
+
+    worker.start(script_path, "test_lifecycle");
+    worker.join();
+    EXPECT_EQ(data->get_string("runs"), "1");
+}
+
+// テスト8: cancel() は実行中のジョブを待たず、続けて登録したジョブはキャンセル済みジョブの後に実行される
+TEST_F(ThreadWorkerPoolTest, CancelDoesNotBlockAndNextJobRuns) {
+    std::string loop_path = testing::TempDir() + "thread_worker_wait_cancel.lua";
+    {
+        std::ofstream file(loop_path);
+        file << "_app_data:set_string('started', '1')\n"
+             << "while not _is_cancel_requested() do end\n";
+    }
+    ThreadWorker worker(data.get(), scene.get(), {0, 0, 100, 100}, 0);
+
+    worker.start(loop_path, "test_lifecycle");
+    while (data->get_string("started") != "1") {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    worker.cancel();
+    worker.start(script_path, "test_lifecycle");
+    EXPECT_FALSE(worker.is_done());
+
+    worker.join();
+    EXPECT_TRUE(worker.is_done());
+    EXPECT_FALSE(worker.is_cancel_requested());
+    EXPECT_EQ(data->get_string("runs"), "1");
+    std::remove(loop_path.c_str());
+}
+
+// テスト9: shutdown() は実行中のジョブをキャンセルし、待機中のジョブは実行せずに終了する
+TEST_F(ThreadWorkerPoolTest, ShutdownCancelsRunningJobAndSkipsQueued) {
+    std::string loop_path = testing::TempDir() + "thread_worker_shutdown_cancel.lua";
+    {
+        std::ofstream file(loop_path);
+        file << "_app_data:set_string('started', '1')\n"
+             << "while not _is_cancel_requested() do end\n";
+    }
+    ThreadWorker worker(data.get(), scene.get(), {0, 0, 100, 100}, 0);
+
+    worker.start(loop_path, "test_lifecycle");
+    worker.start(script_path, "test_lifecycle");
+    while (data->get_string("started") != "1") {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    worker.shutdown();
+    EXPECT_TRUE(worker.is_cancel_requested());
+    EXPECT_EQ(data->get_string("runs"), "");
+    std::remove(loop_path.c_str());
+}
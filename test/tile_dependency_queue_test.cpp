@@ -0,0 +1,109 @@
+// tile_dependency_queue_test.cpp
+// TileDependencyQueue（レンダリングとPostEffectのパイプライン用キュー）のテスト
+
+#include <gtest/gtest.h>
+#include "../src/tile_dependency_queue.h"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 2x2 に並んだ 8x8 タイル（16x16 の画面）
+std::vector<TileDependencyQueue::Tile> grid_tiles() {
+    return {{0, 0, 8, 8}, {8, 0, 8, 8}, {0, 8, 8, 8}, {8, 8, 8, 8}};
+}
+
+} // namespace
+
+// 半径0では、PostEffectタイルは同じ位置のレンダリングタイルの完了だけを待つ
+TEST(TileDependencyQueueTest, PostTileReadyAfterItsRenderTile) {
+    TileDependencyQueue queue;
+    queue.reset(grid_tiles(), grid_tiles(), 0, 0);
+    EXPECT_EQ(queue.size(), 4u);
+
+    TileDependencyQueue::Tile tile;
+    EXPECT_FALSE(queue.next(tile));
+    EXPECT_FALSE(queue.wait_ready(0));
+
+    queue.complete_render_tile(8, 0);
+    ASSERT_TRUE(queue.next(tile));
+    EXPECT_EQ(tile.x, 8);
+    EXPECT_EQ(tile.y, 0);
+    EXPECT_FALSE(queue.next(tile));
+    EXPECT_FALSE(queue.finished());
+    EXPECT_EQ(queue.remaining(), 3u);
+}
+
+// 半径分広げた範囲に重なる全てのレンダリングタイルが揃うまで取得できない
+TEST(TileDependencyQueueTest, RadiusExtendsDependenciesToNeighbours) {
+    TileDependencyQueue queue;
+    queue.reset(grid_tiles(), {{0, 0, 8, 8}}, 1, 0);
+
+    TileDependencyQueue::Tile tile;
+    queue.complete_render_tile(0, 0);
+    queue.complete_render_tile(8, 0);
+    queue.complete_render_tile(0, 8);
+    EXPECT_FALSE(queue.next(tile));
+
+    queue.complete_render_tile(8, 8);
+    EXPECT_TRUE(queue.wait_ready(0));
+    ASSERT_TRUE(queue.next(tile));
+    EXPECT_TRUE(queue.finished());
+}
+
+// flip_height を指定すると、レンダリングタイルの y を反転したバッファ座標で依存関係を求める
+TEST(TileDependencyQueueTest, FlipHeightMapsRenderRowsToBuffer) {
+    TileDependencyQueue queue;
+    // レンダリングの上段 (y=0) はバッファの下段 (y=8) に書き込まれる
+    queue.reset(grid_tiles(), {{0, 8, 8, 8}}, 0, 16);
+
+    TileDependencyQueue::Tile tile;
+    queue.complete_render_tile(0, 8);
+    EXPECT_FALSE(queue.next(tile));
+    queue.complete_render_tile(0, 0);
+    ASSERT_TRUE(queue.next(tile));
+    EXPECT_EQ(tile.y, 8);
+}
+
+// retire 後はタイルを返さず、待機もすぐに終わる
+TEST(TileDependencyQueueTest, RetireStopsQueue) {
+    TileDependencyQueue queue;
+    queue.reset(grid_tiles(), grid_tiles(), 0, 0);
+    queue.complete_render_tile(0, 0);
+    queue.retire();
+
+    TileDependencyQueue::Tile tile;
+    EXPECT_TRUE(queue.retired());
+    EXPECT_FALSE(queue.next(tile));
+    EXPECT_TRUE(queue.finished());
+    EXPECT_FALSE(queue.wait_ready(-1));
+}
+
+// 待機中のスレッドは依存の解消、最後のタイルの取得、retire() で起こされる
+TEST(TileDependencyQueueTest, WaitReadyWakesWhenDependencySatisfied) {
+    TileDependencyQueue queue;
+    queue.reset({{0, 0, 4, 4}}, {{0, 0, 4, 4}}, 0, 0);
+    std::thread renderer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        queue.complete_render_tile(0, 0);
+    });
+    EXPECT_TRUE(queue.wait_ready(-1));
+    renderer.join();
+
+    TileScheduler::Tile tile;
+    ASSERT_TRUE(queue.next(tile));
+    EXPECT_FALSE(queue.wait_ready(-1));
+
+    queue.reset({{0, 0, 4, 4}}, {{0, 0, 4, 4}}, 0, 0);
+    std::thread retirer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        queue.retire();
+    });
+    EXPECT_FALSE(queue.wait_ready(-1));
+    retirer.join();
+
+    // タイムアウトした場合は false
+    queue.reset({{0, 0, 4, 4}}, {{0, 0, 4, 4}}, 0, 0);
+    EXPECT_FALSE(queue.wait_ready(5));
+}
@@ -0,0 +1,157 @@
+// tile_scheduler_test.cpp
+// TileScheduler（ワークスティーリング方式のタイルキュー）のテスト
+
+#include <gtest/gtest.h>
+#include "../src/tile_scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// x にインデックスを入れたタイル列
+std::vector<TileScheduler::Tile> make_tiles(int count) {
+    std::vector<TileScheduler::Tile> tiles;
+    for (int i = 0; i < count; ++i) {
+        tiles.push_back({i, 0, 8, 8});
+    }
+    return tiles;
+}
+
+} // namespace
+
+TEST(TileSchedulerTest, SingleQueueReturnsTilesInOrder) {
+    TileScheduler scheduler;
+    scheduler.reset(make_tiles(3), 1);
+    EXPECT_EQ(scheduler.size(), 3u);
+    EXPECT_EQ(scheduler.remaining(), 3u);
+
+    TileScheduler::Tile tile;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(scheduler.next(0, tile));
+        EXPECT_EQ(tile.x, i);
+    }
+    EXPECT_FALSE(scheduler.next(0, tile));
+    EXPECT_EQ(scheduler.remaining(), 0u);
+}
+
+// 各キューは自分の区間の先頭から取得する
+TEST(TileSchedulerTest, QueuesOwnContiguousRanges) {
+    TileScheduler scheduler;
+    scheduler.reset(make_tiles(8), 4);
+
+    TileScheduler::Tile tile;
+    ASSERT_TRUE(scheduler.next(0, tile));
+    EXPECT_EQ(tile.x, 0);
+    ASSERT_TRUE(scheduler.next(1, tile));
+    EXPECT_EQ(tile.x, 2);
+    ASSERT_TRUE(scheduler.next(3, tile));
+    EXPECT_EQ(tile.x, 6);
+    // キュー数を超える番号は剰余で扱う
+    ASSERT_TRUE(scheduler.next(5, tile));
+    EXPECT_EQ(tile.x, 3);
+}
+
+// 自分のキューが空になると、隣のキューの末尾から盗む
+TEST(TileSchedulerTest, EmptyQueueStealsFromBackOfOthers) {
+    TileScheduler scheduler;
+    scheduler.reset(make_tiles(4), 2); // キュー0: [0, 1], キュー1: [2, 3]
+
+    TileScheduler::Tile tile;
+    ASSERT_TRUE(scheduler.next(0, tile));
+    ASSERT_TRUE(scheduler.next(0, tile));
+    ASSERT_TRUE(scheduler.next(0, tile));
+    EXPECT_EQ(tile.x, 3);
+    ASSERT_TRUE(scheduler.next(1, tile));
+    EXPECT_EQ(tile.x, 2);
+    EXPECT_FALSE(scheduler.next(0, tile));
+    EXPECT_FALSE(scheduler.next(1, tile));
+}
+
+TEST(TileSchedulerTest, ResetReplacesTiles) {
+    TileScheduler scheduler;
+    TileScheduler::Tile tile;
+    EXPECT_FALSE(scheduler.next(0, tile)); // 未設定
+
+    scheduler.reset(make_tiles(2), 2);
+    ASSERT_TRUE(scheduler.next(0, tile));
+    scheduler.reset(make_tiles(5), 3);
+    EXPECT_EQ(scheduler.remaining(), 5u);
+    EXPECT_EQ(scheduler.num_queues(), 3);
+}
+
+// 複数スレッドから同時に取得しても、全タイルがちょうど1回ずつ配られる
+TEST(TileSchedulerTest, ConcurrentWorkersReceiveEachTileOnce) {
+    const int num_tiles = 5000;
+    const int num_threads = 8;
+    TileScheduler scheduler;
+    scheduler.reset(make_tiles(num_tiles), num_threads);
+
+    std::vector<std::atomic<int>> seen(num_tiles);
+    for (auto& s : seen) s.store(0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t] {
+            TileScheduler::Tile tile;
+            // 偏りを作るため、スレッド0だけが大半を処理する状況も混ぜる
+            while (scheduler.next(t, tile)) {
+                seen[tile.x].fetch_add(1);
+                if (t != 0) std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    for (int i = 0; i < num_tiles; ++i) {
+        ASSERT_EQ(seen[i].load(), 1) << "tile " << i;
+    }
+    EXPECT_EQ(scheduler.remaining(), 0u);
+}
+
+// 全タイルの完了報告で待ち合わせが解け、retire() 後はタイルを返さず待ち合わせも打ち切られる
+TEST(TileSchedulerTest, WaitCompletedAndRetire) {
+    TileScheduler scheduler;
+    scheduler.reset(make_tiles(2), 1);
+
+    TileScheduler::Tile tile;
+    ASSERT_TRUE(scheduler.next(0, tile));
+    scheduler.complete_tile();
+    EXPECT_FALSE(scheduler.wait_completed(0));
+    ASSERT_TRUE(scheduler.next(0, tile));
+    scheduler.complete_tile();
+    EXPECT_TRUE(scheduler.wait_completed(-1));
+
+    scheduler.reset(make_tiles(2), 1);
+    scheduler.retire();
+    EXPECT_TRUE(scheduler.retired());
+    EXPECT_FALSE(scheduler.next(0, tile));
+    EXPECT_FALSE(scheduler.wait_completed(-1));
+}
+
+// 待機中のスレッドは最後のタイルの完了、または retire() で起こされる
+TEST(TileSchedulerTest, WaitCompletedWakesOnLastCompletionAndRetire) {
+    TileScheduler scheduler;
+    scheduler.reset(make_tiles(2), 1);
+    scheduler.complete_tile();
+    std::thread completer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        scheduler.complete_tile();
+    });
+    EXPECT_TRUE(scheduler.wait_completed(-1));
+    completer.join();
+
+    scheduler.reset(make_tiles(2), 1);
+    std::thread retirer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        scheduler.retire();
+    });
+    EXPECT_FALSE(scheduler.wait_completed(-1));
+    retirer.join();
+
+    // タイムアウトした場合は false
+    scheduler.reset(make_tiles(1), 1);
+    EXPECT_FALSE(scheduler.wait_completed(5));
+}
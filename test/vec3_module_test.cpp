@@ -0,0 +1,103 @@
+// vec3_module_test.cpp
+// 割り当てなしのベクトル演算モジュール（グローバル v3）と lib/V3.lua のテスト
+
+#include <gtest/gtest.h>
+#include <sol/sol.hpp>
+#include "../src/vec3_module.h"
+#include <tuple>
+#include <cmath>
+
+class Vec3ModuleTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        lua.open_libraries(sol::lib::base, sol::lib::package, sol::lib::math, sol::lib::table);
+        lua.script("package.path = package.path .. ';./lib/?.lua;../../?.lua'");
+        open_vec3_module(lua.lua_state());
+    }
+
+    sol::state lua;
+};
+
+TEST_F(Vec3ModuleTest, BasicOperationsReturnMultipleValues) {
+    auto result = lua.safe_script(R"(
+        local ax, ay, az = v3.add(1, 2, 3, 4, 5, 6)
+        local cx, cy, cz = v3.cross(1, 0, 0, 0, 1, 0)
+        local mx, my, mz = v3.madd(1, 1, 1, 0, 2, 0, 0.5)
+        return ax, ay, az, cx, cy, cz, mx, my, mz, v3.dot(1, 2, 3, 4, 5, 6)
+    )");
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+    EXPECT_EQ(result.get<double>(0), 5.0);
+    EXPECT_EQ(result.get<double>(1), 7.0);
+    EXPECT_EQ(result.get<double>(2), 9.0);
+    EXPECT_EQ(result.get<double>(3), 0.0);
+    EXPECT_EQ(result.get<double>(4), 0.0);
+    EXPECT_EQ(result.get<double>(5), 1.0);
+    EXPECT_EQ(result.get<double>(6), 1.0);
+    EXPECT_EQ(result.get<double>(7), 2.0);
+    EXPECT_EQ(result.get<double>(8), 1.0);
+    EXPECT_EQ(result.get<double>(9), 32.0);
+}
+
+TEST_F(Vec3ModuleTest, NormalizeHandlesZeroLength) {
+    auto result = lua.safe_script(R"(
+        local x, y, z = v3.normalize(0, 3, 4)
+        local zx, zy, zz = v3.normalize(0, 0, 0)
+        return x, y, z, zx, zy, zz
+    )");
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+    EXPECT_FLOAT_EQ(result.get<float>(1), 0.6f);
+    EXPECT_FLOAT_EQ(result.get<float>(2), 0.8f);
+    EXPECT_EQ(result.get<double>(3), 0.0);
+    EXPECT_EQ(result.get<double>(4), 0.0);
+    EXPECT_EQ(result.get<double>(5), 0.0);
+}
+
+// 正規直交基底は w を法線とし、3軸が互いに直交する
+TEST_F(Vec3ModuleTest, OnbIsOrthonormal) {
+    auto result = lua.safe_script(R"(
+        local wx, wy, wz, ux, uy, uz, vx, vy, vz = v3.onb(0, 2, 0)
+        return wy, v3.dot(wx, wy, wz, ux, uy, uz), v3.dot(wx, wy, wz, vx, vy, vz),
+               v3.dot(ux, uy, uz, vx, vy, vz), v3.length(ux, uy, uz), v3.length(vx, vy, vz)
+    )");
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+    EXPECT_FLOAT_EQ(result.get<float>(0), 1.0f);
+    EXPECT_NEAR(result.get<double>(1), 0.0, 1e-6);
+    EXPECT_NEAR(result.get<double>(2), 0.0, 1e-6);
+    EXPECT_NEAR(result.get<double>(3), 0.0, 1e-6);
+    EXPECT_NEAR(result.get<double>(4), 1.0, 1e-6);
+    EXPECT_NEAR(result.get<double>(5), 1.0, 1e-6);
+}
+
+// lib.V3 はネイティブモジュールがあればそれを返し、無ければ同じ結果のLua実装を返す
+TEST_F(Vec3ModuleTest, LuaFallbackMatchesNative) {
+    auto result = lua.safe_script(R"(
+        local native = require('lib.V3')
+        assert(native == v3)
+
+        package.loaded['lib.V3'] = nil
+        local saved = v3
+        v3 = nil
+        local fallback = require('lib.V3')
+        v3 = saved
+        package.loaded['lib.V3'] = nil
+        assert(fallback ~= v3)
+
+        local max_diff = 0
+        local function compare(name, ...)
+            local a = table.pack(native[name](...))
+            local b = table.pack(fallback[name](...))
+            assert(a.n == b.n, name)
+            for i = 1, a.n do
+                max_diff = math.max(max_diff, math.abs(a[i] - b[i]))
+            end
+        end
+        compare('reflect', 0.6, -0.8, 0, 0, 1, 0)
+        compare('refract', 0.6, -0.8, 0, 0, 1, 0, 1 / 1.5)
+        compare('onb', 0.3, -0.5, 0.8)
+        compare('onb', 0, 0, 1)
+        compare('normalize', 1, 2, 3)
+        return max_diff
+    )");
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+    EXPECT_NEAR(result.get<double>(), 0.0, 1e-5);
+}
@@ -4,6 +4,9 @@
 #include <gtest/gtest.h>
 #include <sol/sol.hpp>
 #include "../src/app_data.h"
+#include "../src/lua_binding.h"
+#include <chrono>
+#include <thread>
 
 class WorkerUtilsTest : public ::testing::Test {
 protected:
@@ -20,11 +23,13 @@ protected:
 // block_process_loop のテスト (モック使用)
 TEST_F(WorkerUtilsTest, BlockProcessLoopRunsCallback) {
     // AppDataモック
-    lua.new_usertype<AppData>("MockAppData",
+    auto mock_type = lua.new_usertype<AppData>("MockAppData",
         "set_string", &AppData::set_string,
         "get_string", &AppData::get_string,
         "pop_next_index", &AppData::pop_next_index
     );
+    bind_shared_store(lua, mock_type);
+    bind_tile_scheduler(lua, mock_type);
     
     AppData data(100, 100);
     lua["app_data"] = &data;
@@ -45,7 +50,7 @@ TEST_F(WorkerUtilsTest, BlockProcessLoopRunsCallback) {
         local blocks = {
             {x = 0, y = 0, w = 10, h = 10}
         }
-        BlockUtils.setup_shared_queue(app_data, blocks, "test_queue", "test_queue_idx")
+        BlockUtils.setup_shared_queue(app_data, blocks, "test_queue")
         
         -- コールバック呼び出し回数
         call_count = 0
@@ -60,7 +65,7 @@ TEST_F(WorkerUtilsTest, BlockProcessLoopRunsCallback) {
         end
         
         -- appはC++で定義済みなのでそのまま渡す、もしくはnilで渡してグローバルフォールバックを確認してもよい
-        WorkerUtils.process_blocks(app_data, "test_queue", "test_queue_idx", process_callback, check_cancel, app)
+        WorkerUtils.process_blocks(app_data, "test_queue", 0, process_callback, check_cancel, app)
     )");
     
     int call_count = lua["call_count"];
@@ -71,11 +76,13 @@ TEST_F(WorkerUtilsTest, BlockProcessLoopRunsCallback) {
 // キャンセル時の動作テスト
 TEST_F(WorkerUtilsTest, BlockProcessLoopStopsOnCancel) {
      // AppDataモック
-    lua.new_usertype<AppData>("MockAppData",
+    auto mock_type = lua.new_usertype<AppData>("MockAppData",
         "set_string", &AppData::set_string,
         "get_string", &AppData::get_string,
         "pop_next_index", &AppData::pop_next_index
     );
+    bind_shared_store(lua, mock_type);
+    bind_tile_scheduler(lua, mock_type);
     
     AppData data(100, 100);
     lua["app_data"] = &data;
@@ -96,7 +103,7 @@ TEST_F(WorkerUtilsTest, BlockProcessLoopStopsOnCancel) {
         local blocks = {
             {x = 0, y = 0, w = 100, h = 100} -- 大きめのブロック
         }
-        BlockUtils.setup_shared_queue(app_data, blocks, "test_queue_cancel", "test_queue_idx_cancel")
+        BlockUtils.setup_shared_queue(app_data, blocks, "test_queue_cancel")
         
         call_count = 0
         
@@ -112,7 +119,7 @@ TEST_F(WorkerUtilsTest, BlockProcessLoopStopsOnCancel) {
         -- app.get_ticks を定義 (call_count依存)
         app.get_ticks = function() return call_count * 10 end
         
-        WorkerUtils.process_blocks(app_data, "test_queue_cancel", "test_queue_idx_cancel", process_callback, check_cancel, app)
+        WorkerUtils.process_blocks(app_data, "test_queue_cancel", 0, process_callback, check_cancel, app)
     )");
     
     int call_count = lua["call_count"];
@@ -122,11 +129,13 @@ TEST_F(WorkerUtilsTest, BlockProcessLoopStopsOnCancel) {
 
 // テスト: on_block_complete コールバックが各ブロック完了後に呼ばれる
 TEST_F(WorkerUtilsTest, OnBlockCompleteCallbackCalledPerBlock) {
-    lua.new_usertype<AppData>("MockAppData",
+    auto mock_type = lua.new_usertype<AppData>("MockAppData",
         "set_string", &AppData::set_string,
         "get_string", &AppData::get_string,
         "pop_next_index", &AppData::pop_next_index
     );
+    bind_shared_store(lua, mock_type);
+    bind_tile_scheduler(lua, mock_type);
     
     AppData data(100, 100);
     lua["app_data"] = &data;
@@ -145,7 +154,7 @@ TEST_F(WorkerUtilsTest, OnBlockCompleteCallbackCalledPerBlock) {
             {x = 5, y = 0, w = 5, h = 5},
             {x = 0, y = 5, w = 5, h = 5}
         }
-        BlockUtils.setup_shared_queue(app_data, blocks, "test_obc_queue", "test_obc_idx")
+        BlockUtils.setup_shared_queue(app_data, blocks, "test_obc_queue")
         
         pixel_count = 0
         block_complete_count = 0
@@ -163,7 +172,7 @@ TEST_F(WorkerUtilsTest, OnBlockCompleteCallbackCalledPerBlock) {
             block_complete_count = block_complete_count + 1
         end
         
-        WorkerUtils.process_blocks(app_data, "test_obc_queue", "test_obc_idx", process_callback, check_cancel, app, on_block_complete)
+        WorkerUtils.process_blocks(app_data, "test_obc_queue", 0, process_callback, check_cancel, app, on_block_complete)
     )");
     
     int pixel_count = lua["pixel_count"];
@@ -173,3 +182,235 @@ TEST_F(WorkerUtilsTest, OnBlockCompleteCallbackCalledPerBlock) {
     // 3ブロック完了コールバック
     ASSERT_EQ(block_complete_count, 3);
 }
+
+// 多段解像度パス: 各ピクセルは一度だけ処理され、粗いレベルのスプラットで画面全体が埋まる
+TEST_F(WorkerUtilsTest, ProgressiveLevelsShadeEachPixelOnce) {
+    auto mock_type = lua.new_usertype<AppData>("MockAppData",
+        "set_pixel", &AppData::set_pixel,
+        "set_splat_size", [](AppData&, int size) { AppData::set_splat_size(size); }
+    );
+    bind_shared_store(lua, mock_type);
+    bind_tile_scheduler(lua, mock_type);
+
+    AppData data(21, 13);
+    lua["app_data"] = &data;
+
+    sol::table app = lua.create_table();
+    app.set_function("get_ticks", []() { return 0; });
+    lua["app"] = app;
+
+    lua.script(R"(
+        local WorkerUtils = require("workers.worker_utils")
+        local BlockUtils = require("lib.BlockUtils")
+
+        local blocks = BlockUtils.generate_blocks(21, 13, 10, 1)
+        BlockUtils.setup_progressive_queue(app_data, blocks, "test_progressive", 1, {8, 4, 2, 1})
+
+        counts = {}
+        pixel_count = 0
+        first_level_count = 0
+
+        local function process_callback(app_data, x, y)
+            local key = y * 21 + x
+            counts[key] = (counts[key] or 0) + 1
+            pixel_count = pixel_count + 1
+            app_data:set_pixel(x, y, 255, 255, 255)
+            -- 最初のレベル（6点）は x, y が8の倍数の格子点だけ
+            if pixel_count <= 6 and x % 8 == 0 and y % 8 == 0 then
+                first_level_count = first_level_count + 1
+            end
+        end
+
+        WorkerUtils.process_blocks(app_data, "test_progressive", 0, process_callback, function() return false end, app)
+
+        duplicates = 0
+        for _, count in pairs(counts) do
+            if count ~= 1 then
+                duplicates = duplicates + 1
+            end
+        end
+    )");
+
+    EXPECT_EQ(lua["pixel_count"].get<int>(), 21 * 13);
+    EXPECT_EQ(lua["duplicates"].get<int>(), 0);
+    EXPECT_EQ(lua["first_level_count"].get<int>(), 3 * 2);
+    // 処理後はスプラットサイズが元に戻る
+    EXPECT_EQ(AppData::splat_size(), 1);
+}
+
+// エラーで中断したワーカーが取得したまま完了を報告しないタイルがあっても、
+// そのワーカーがキューを打ち切れば（ray_worker の abort_tiles）他のワーカーはレベル間の待ち合わせから抜ける
+TEST_F(WorkerUtilsTest, LevelBarrierEndsWhenTilesAreAborted) {
+    auto mock_type = lua.new_usertype<AppData>("MockAppData",
+        "set_pixel", &AppData::set_pixel,
+        "set_splat_size", [](AppData&, int size) { AppData::set_splat_size(size); }
+    );
+    bind_shared_store(lua, mock_type);
+    bind_tile_scheduler(lua, mock_type);
+
+    AppData data(16, 8);
+    lua["app_data"] = &data;
+
+    lua.script(R"(
+        local BlockUtils = require("lib.BlockUtils")
+        local blocks = BlockUtils.generate_blocks(16, 8, 8, 1)
+        BlockUtils.setup_progressive_queue(app_data, blocks, "test_abort", 1, {2, 1})
+        -- 中断したワーカーが最初のレベルのタイルを1つ取得したままにする
+        assert(app_data:tile_queue(BlockUtils.level_queue_key("test_abort", 2)):next_tile(0))
+    )");
+
+    std::thread failed_worker([&data]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        data.abort_tiles();
+    });
+    auto result = lua.safe_script(R"(
+        local WorkerUtils = require("workers.worker_utils")
+        WorkerUtils.process_blocks(app_data, "test_abort", 0, function() end, function() return false end)
+        returned = true
+    )");
+    failed_worker.join();
+
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+    EXPECT_TRUE(lua["returned"].get<bool>());
+    EXPECT_EQ(AppData::splat_size(), 1);
+}
+
+// 依存するレンダリングタイルのワーカーがエラーで中断しても、キューが打ち切られれば
+// process_dependent_tiles（wait = true）は待ち続けずに戻る
+TEST_F(WorkerUtilsTest, DependentTilesWaitEndsWhenTilesAreAborted) {
+    auto mock_type = lua.new_usertype<AppData>("MockAppData",
+        "set_pixel", &AppData::set_pixel
+    );
+    bind_shared_store(lua, mock_type);
+    bind_tile_scheduler(lua, mock_type);
+
+    AppData data(16, 8);
+    lua["app_data"] = &data;
+
+    lua.script(R"(
+        -- PostEffectタイルは完了が報告されないレンダリングタイルに依存する
+        app_data:setup_dependent_tiles("test_pipeline", {0, 0, 16, 8}, {0, 0, 16, 8}, 1)
+    )");
+
+    std::thread failed_worker([&data]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        data.abort_tiles();
+    });
+    auto result = lua.safe_script(R"(
+        local WorkerUtils = require("workers.worker_utils")
+        local queue = app_data:dependent_tiles("test_pipeline")
+        post_count = 0
+        WorkerUtils.process_dependent_tiles(app_data, queue, function() post_count = post_count + 1 end,
+                                            function() return false end, true)
+        returned = true
+    )");
+    failed_worker.join();
+
+    ASSERT_TRUE(result.valid()) << ((sol::error)result).what();
+    EXPECT_TRUE(lua["returned"].get<bool>());
+    EXPECT_EQ(lua["post_count"].get<int>(), 0);
+}
+
+// span_callback を指定すると行ごとに1回だけ呼ばれ、多段解像度パスでも各ピクセルを一度だけ処理する
+// {8, 4, 2, 1} は prev_step 間隔の1スパン、{4, 1} は処理済みの格子点の間ごとのスパンになる
+TEST_F(WorkerUtilsTest, SpanCallbackShadesEachPixelOnce) {
+    auto mock_type = lua.new_usertype<AppData>("MockAppData",
+        "set_splat_size", [](AppData&, int size) { AppData::set_splat_size(size); }
+    );
+    bind_shared_store(lua, mock_type);
+    bind_tile_scheduler(lua, mock_type);
+
+    AppData data(21, 13);
+    lua["app_data"] = &data;
+
+    lua.script(R"(
+        local WorkerUtils = require("workers.worker_utils")
+        local BlockUtils = require("lib.BlockUtils")
+
+        local function run(queue_name, levels)
+            local blocks = BlockUtils.generate_blocks(21, 13, 10, 1)
+            if levels then
+                BlockUtils.setup_progressive_queue(app_data, blocks, queue_name, 1, levels)
+            else
+                BlockUtils.setup_shared_queue(app_data, blocks, queue_name)
+            end
+
+            local counts = {}
+            local result = { pixels = 0, spans = 0, duplicates = 0, pixel_calls = 0 }
+            local function span_callback(_, x0, x1, y, step)
+                result.spans = result.spans + 1
+                for x = x0, x1, step do
+                    local key = y * 21 + x
+                    counts[key] = (counts[key] or 0) + 1
+                    result.pixels = result.pixels + 1
+                end
+            end
+            local function process_callback()
+                result.pixel_calls = result.pixel_calls + 1
+            end
+
+            WorkerUtils.process_blocks(app_data, queue_name, 0, process_callback, function() return false end,
+                nil, nil, span_callback)
+            for _, count in pairs(counts) do
+                if count ~= 1 then
+                    result.duplicates = result.duplicates + 1
+                end
+            end
+            return result
+        end
+
+        single = run("test_span_single", nil)
+        halving = run("test_span_halving", {8, 4, 2, 1})
+        skipping = run("test_span_skipping", {4, 1})
+    )");
+
+    for (const char* name : {"single", "halving", "skipping"}) {
+        sol::table result = lua[name];
+        EXPECT_EQ(result["pixels"].get<int>(), 21 * 13) << name;
+        EXPECT_EQ(result["duplicates"].get<int>(), 0) << name;
+        EXPECT_EQ(result["pixel_calls"].get<int>(), 0) << name;
+    }
+    // 1パスでは行×ブロック列ごとに1回（13行 × 3ブロック列）
+    EXPECT_EQ(lua["single"]["spans"].get<int>(), 13 * 3);
+    EXPECT_LT(lua["halving"]["spans"].get<int>(), 21 * 13 / 2);
+    EXPECT_EQ(AppData::splat_size(), 1);
+}
+
+// time_source を省略した場合は時間計測を行わず、キャンセル確認は行ごとに1回だけ
+TEST_F(WorkerUtilsTest, WithoutTimeSourceChecksCancelOncePerRow) {
+    auto mock_type = lua.new_usertype<AppData>("MockAppData",
+        "set_string", &AppData::set_string
+    );
+    bind_shared_store(lua, mock_type);
+    bind_tile_scheduler(lua, mock_type);
+
+    AppData data(100, 100);
+    lua["app_data"] = &data;
+    // get_ticks が呼ばれたらエラーになるよう app は定義しない
+    lua["app"] = sol::lua_nil;
+
+    lua.script(R"(
+        local WorkerUtils = require("workers.worker_utils")
+        local BlockUtils = require("lib.BlockUtils")
+
+        BlockUtils.setup_shared_queue(app_data, {{x = 0, y = 0, w = 8, h = 6}}, "test_row_queue")
+
+        pixel_count = 0
+        check_count = 0
+
+        local function process_callback(app_data, x, y)
+            pixel_count = pixel_count + 1
+        end
+
+        -- 4行目の開始時にキャンセルする
+        local function check_cancel()
+            check_count = check_count + 1
+            return check_count > 3
+        end
+
+        WorkerUtils.process_blocks(app_data, "test_row_queue", 0, process_callback, check_cancel)
+    )");
+
+    EXPECT_EQ(lua["pixel_count"].get<int>(), 3 * 8);
+    EXPECT_EQ(lua["check_count"].get<int>(), 4);
+}
@@ -1,7 +1,7 @@
 -- workers/posteffect_worker.lua
 -- ThreadWorker executes this script
 
--- _app_data, _bounds, _scene_type, _thread_id are injected by C++
+-- _app_data, _bounds, _scene_type, _thread_id (and _gc_step when enabled) are injected by C++
 
 local WorkerUtils = require("workers.worker_utils")
 local scene_module = require("scenes." .. _scene_type)
@@ -11,18 +11,27 @@ local function process_callback(app_data, x, y)
     scene_module.post_effect(app_data, x, y)
 end
 
--- キャンセルチェック関数
-local function check_cancel()
-    return _is_cancel_requested()
+-- キャンセルチェック関数（行ごとに呼ばれる。キャンセル要求と古いレンダー世代をアトミックロードで確認する）
+local check_cancel = _is_cancel_requested
+
+-- タイル境界でGCを進める設定の場合のみC++から注入される（ThreadWorker の tile_step_kb）
+local on_block_complete = nil
+if _gc_step then
+    local gc_step = _gc_step
+    on_block_complete = function()
+        gc_step()
+    end
 end
 
 -- 処理実行
 local status, err = pcall(function()
-    WorkerUtils.process_blocks(_app_data, "posteffect_queue", "posteffect_queue_idx", process_callback, check_cancel)
+    WorkerUtils.process_blocks(_app_data, "posteffect_queue", _thread_id, process_callback, check_cancel, nil, on_block_complete)
 end)
 
 if not status then
     print("PostEffect Worker Error: " .. tostring(err))
+    -- このワーカーが取得したまま完了を報告しないタイルを他のワーカーが待ち続けないよう、キューを打ち切る
+    _app_data:abort_tiles()
 end
 
 -- シーン終了処理
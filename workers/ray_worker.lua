@@ -1,7 +1,7 @@
 -- workers/ray_worker.lua
 -- ThreadWorker executes this script
 
--- _app_data, _scene, _bounds, _scene_type, _thread_id are injected by C++
+-- _app_data, _scene, _bounds, _scene_type, _thread_id (and _gc_step when enabled) are injected by C++
 
 local WorkerUtils = require("workers.worker_utils")
 local scene_module = require("scenes." .. _scene_type)
@@ -18,18 +18,48 @@ local function process_callback(app_data, x, y)
     scene_module.shade(app_data, x, y)
 end
 
--- キャンセルチェック関数
-local function check_cancel()
-    return _is_cancel_requested()
+-- シーンが shade_span を持つ場合は1行分のスパンを1回の呼び出しで処理する（shade はフォールバック）
+local span_callback = scene_module.shade_span
+
+-- キャンセルチェック関数（行ごとに呼ばれる。キャンセル要求と古いレンダー世代をアトミックロードで確認する）
+local check_cancel = _is_cancel_requested
+
+-- パイプラインPostEffect: レンダリングタイルの完了を報告し、依存が揃ったPostEffectタイルを同じワーカーで処理する
+local pipeline = scene_module.post_effect and _app_data:dependent_tiles("post_pipeline")
+
+local function post_callback(app_data, x, y)
+    scene_module.post_effect(app_data, x, y)
+end
+
+-- タイル境界でGCを進める設定の場合のみC++から注入される（ThreadWorker の tile_step_kb）
+local gc_step = _gc_step
+
+local on_block_complete = nil
+if pipeline or gc_step then
+    on_block_complete = function(x, y, _, _, final)
+        if pipeline and final then
+            pipeline:complete_render_tile(x, y)
+            WorkerUtils.process_dependent_tiles(_app_data, pipeline, post_callback, check_cancel, false)
+        end
+        if gc_step then
+            gc_step()
+        end
+    end
 end
 
 -- 処理実行
 local status, err = pcall(function()
-    WorkerUtils.process_blocks(_app_data, "render_queue", "render_queue_idx", process_callback, check_cancel)
+    WorkerUtils.process_blocks(_app_data, "render_queue", _thread_id, process_callback, check_cancel, nil, on_block_complete, span_callback)
+    if pipeline then
+        -- 残りのPostEffectタイルは依存するレンダリングタイルの完了を待ちながら処理する
+        WorkerUtils.process_dependent_tiles(_app_data, pipeline, post_callback, check_cancel, true)
+    end
 end)
 
 if not status then
     print("Worker Error: " .. tostring(err))
+    -- このワーカーが取得したまま完了を報告しないタイルを他のワーカーが待ち続けないよう、キューを打ち切る
+    _app_data:abort_tiles()
 end
 
 -- シーン終了処理
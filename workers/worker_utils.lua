@@ -1,46 +1,89 @@
 -- workers/worker_utils.lua
 
 local BlockUtils = require("lib.BlockUtils")
+local FastPath = require("lib.FastPath")
 
 local WorkerUtils = {}
 
--- 共通のブロック処理ループ
--- @param app_data AppDataインスタンス
--- @param queue_key キューのキー名
--- @param index_key インデックスのキー名
--- @param process_callback (app_data, x, y) -> void
--- @param check_cancel_callback () -> boolean キャンセルチェック用コールバック
--- @param time_source table|nil 時間計測用オブジェクト (get_ticksメソッドを持つ)。nilの場合はglobal 'app'を使用
-function WorkerUtils.process_blocks(app_data, queue_key, index_key, process_callback, check_cancel_callback, time_source, on_block_complete)
-    local timer = time_source or app
-    
-    -- 動的キャンセルチェック用の変数
-    local time_avg = BlockUtils.MovingAverage.new(0.1) -- alpha=0.1 (指数移動平均)
-    local CHECK_INTERVAL_MS = 12 -- 12ms間隔でキャンセルチェック
-    local estimated_time = 0
+-- レベル完了待ちのタイムアウト（待機中はスリープし、この間隔でキャンセルを確認する）
+-- ラッチの完了とキューの打ち切り（世代の更新・エラーによる中断）では待機中のワーカーがすぐに起こされる
+WorkerUtils.LEVEL_WAIT_MS = 10
 
-    while true do
-        -- 次のブロックを取得
-        local block = BlockUtils.pull_next_block(app_data, queue_key, index_key)
-        
-        -- ブロックが無ければ終了
-        if not block then
-            break
+-- 処理済みの格子点（x が prev_step の倍数）を除いた1行分をスパンとして渡す
+-- prev_step == 2 * step（既定のプログレッシブレベル）なら残りは prev_step 間隔の1スパン、それ以外は格子点の間ごとに分ける
+local function shade_row_remaining(app_data, x_start, x_end, y, step, prev_step, span_callback)
+    if prev_step == 2 * step then
+        local x0 = x_start % prev_step == 0 and x_start + step or x_start
+        if x0 <= x_end then
+            span_callback(app_data, x0, x_end, y, prev_step)
+        end
+        return
+    end
+    local x0 = nil
+    for x = x_start, x_end, step do
+        if x % prev_step == 0 then
+            if x0 then
+                span_callback(app_data, x0, x - step, y, step)
+                x0 = nil
+            end
+        elseif not x0 then
+            x0 = x
         end
+    end
+    if x0 then
+        span_callback(app_data, x0, x_end, y, step)
+    end
+end
 
-        local x_start = block.x
-        local x_end = block.x + block.w - 1
-        local y_start = block.y
-        local y_end = block.y + block.h - 1
-        
-        for y = y_start, y_end do
-            for x = x_start, x_end do
+-- 1ブロック内の格子点を処理する（行ごとにキャンセルを確認、ピクセル単位の計測なし）
+-- check_cancel_callback はネイティブのフラグ確認のような軽い関数を想定する
+-- span_callback が指定された場合は行（スパン）ごとに1回だけ呼び、process_callback は使わない
+-- @return キャンセルされた場合 false
+local function shade_rows(app_data, x_start, x_end, y_start, y_end, step, prev_step, process_callback, check_cancel_callback, span_callback)
+    for y = y_start, y_end, step do
+        if check_cancel_callback() then
+            return false
+        end
+        if prev_step and y % prev_step == 0 then
+            if span_callback then
+                shade_row_remaining(app_data, x_start, x_end, y, step, prev_step, span_callback)
+            else
+                for x = x_start, x_end, step do
+                    if x % prev_step ~= 0 then
+                        process_callback(app_data, x, y)
+                    end
+                end
+            end
+        elseif span_callback then
+            if x_start <= x_end then
+                span_callback(app_data, x_start, x_end, y, step)
+            end
+        else
+            for x = x_start, x_end, step do
+                process_callback(app_data, x, y)
+            end
+        end
+    end
+    return true
+end
+
+-- 1ブロック内の格子点を処理する（ピクセルの処理時間の移動平均から間隔を決めてキャンセルを確認）
+-- コルーチンのように check_cancel_callback 自体が重い（yieldする）場合の時間分割用
+-- @return キャンセルされた場合 false
+local function shade_timed(app_data, x_start, x_end, y_start, y_end, step, prev_step, process_callback, check_cancel_callback, timing)
+    local timer = timing.timer
+    local time_avg = timing.time_avg
+
+    for y = y_start, y_end, step do
+        local row_done = prev_step and (y % prev_step == 0)
+        for x = x_start, x_end, step do
+            if not (row_done and x % prev_step == 0) then
                 -- キャンセルチェック（移動平均に基づく間隔）
-                if estimated_time >= CHECK_INTERVAL_MS then
+                if timing.estimated_time >= timing.CHECK_INTERVAL_MS then
                     if check_cancel_callback() then
-                        return
+                        return false
                     end
-                    estimated_time = 0
+                    timing.estimated_time = 0
                 end
                 
                 -- ピクセル処理開始時刻
@@ -56,15 +99,177 @@ function WorkerUtils.process_blocks(app_data, queue_key, index_key, process_call
                 time_avg:update(elapsed)
                 
                 -- 推定時間を更新
-                estimated_time = estimated_time + time_avg:get()
+                timing.estimated_time = timing.estimated_time + time_avg:get()
             end
         end
+    end
+    return true
+end
+
+-- [lo, hi] に含まれる step の倍数の個数
+local function grid_count(lo, hi, step)
+    local count = hi // step - (lo + step - 1) // step + 1
+    return count > 0 and count or 0
+end
+
+-- ブロック内で今回のレベルが処理するピクセル数（前のレベルで処理済みの格子点を除く）
+local function level_pixel_count(bx, by, bw, bh, step, prev_step)
+    local x_end, y_end = bx + bw - 1, by + bh - 1
+    local count = grid_count(bx, x_end, step) * grid_count(by, y_end, step)
+    if prev_step then
+        count = count - grid_count(bx, x_end, prev_step) * grid_count(by, y_end, prev_step)
+    end
+    return count
+end
+
+-- 1つのキューのブロックを処理するループ
+-- step 間隔の格子点（x, y が step の倍数）だけを処理し、prev_step の格子点は処理済みとしてスキップする
+-- timing が nil の場合は行単位、指定された場合は時間ベースでキャンセルを確認する
+-- @return キャンセルされた場合 false
+-- on_block_complete には (x, y, w, h, final) を渡す（final はそのブロックの最終パスか）
+-- stats が指定された場合はブロックごとに処理したピクセル数を報告する
+-- span_callback は行単位のキャンセル確認（timing が nil）の場合のみ使う（時間ベースではピクセルごとに計測するため）
+-- latch が指定された場合はブロックごとにカウントダウンする（多段解像度パスのレベル間の待ち合わせ用）
+local function run_queue(app_data, tiles, queue_index, step, prev_step, process_callback, check_cancel_callback, timing, on_block_complete, final, stats, span_callback, latch)
+    while true do
+        -- 次のブロックを取得
+        local bx, by, bw, bh = tiles:next_tile(queue_index)
+        
+        -- ブロックが無い（またはキューが古い世代として打ち切られた）場合は終了
+        if not bx then
+            break
+        end
+
+        -- ブロック内で最初の格子点（画面全体で揃えるため絶対座標で切り上げる）
+        local x_start = math.ceil(bx / step) * step
+        local x_end = bx + bw - 1
+        local y_start = math.ceil(by / step) * step
+        local y_end = by + bh - 1
+
+        local completed
+        if timing then
+            completed = shade_timed(app_data, x_start, x_end, y_start, y_end, step, prev_step, process_callback, check_cancel_callback, timing)
+        else
+            completed = shade_rows(app_data, x_start, x_end, y_start, y_end, step, prev_step, process_callback, check_cancel_callback, span_callback)
+        end
+        if not completed then
+            return false
+        end
+
+        tiles:complete_tile()
+        if latch then
+            app_data:latch_count_down(latch)
+        end
+        if stats then
+            stats:record_tile(queue_index, level_pixel_count(bx, by, bw, bh, step, prev_step))
+        end
         
         -- ブロック完了コールバック
         if on_block_complete then
-            on_block_complete()
+            on_block_complete(bx, by, bw, bh, final)
+        end
+    end
+    return true
+end
+
+-- 共通のブロック処理ループ
+-- キューが BlockUtils.setup_progressive_queue で多段解像度としてセットアップされている場合は、
+-- 粗いレベルから順に処理し、各レベルの格子点を step×step のブロックにスプラットする
+-- @param app_data AppDataインスタンス
+-- @param queue_key キューの名前
+-- @param queue_index ワーカーのキュー番号（自分のキューが空になると他のキューから盗む）
+-- @param process_callback (app_data, x, y) -> void
+-- @param check_cancel_callback () -> boolean キャンセルチェック用コールバック
+-- @param time_source table|nil 時間計測用オブジェクト (get_ticksメソッドを持つ)
+--        指定した場合はピクセルの処理時間から12ms間隔でキャンセルを確認する（コルーチンの時間分割用）
+--        nilの場合は計測を行わず、行ごとに check_cancel_callback を呼ぶ（ワーカースレッド用）
+-- @param on_block_complete function|nil ブロック完了ごとに (x, y, w, h, final) で呼ばれるコールバック
+--        final は多段解像度パスの最終レベル（通常のキューでは常に true）
+-- @param span_callback function|nil (app_data, x0, x1, y, step) -> void
+--        指定した場合は1行分の格子点（x0, x0 + step, ... <= x1）をまとめて1回の呼び出しで処理する（シーンの shade_span）
+--        time_source を指定した場合は使わず、process_callback をピクセルごとに呼ぶ
+function WorkerUtils.process_blocks(app_data, queue_key, queue_index, process_callback, check_cancel_callback, time_source, on_block_complete, span_callback)
+    -- 動的キャンセルチェック用の状態（レベルをまたいで引き継ぐ）
+    local timing = nil
+    if time_source then
+        timing = {
+            timer = time_source,
+            time_avg = BlockUtils.MovingAverage.new(0.1), -- alpha=0.1 (指数移動平均)
+            CHECK_INTERVAL_MS = 12, -- 12ms間隔でキャンセルチェック
+            estimated_time = 0,
+        }
+    end
+
+    -- 進捗・スループット統計（RayTracer が app_data:setup_render_stats で登録したキューのみ）
+    local stats = app_data:render_stats(queue_key)
+    if stats then
+        -- このジョブより前にスレッドが撃ったレイを数えないよう基準を取る
+        stats:begin(queue_index)
+    end
+
+    local levels = app_data:store_get(FastPath.store_slot(app_data, BlockUtils.levels_key(queue_key)))
+    if not levels then
+        -- タイルスケジューラはループ前に一度だけ取得する
+        local tiles = app_data:tile_queue(queue_key)
+        if tiles then
+            run_queue(app_data, tiles, queue_index, 1, nil, process_callback, check_cancel_callback, timing, on_block_complete, true, stats, span_callback)
+        end
+        return
+    end
+
+    local prev_step = nil
+    for i = 1, #levels do
+        local step = levels[i]
+        local level_key = BlockUtils.level_queue_key(queue_key, step)
+        local tiles = app_data:tile_queue(level_key)
+        if not tiles then
+            break
+        end
+
+        -- レベルのラッチはスロット番号を一度だけ引き、以降はロックフリーに操作する
+        local latch = app_data:latch_slot(level_key)
+
+        app_data:set_splat_size(step)
+        local completed = run_queue(app_data, tiles, queue_index, step, prev_step, process_callback, check_cancel_callback, timing, on_block_complete, i == #levels, stats, span_callback, latch)
+
+        -- 粗いスプラットが細かいレベルの結果を上書きしないよう、全ワーカーがレベルを終えるまでラッチで待つ
+        while completed and not app_data:latch_wait(latch, WorkerUtils.LEVEL_WAIT_MS) do
+            if tiles:retired() or check_cancel_callback() then
+                completed = false
+            end
+        end
+        app_data:set_splat_size(1)
+
+        if not completed then
+            return
+        end
+        prev_step = step
+    end
+end
+
+-- 依存関係付きキューから取得可能なPostEffectタイルを処理する
+-- パイプラインPostEffectモード（バックバッファから読み、SPAREバッファに書く）で process_callback を呼ぶ
+-- @param app_data AppDataインスタンス
+-- @param queue app_data:dependent_tiles(name) で取得したキュー
+-- @param process_callback (app_data, x, y) -> void
+-- @param check_cancel_callback () -> boolean 行ごとに呼ばれるキャンセルチェック
+-- @param wait boolean true の場合は全タイルが取得済みになるまで待ちながら処理し、false の場合は今取得できる分だけ処理する
+-- @return キャンセルされた場合 false
+function WorkerUtils.process_dependent_tiles(app_data, queue, process_callback, check_cancel_callback, wait)
+    app_data:set_post_pass(true)
+    local completed = true
+    while completed do
+        local bx, by, bw, bh = queue:next_tile()
+        if bx then
+            completed = shade_rows(app_data, bx, bx + bw - 1, by, by + bh - 1, 1, nil, process_callback, check_cancel_callback)
+        elseif not wait or queue:finished() then
+            break
+        elseif not queue:wait_ready(WorkerUtils.LEVEL_WAIT_MS) and check_cancel_callback() then
+            completed = false
         end
     end
+    app_data:set_post_pass(false)
+    return completed
 end
 
 return WorkerUtils